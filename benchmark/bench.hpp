@@ -0,0 +1,86 @@
+#ifndef __BENCH_HPP__
+#define __BENCH_HPP__
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <new>
+#include <string>
+#include <vector>
+#include "utils.hpp"
+
+// Every heap allocation of the process is counted, include this header in exactly one
+// translation unit of a benchmark executable.
+std::atomic<uint64_t> allocation_count(0);
+
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"  // the replacements below pair malloc/free
+
+void* operator new(size_t size) {
+    allocation_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* p = std::malloc(size ? size : 1))
+        return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete[](void* p) noexcept { std::free(p); }
+void operator delete(void* p, size_t) noexcept { std::free(p); }
+void operator delete[](void* p, size_t) noexcept { std::free(p); }
+
+inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+struct BenchResult {
+    std::string name;
+    size_t depth;
+    double mean, p50, p90, p99;  // ns/op
+    double allocations;          // allocations/op
+};
+
+// Runs `rounds` rounds (after `warmup` untimed ones) of: `setup()` untimed, then `ops` calls of
+// `op(i)` timed as a whole. Individual ops are not timed, a clock read costs about as much as the
+// cheapest of them: the percentiles are over the rounds, of the mean time per op of each round.
+template <typename Setup, typename Op>
+BenchResult measure(const std::string& name, size_t depth, size_t ops, size_t rounds, size_t warmup, Setup setup, Op op) {
+    std::vector<double> samples;
+    uint64_t total_ns = 0, total_allocations = 0;
+    for (size_t round = 0; round < warmup + rounds; ++round) {
+        setup();
+        uint64_t allocations = allocation_count.load(std::memory_order_relaxed);
+        uint64_t start = now_ns();
+        for (size_t i = 0; i < ops; ++i)
+            op(i);
+        uint64_t elapsed = now_ns() - start;
+        allocations = allocation_count.load(std::memory_order_relaxed) - allocations;
+        if (round < warmup)
+            continue;
+        samples.push_back((double)elapsed / ops);
+        total_ns += elapsed;
+        total_allocations += allocations;
+    }
+    std::sort(samples.begin(), samples.end());
+    auto percentile = [&](double q) { return samples[std::min(samples.size() - 1, (size_t)(q * samples.size()))]; };
+    return {name, depth, (double)total_ns / (ops * rounds), percentile(0.5), percentile(0.9), percentile(0.99), (double)total_allocations / (ops * rounds)};
+}
+
+inline std::string format(double value, int precision = 1) {
+    char buffer[32];
+    snprintf(buffer, sizeof(buffer), "%.*f", precision, value);
+    return buffer;
+}
+
+inline void report(const std::vector<BenchResult>& results, std::ostream& os = std::cout) {
+    auto table = Table<std::string, size_t, std::string, std::string, std::string, std::string, std::string>(
+        {"Benchmark", "Depth", "Mean ns/op", "P50 ns/op", "P90 ns/op", "P99 ns/op", "Allocs/op"}, 22);
+    for (auto& result : results)
+        table.add_row(result.name, result.depth, format(result.mean), format(result.p50), format(result.p90), format(result.p99), format(result.allocations, 3));
+    table.print(os);
+}
+
+#endif  // __BENCH_HPP__
@@ -0,0 +1,173 @@
+// Microbenchmarks of the core book operations at several book depths.
+//
+//   flob_bench_micro [depth ...]      (default depths: 10 100 1000 10000)
+//
+// Depth is the number of price levels on each side, every level holds 4 orders of 100 shares.
+
+#include <cassert>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "bench.hpp"
+#include "limit_order_book.hpp"
+
+typedef LimitOrderBook<AShare> Book;
+
+const uint64_t mid = 100000;  // 1000.00
+const uint64_t level_orders = 4, order_quantity = 100;
+const uint64_t timestamp = 1664529300000000000UL;
+
+// `depth` bid levels below and `depth` ask levels above `mid`, returns the next free uid
+uint64_t fill(Book& book, size_t depth, uint64_t uid = 1) {
+    for (size_t i = 0; i < depth; ++i) {
+        for (size_t j = 0; j < level_orders; ++j) {
+            book.write(Quote(uid++, mid - 1 - i, order_quantity, timestamp, Side::Bid, QuoteType::LimitOrder));
+            book.write(Quote(uid++, mid + 1 + i, order_quantity, timestamp, Side::Ask, QuoteType::LimitOrder));
+        }
+    }
+    return uid;
+}
+
+size_t rounds_for(size_t depth) { return std::max<size_t>(20, 20000 / depth); }
+
+void bench_treap(size_t depth, std::vector<BenchResult>& results) {
+    MonotonicArena arena;
+    ObjectPool<Node<Limit>> node_pool(arena);
+    Treap<Limit> treap(node_pool);
+    std::vector<Limit*> limits, extra;
+    for (size_t i = 0; i < depth; ++i)
+        limits.push_back(arena.create<Limit>(2 * i, Side::Bid));
+    for (size_t i = 0; i < depth; ++i)
+        extra.push_back(arena.create<Limit>(2 * ((i * 7919) % depth) + 1, Side::Bid));
+    for (auto limit : limits)
+        treap.insert(limit);
+
+    const size_t ops = 256, rounds = 200;
+    results.push_back(measure("treap_insert_remove", depth, ops, rounds, 20, [] {}, [&](size_t i) {
+        Limit* limit = extra[i % depth];
+        treap.insert(limit);
+        treap.remove(*limit);
+    }));
+    results.push_back(measure("treap_kth", depth, ops, rounds, 20, [] {}, [&](size_t i) {
+        volatile auto node = treap.kth_smallest((i * 7919) % depth + 1);
+        (void)node;
+    }));
+}
+
+void bench_list(size_t depth, std::vector<BenchResult>& results) {
+    MonotonicArena arena;
+    ObjectPool<ListNode<uint64_t>> pool(arena);
+    DoubleLinkedList<uint64_t> list(pool);
+    for (size_t i = 0; i < depth; ++i)
+        list.push_back(i);
+    results.push_back(measure("list_push_pop", depth, 256, 200, 20, [] {}, [&](size_t i) {
+        list.push_back(i);
+        volatile uint64_t value = list.pop_front();
+        (void)value;
+    }));
+}
+
+void bench_book(size_t depth, std::vector<BenchResult>& results) {
+    Book book(0, 10);
+    uint64_t uid = 0;
+    const size_t ops = 256, rounds = rounds_for(depth), warmup = rounds / 10 + 1;
+    auto reset = [&] {
+        book.clear();
+        uid = fill(book, depth);
+    };
+
+    results.push_back(measure("limit_existing_level", depth, ops, rounds, warmup, reset, [&](size_t i) {
+        book.write(Quote(uid++, mid - 1 - i % depth, order_quantity, timestamp, Side::Bid, QuoteType::LimitOrder));
+    }));
+    results.push_back(measure("limit_new_level", depth, ops, rounds, warmup, reset, [&](size_t i) {
+        book.write(Quote(uid++, mid - 1 - depth - i, order_quantity, timestamp, Side::Bid, QuoteType::LimitOrder));
+    }));
+
+    // cancel orders queued behind the resting ones, the levels survive
+    uint64_t first = 0;
+    results.push_back(measure("cancel", depth, ops, rounds, warmup, [&] {
+        reset();
+        first = uid;
+        for (size_t i = 0; i < ops; ++i)
+            book.write(Quote(uid++, mid - 1 - i % depth, order_quantity, timestamp, Side::Bid, QuoteType::LimitOrder));
+    }, [&](size_t i) {
+        book.write(Quote(first + i, 0, order_quantity, timestamp, Side::Bid, QuoteType::CancelOrder));
+    }));
+
+    // A sweep or an auction consumes the book, so one round runs a batch of them on as many books
+    // prepared alike. Deep books take long enough per op to be timed one at a time.
+    const size_t batch = std::max<size_t>(1, std::min<size_t>(16, 10000 / depth));
+    std::vector<std::unique_ptr<Book>> books;
+    for (size_t i = 0; i < batch; ++i)
+        books.emplace_back(new Book(0, 10));
+
+    // an aggressive bid sweeping the best 10 ask levels
+    size_t sweep = std::min<size_t>(10, depth);
+    results.push_back(measure("match_sweep_10", depth, batch, rounds, warmup, [&] {
+        for (auto& b : books) {
+            b->clear();
+            uid = fill(*b, depth);
+        }
+    }, [&](size_t i) {
+        books[i]->write(Quote(uid++, mid + sweep, sweep * level_orders * order_quantity, timestamp, Side::Bid, QuoteType::LimitOrder));
+    }));
+
+    // bids and asks overlapping over the whole depth
+    results.push_back(measure("match_call_auction", depth, batch, rounds, warmup, [&] {
+        for (auto& b : books) {
+            b->clear();
+            b->set_status(TradingStatus::CallAuction);
+            uid = 1;
+            for (size_t i = 0; i < depth; ++i) {
+                b->write(Quote(uid++, mid + depth / 2 - i, order_quantity * level_orders, timestamp, Side::Bid, QuoteType::LimitOrder));
+                b->write(Quote(uid++, mid - depth / 2 + i, order_quantity * level_orders, timestamp, Side::Ask, QuoteType::LimitOrder));
+            }
+        }
+    }, [&](size_t i) { books[i]->match_call_auction(); }));
+    books.clear();
+
+    results.push_back(measure("snapshot_top10", depth, ops, rounds, warmup, reset, [&](size_t i) {
+        book.snapshot(timestamp + i);
+    }));
+}
+
+void bench_load(size_t depth, std::vector<BenchResult>& results) {
+    std::string filename = "flob_bench_" + std::to_string(depth) + ".csv";
+    size_t quotes = std::max<size_t>(depth * level_orders * 2, 10000);
+    {
+        std::ofstream file(filename);
+        file << "timestamp,uid,price,quantity,side,type\n";
+        for (size_t i = 0; i < quotes; ++i) {
+            Side side = i % 2 ? Side::Ask : Side::Bid;
+            uint64_t price = side == Side::Bid ? mid - 1 - (i / 2) % depth : mid + 1 + (i / 2) % depth;
+            file << timestamp + i << "," << i + 1 << "," << price / 100 << "." << (price % 100 < 10 ? "0" : "") << price % 100
+                 << "," << order_quantity << "," << (int)side << ",0\n";
+        }
+    }
+    Book book;
+    auto buffer = std::cout.rdbuf(nullptr);  // load() reports progress on stdout
+    auto result = measure("load", depth, 1, std::max<size_t>(10, rounds_for(depth) / 10), 2, [&] { book.clear(); }, [&](size_t i) { book.load(filename); });
+    std::cout.rdbuf(buffer);
+    std::remove(filename.c_str());
+    for (double* value : {&result.mean, &result.p50, &result.p90, &result.p99, &result.allocations})
+        *value /= quotes;  // per quote
+    results.push_back(result);
+}
+
+int main(int argc, char** argv) {
+    std::vector<size_t> depths;
+    for (int i = 1; i < argc; ++i)
+        depths.push_back(std::stoull(argv[i]));
+    if (depths.empty())
+        depths = {10, 100, 1000, 10000};
+
+    std::vector<BenchResult> results;
+    for (size_t depth : depths) {
+        bench_treap(depth, results);
+        bench_list(depth, results);
+        bench_book(depth, results);
+        bench_load(depth, results);
+    }
+    report(results);
+    return 0;
+}
@@ -0,0 +1,226 @@
+// End-to-end replay benchmark: load() and run() one trading day, report the throughput, the
+// peak RSS and the time spent in each phase, then check the transactions and ticks byte for byte
+// against golden CSV files, as written by example/transaction.py and example/tick.py.
+//
+//   flob_bench_replay [--data FILE | --generate 20000 --seed 1] [--market AShare] [--schedule NAME]
+//                     [--snapshot_gap 60000000000] [--topk 5] [--repeat 1]
+//                     [--transactions FILE] [--ticks FILE]
+//
+// Without --data it replays a fixture of 20000 events generated by OrderFlowGenerator with seed 1
+// and checks it against benchmark/golden/, run it from the repository root. With --data only the
+// golden files given are checked. An empty --transactions / --ticks skips that check, a missing
+// golden file is reported and skipped. Built with -DFLOB_STATS it also reports the latency
+// histograms of the book.
+
+#include <sys/resource.h>
+#include <cassert>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include "bench.hpp"
+#include "csv.hpp"
+#include "generator.hpp"
+#include "limit_order_book.hpp"
+
+// attributes the wall time between two period ends to the status of the period that just ended
+struct PhaseTimer : NullObserver {
+    uint64_t last = 0;
+    std::map<TradingStatus, uint64_t> elapsed;
+
+    void start() { last = now_ns(); }
+    inline void on_period_end(TradingStatus status, uint64_t timestamp) {
+        uint64_t now = now_ns();
+        elapsed[status] += now - last;
+        last = now;
+    }
+};
+
+struct Options {
+    std::string data, market = "AShare", schedule;
+    std::string transactions = "benchmark/golden/transactions.csv", ticks = "benchmark/golden/ticks.csv";
+    uint64_t snapshot_gap = 60000000000UL;
+    size_t topk = 5, repeat = 1;
+    size_t generate = 20000;  // events of the fixture, replayed without --data
+    uint64_t seed = 1;
+};
+
+size_t peak_rss_kb() {
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+// compares the output with a golden file, prints the first differing line
+bool verify(const std::string& name, const std::string& output, const std::string& filename) {
+    if (filename.empty())
+        return true;
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cout << name << ": " << filename << " not found, skipped" << std::endl;
+        return true;
+    }
+    std::string golden((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    if (output == golden) {
+        std::cout << name << ": identical to " << filename << std::endl;
+        return true;
+    }
+    std::istringstream a(output), b(golden);
+    std::string x, y;
+    size_t line = 1;
+    while (std::getline(a, x) && std::getline(b, y) && x == y)
+        ++line;
+    std::cout << name << ": differs from " << filename << " at line " << line << std::endl
+              << "  output: " << x << std::endl
+              << "  golden: " << y << std::endl;
+    return false;
+}
+
+void report_latency(const BookStats& stats) {
+    const char* names[] = {"limit_order", "market_order", "best_price_order", "cancel_order", "fill_order", "modify_order"};
+    auto table = Table<std::string, uint64_t, std::string, std::string, std::string, std::string>({"Latency", "Count", "Mean ns", "P50 ns", "P99 ns", "Max ns"}, 18);
+    auto add = [&](const std::string& name, const LatencyHistogram& h) {
+        if (h.count > 0)
+            table.add_row(name, h.count, format(h.mean()), std::to_string(h.percentile(0.5)), std::to_string(h.percentile(0.99)), std::to_string(h.max));
+    };
+    for (size_t i = 0; i < 6; ++i)
+        add(names[i], stats.quotes[i]);
+    add("match", stats.match);
+    add("match_call_auction", stats.match_call_auction);
+    add("snapshot", stats.snapshot);
+    table.print(std::cout);
+    std::cout << "levels created " << stats.levels_created << ", destroyed " << stats.levels_destroyed
+              << ", max queue length " << stats.max_queue_length << ", max resting orders " << stats.max_resting_orders << std::endl;
+    if (stats.perf_available)
+        for (auto status : {TradingStatus::CallAuction, TradingStatus::ContinuousTrading, TradingStatus::Snapshot}) {
+            auto& phase = stats.phases[status];
+            std::cout << "phase " << status << ": " << phase.cycles << " cycles, " << phase.instructions << " instructions, "
+                      << phase.cache_misses << " cache misses" << std::endl;
+        }
+}
+
+template <typename Market>
+int replay(const Options& options) {
+    typedef LimitOrderBook<Market, PhaseTimer> Book;
+    const double ms = 1e-6;
+    std::string transactions_csv, ticks_csv;
+    uint64_t load_ns = 0, run_ns = 0;
+    size_t quotes = 0, transactions = 0, ticks = 0;
+    std::map<TradingStatus, uint64_t> phases;
+    BookStats stats;
+
+    for (size_t i = 0; i < options.repeat; ++i) {
+        Book book(options.snapshot_gap, options.topk, options.schedule.empty() ? Market::name : options.schedule);
+        auto buffer = std::cout.rdbuf(nullptr);  // load() reports progress on stdout
+        uint64_t start = now_ns();
+        if (options.generate > 0) {
+            GeneratorConfig config;
+            config.seed = options.seed;
+            config.schedule = options.schedule;
+            config.base_rate = daily_rate<Market>(options.generate, options.schedule);
+            quotes = 0;
+            OrderFlowGenerator<Market>(config).generate(options.generate, [&](const Quote& quote) {
+                book.append(quote);
+                ++quotes;
+            });
+        } else {
+            quotes = book.load(options.data);
+        }
+        load_ns += now_ns() - start;
+        std::cout.rdbuf(buffer);
+
+        start = now_ns();
+        book.get_observer().start();
+        book.run();
+        run_ns += now_ns() - start;
+        for (auto& phase : book.get_observer().elapsed)
+            phases[phase.first] += phase.second;
+
+        auto result = book.get_transactions();
+        transactions = result.size();
+        ticks = book.get_ticks().size();
+        if (i + 1 == options.repeat) {
+            std::ostringstream os;
+            write_transactions_csv(os, result, Market::decimal_places);
+            transactions_csv = os.str();
+            os.str("");
+            write_ticks_csv(os, book.get_ticks(), Market::decimal_places);
+            ticks_csv = os.str();
+            stats = book.stats();
+        }
+    }
+
+    double load_s = load_ns * 1e-9 / options.repeat, run_s = run_ns * 1e-9 / options.repeat;
+    auto table = Table<std::string, std::string>({"Metric", "Value"}, 24);
+    table.add_row("quotes", std::to_string(quotes));
+    table.add_row("transactions", std::to_string(transactions));
+    table.add_row("ticks", std::to_string(ticks));
+    table.add_divider();
+    table.add_row("load ms", format(load_s * 1e3, 2));
+    table.add_row("run ms", format(run_s * 1e3, 2));
+    table.add_row("  call auction ms", format(phases[TradingStatus::CallAuction] * ms / options.repeat, 2));
+    table.add_row("  continuous ms", format(phases[TradingStatus::ContinuousTrading] * ms / options.repeat, 2));
+    table.add_row("  snapshot ms", format(phases[TradingStatus::Snapshot] * ms / options.repeat, 2));
+    table.add_divider();
+    table.add_row("load quotes/s", format(quotes / load_s, 0));
+    table.add_row("replay quotes/s", format(quotes / run_s, 0));
+    table.add_row("transactions/s", format(transactions / run_s, 0));
+    table.add_row("peak RSS MiB", format(peak_rss_kb() / 1024.0, 1));
+    table.print(std::cout);
+    if (stats.enabled)
+        report_latency(stats);
+
+    bool ok = verify("transactions", transactions_csv, options.transactions);
+    ok = verify("ticks", ticks_csv, options.ticks) && ok;
+    return ok ? 0 : 1;
+}
+
+int run(int argc, char** argv) {
+    Options options;
+    bool transactions = false, ticks = false;  // golden files given
+    for (int i = 1; i + 1 < argc; i += 2) {
+        std::string key = argv[i], value = argv[i + 1];
+        if (key == "--data")
+            options.data = value;
+        else if (key == "--generate")
+            options.generate = std::stoull(value);
+        else if (key == "--seed")
+            options.seed = std::stoull(value);
+        else if (key == "--market")
+            options.market = value;
+        else if (key == "--schedule")
+            options.schedule = value;
+        else if (key == "--snapshot_gap")
+            options.snapshot_gap = std::stoull(value);
+        else if (key == "--topk")
+            options.topk = std::stoull(value);
+        else if (key == "--repeat")
+            options.repeat = std::max<size_t>(1, std::stoull(value));
+        else if (key == "--transactions") {
+            options.transactions = value;
+            transactions = true;
+        } else if (key == "--ticks") {
+            options.ticks = value;
+            ticks = true;
+        } else
+            throw std::invalid_argument("unknown option: " + key);
+    }
+    if (!options.data.empty()) {  // the golden files of the fixture do not apply to another day
+        options.generate = 0;
+        options.transactions = transactions ? options.transactions : "";
+        options.ticks = ticks ? options.ticks : "";
+    }
+    if (options.market == "AShare")
+        return replay<AShare>(options);
+    if (options.market == "HKEX")
+        return replay<HKEX>(options);
+    throw std::invalid_argument("unknown market: " + options.market);
+}
+
+int main(int argc, char** argv) {
+    try {
+        return run(argc, argv);
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 2;
+    }
+}
@@ -0,0 +1,31 @@
+import argparse
+
+import pandas as pd
+import flob
+
+
+def parse_args() -> argparse.Namespace:
+    parser = argparse.ArgumentParser()
+    parser.add_argument("--data", type=str, default="data/sample.csv")
+    parser.add_argument("--market", type=str, default="AShare", choices=["AShare", "HKEX"])
+    parser.add_argument("--schedule", type=str, default=None)
+    parser.add_argument("--frequencies", type=str, default="1s,1min,5min")
+    parser.add_argument("--output", type=str, default="data/bars_{frequency}.csv")
+    return parser.parse_args()
+
+
+if __name__ == "__main__":
+    args = parse_args()
+    frequencies = args.frequencies.split(",")
+
+    LimitOrderBook = getattr(flob, f"{args.market}LimitOrderBook")
+    lob = LimitOrderBook(schedule=args.schedule or args.market)
+    lob.set_bar_frequencies([pd.Timedelta(f).value for f in frequencies], vwap=True, count=True)
+    lob.load(args.data)
+    lob.run()
+
+    for frequency in frequencies:
+        bars = pd.DataFrame(lob.get_bars(pd.Timedelta(frequency).value))
+        bars.timestamp = pd.to_datetime(bars.timestamp)
+        bars = bars.round({col: lob.decimal_places for col in ["open", "high", "low", "close", "amount"]})
+        bars.to_csv(args.output.format(frequency=frequency), index=False)
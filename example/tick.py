@@ -1,15 +1,17 @@
 import argparse
 
 import pandas as pd
-from flob import LimitOrderBook
+import flob
 
 
 def parse_args() -> argparse.Namespace:
     parser = argparse.ArgumentParser()
     parser.add_argument("--data", type=str, default="data/sample.csv")
-    parser.add_argument("--schedule", type=str, default="AShare")
+    parser.add_argument("--market", type=str, default="AShare", choices=["AShare", "HKEX"])
+    parser.add_argument("--schedule", type=str, default=None)
     parser.add_argument("--snapshot_gap", type=str, default="3s")
     parser.add_argument("--topk", type=int, default=5)
+    parser.add_argument("--features", type=str, default="")
     parser.add_argument("--output", type=str, default="data/ticks.csv")
     return parser.parse_args()
 
@@ -17,14 +19,17 @@ def parse_args() -> argparse.Namespace:
 if __name__ == "__main__":
     args = parse_args()
 
+    LimitOrderBook = getattr(flob, f"{args.market}LimitOrderBook")
     lob = LimitOrderBook(
-        schedule=args.schedule,
+        schedule=args.schedule or args.market,
         snapshot_gap=pd.Timedelta(args.snapshot_gap).value,
         topk=args.topk,
     )
+    lob.set_features([name for name in args.features.split(",") if name])
     lob.load(args.data)
     lob.run()
 
+    features = lob.get_feature_names()
     ticks = lob.get_ticks()
     ticks = [
         {
@@ -39,12 +44,13 @@ if __name__ == "__main__":
             **{f"ask_price_{i+1}": item.ask_prices[i] for i in range(args.topk)},
             **{f"bid_volume_{i+1}": item.bid_volumes[i] for i in range(args.topk)},
             **{f"ask_volume_{i+1}": item.ask_volumes[i] for i in range(args.topk)},
+            **{name: item.features[i] for i, name in enumerate(features)},
         }
         for item in ticks
     ]
     ticks = pd.DataFrame(ticks)
     ticks.timestamp = pd.to_datetime(ticks.timestamp)
-    ticks = ticks.round({"open": 2, "high": 2, "low": 2, "close": 2, "amount": 2})
-    ticks = ticks.round({f"bid_price_{i+1}": 2 for i in range(args.topk)})
-    ticks = ticks.round({f"ask_price_{i+1}": 2 for i in range(args.topk)})
+    ticks = ticks.round({col: lob.decimal_places for col in ["open", "high", "low", "close", "amount"]})
+    ticks = ticks.round({f"bid_price_{i+1}": lob.decimal_places for i in range(args.topk)})
+    ticks = ticks.round({f"ask_price_{i+1}": lob.decimal_places for i in range(args.topk)})
     ticks.to_csv(args.output, index=False)
@@ -1,13 +1,14 @@
 import argparse
 
 import pandas as pd
-from flob import LimitOrderBook
+import flob
 
 
 def parse_args() -> argparse.Namespace:
     parser = argparse.ArgumentParser()
     parser.add_argument("--data", type=str, default="data/sample.csv")
-    parser.add_argument("--schedule", type=str, default="AShare")
+    parser.add_argument("--market", type=str, default="AShare", choices=["AShare", "HKEX"])
+    parser.add_argument("--schedule", type=str, default=None)
     parser.add_argument("--output", type=str, default="data/transactions.csv")
     return parser.parse_args()
 
@@ -15,7 +16,8 @@ def parse_args() -> argparse.Namespace:
 if __name__ == "__main__":
     args = parse_args()
 
-    lob = LimitOrderBook(schedule=args.schedule)
+    LimitOrderBook = getattr(flob, f"{args.market}LimitOrderBook")
+    lob = LimitOrderBook(schedule=args.schedule or args.market)
     lob.load(args.data)
     lob.run()
 
@@ -33,5 +35,5 @@ if __name__ == "__main__":
 
     transactions = pd.DataFrame(transactions)
     transactions.timestamp = pd.to_datetime(transactions.timestamp)
-    transactions = transactions.round({"price": 2})
+    transactions = transactions.round({"price": lob.decimal_places})
     transactions.to_csv(args.output, index=False)
@@ -0,0 +1,125 @@
+#ifndef __ARENA_HPP__
+#define __ARENA_HPP__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Monotonic arena: allocation is a pointer bump inside a chunk, deallocation is a no-op and
+// reset() rewinds to the first chunk while keeping every chunk, so the memory stays warm for
+// the next trading day. Containers that free memory during the day go through a
+// std::pmr::unsynchronized_pool_resource on top of the arena, which recycles their blocks.
+class MonotonicArena : public std::pmr::memory_resource {
+    struct Chunk {
+        std::unique_ptr<char[]> data;
+        size_t size;
+    };
+
+    std::vector<Chunk> chunks;
+    size_t current;
+    char *ptr, *end;
+    size_t chunk_size;
+    size_t allocated, reserved;
+
+    void next_chunk(size_t bytes, size_t alignment);
+
+   protected:
+    void* do_allocate(size_t bytes, size_t alignment) override { return allocate(bytes, alignment); }
+    void do_deallocate(void* p, size_t bytes, size_t alignment) override {}
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+   public:
+    MonotonicArena(size_t chunk_size = 1UL << 20)
+        : current(0), ptr(nullptr), end(nullptr), chunk_size(chunk_size), allocated(0), reserved(0) {}
+    MonotonicArena(const MonotonicArena&) = delete;
+    MonotonicArena& operator=(const MonotonicArena&) = delete;
+
+    inline void* allocate(size_t bytes, size_t alignment = alignof(std::max_align_t)) {
+        char* p = (char*)(((uintptr_t)ptr + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        if (!ptr || p + bytes > end) {
+            next_chunk(bytes, alignment);
+            p = (char*)(((uintptr_t)ptr + alignment - 1) & ~(uintptr_t)(alignment - 1));
+        }
+        ptr = p + bytes;
+        allocated += bytes;
+        return p;
+    }
+    template <typename T, typename... Args>
+    T* create(Args&&... args) { return new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...); }
+
+    void reset();
+    size_t capacity() const { return reserved; }
+    size_t size() const { return allocated; }
+};
+
+inline void MonotonicArena::next_chunk(size_t bytes, size_t alignment) {
+    size_t required = bytes + alignment;
+    if (ptr)
+        ++current;
+    while (current < chunks.size() && chunks[current].size < required)  // skip chunks too small for this request
+        ++current;
+    if (current == chunks.size()) {
+        size_t size = std::max(required, chunks.empty() ? chunk_size : chunks.back().size * 2);
+        chunks.push_back({std::unique_ptr<char[]>(new char[size]), size});
+        reserved += size;
+    }
+    ptr = chunks[current].data.get();
+    end = ptr + chunks[current].size;
+}
+
+inline void MonotonicArena::reset() {
+    current = 0;
+    ptr = chunks.empty() ? nullptr : chunks[0].data.get();
+    end = chunks.empty() ? nullptr : ptr + chunks[0].size;
+    allocated = 0;
+}
+
+// Fixed-size object pool on top of a MonotonicArena, destroyed objects are recycled through an
+// intrusive free list. reset() must be called together with the reset of the underlying arena.
+template <typename T>
+class ObjectPool {
+    union Slot {
+        Slot* next;
+        alignas(T) char storage[sizeof(T)];
+    };
+
+    MonotonicArena* arena;
+    Slot* free_list;
+    size_t live;
+
+   public:
+    ObjectPool(MonotonicArena& arena)
+        : arena(&arena), free_list(nullptr), live(0) {}
+    ObjectPool(const ObjectPool&) = delete;
+    ObjectPool& operator=(const ObjectPool&) = delete;
+
+    template <typename... Args>
+    inline T* create(Args&&... args) {
+        Slot* slot = free_list;
+        if (slot)
+            free_list = slot->next;
+        else
+            slot = (Slot*)arena->allocate(sizeof(Slot), alignof(Slot));
+        ++live;
+        return new (slot->storage) T(std::forward<Args>(args)...);
+    }
+    inline void destroy(T* value) {
+        value->~T();
+        Slot* slot = (Slot*)value;
+        slot->next = free_list;
+        free_list = slot;
+        --live;
+    }
+    void reset() {
+        free_list = nullptr;
+        live = 0;
+    }
+    size_t size() const { return live; }
+};
+
+#endif  // __ARENA_HPP__
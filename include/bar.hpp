@@ -0,0 +1,166 @@
+#ifndef __BAR_HPP__
+#define __BAR_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "market.hpp"
+#include "struct.hpp"
+
+// columnar OHLCV bars of one frequency, `timestamp` is the (inclusive) end of each bar
+struct Bars {
+    uint64_t frequency;
+    bool with_vwap, with_count;
+    std::vector<uint64_t> timestamp;
+    std::vector<double> open, high, low, close;
+    std::vector<uint64_t> volume;
+    std::vector<double> amount;
+    std::vector<double> vwap;     // only filled when with_vwap
+    std::vector<uint64_t> count;  // only filled when with_count
+
+    Bars(uint64_t frequency, bool with_vwap = false, bool with_count = false)
+        : frequency(frequency), with_vwap(with_vwap), with_count(with_count) {}
+    size_t size() const { return timestamp.size(); }
+    void clear() {
+        timestamp.clear();
+        open.clear();
+        high.clear();
+        low.clear();
+        close.clear();
+        volume.clear();
+        amount.clear();
+        vwap.clear();
+        count.clear();
+    }
+};
+
+// Aggregates the transaction stream into bars of several frequencies in a single pass. Bars are
+// aligned to the trading schedule: each call auction is one bar, each continuous trading period
+// is cut into bars of the given frequency starting at the period start, the last one is clipped
+// to the period end. A bar covers (start, end], transactions between two periods belong to the
+// next bar, bars without any transaction are emitted with NaN prices.
+class BarAggregator {
+    struct Series {
+        Bars bars;
+        std::vector<uint64_t> ends;
+        size_t cursor;
+        uint64_t open, high, low, close, volume, amount, count;
+
+        Series(uint64_t frequency, bool with_vwap, bool with_count)
+            : bars(frequency, with_vwap, with_count), cursor(0), open(0), high(0), low(0), close(0), volume(0), amount(0), count(0) {}
+    };
+
+    std::vector<Series> series;
+    double scale_down;
+
+    void emit(Series& s);
+
+   public:
+    BarAggregator(double scale_down = 1.0)
+        : scale_down(scale_down) {}
+
+    void set_frequencies(const std::vector<uint64_t>& frequencies, bool vwap = false, bool count = false);
+    std::vector<uint64_t> frequencies() const;
+    bool empty() const { return series.empty(); }
+
+    void reset(const std::vector<TradingHour>& schedule, uint64_t start_of_day);
+    void clear();
+
+    inline void track(uint64_t timestamp, uint64_t price, uint64_t quantity);
+    inline void flush(uint64_t timestamp);
+
+    const Bars& get(uint64_t frequency) const;
+};
+
+inline void BarAggregator::set_frequencies(const std::vector<uint64_t>& frequencies, bool vwap, bool count) {
+    series.clear();
+    for (auto frequency : frequencies) {
+        if (frequency == 0)
+            throw std::invalid_argument("bar frequency must be positive");
+        series.emplace_back(frequency, vwap, count);
+    }
+}
+
+inline std::vector<uint64_t> BarAggregator::frequencies() const {
+    std::vector<uint64_t> frequencies;
+    for (auto& s : series)
+        frequencies.push_back(s.bars.frequency);
+    return frequencies;
+}
+
+inline void BarAggregator::reset(const std::vector<TradingHour>& schedule, uint64_t start_of_day) {
+    for (auto& s : series) {
+        s.ends.clear();
+        for (auto& period : schedule) {
+            uint64_t start = std::get<1>(period), end = std::get<2>(period);
+            if (std::get<0>(period) == TradingStatus::ContinuousTrading) {
+                for (uint64_t t = start; t < end; t += s.bars.frequency)
+                    s.ends.push_back(start_of_day + std::min(t + s.bars.frequency, end));
+            } else if (std::get<0>(period) == TradingStatus::CallAuction) {
+                s.ends.push_back(start_of_day + end);
+            }
+        }
+        s.cursor = 0;
+        s.open = s.high = s.low = s.close = s.volume = s.amount = s.count = 0;
+    }
+}
+
+inline void BarAggregator::clear() {
+    for (auto& s : series) {
+        s.bars.clear();
+        s.ends.clear();
+        s.cursor = 0;
+        s.open = s.high = s.low = s.close = s.volume = s.amount = s.count = 0;
+    }
+}
+
+inline void BarAggregator::emit(Series& s) {
+    Bars& bars = s.bars;
+    bars.timestamp.push_back(s.ends[s.cursor]);
+    bars.open.push_back(s.volume == 0 ? std::nan("") : s.open * scale_down);
+    bars.high.push_back(s.volume == 0 ? std::nan("") : s.high * scale_down);
+    bars.low.push_back(s.volume == 0 ? std::nan("") : s.low * scale_down);
+    bars.close.push_back(s.volume == 0 ? std::nan("") : s.close * scale_down);
+    bars.volume.push_back(s.volume);
+    bars.amount.push_back(s.amount * scale_down);
+    if (bars.with_vwap)
+        bars.vwap.push_back(s.volume == 0 ? std::nan("") : s.amount * scale_down / s.volume);
+    if (bars.with_count)
+        bars.count.push_back(s.count);
+    s.open = s.high = s.low = s.close = s.volume = s.amount = s.count = 0;
+    ++s.cursor;
+}
+
+inline void BarAggregator::track(uint64_t timestamp, uint64_t price, uint64_t quantity) {
+    for (auto& s : series) {
+        while (s.cursor < s.ends.size() && s.ends[s.cursor] < timestamp)
+            emit(s);
+        if (s.cursor == s.ends.size())
+            continue;
+        s.open = s.volume == 0 ? price : s.open;
+        s.high = s.volume == 0 ? price : std::max(s.high, price);
+        s.low = s.volume == 0 ? price : std::min(s.low, price);
+        s.close = price;
+        s.volume += quantity;
+        s.amount += price * quantity;
+        ++s.count;
+    }
+}
+
+inline void BarAggregator::flush(uint64_t timestamp) {
+    for (auto& s : series)
+        while (s.cursor < s.ends.size() && s.ends[s.cursor] <= timestamp)
+            emit(s);
+}
+
+inline const Bars& BarAggregator::get(uint64_t frequency) const {
+    for (auto& s : series)
+        if (s.bars.frequency == frequency)
+            return s.bars;
+    throw std::invalid_argument("bar frequency is not configured: " + std::to_string(frequency));
+}
+
+#endif  // __BAR_HPP__
@@ -0,0 +1,36 @@
+#ifndef __CHECKPOINT_HPP__
+#define __CHECKPOINT_HPP__
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+#include "struct.hpp"
+
+// The resting orders of a book at one point of a replay, see LimitOrderBook::book_at. The book
+// had written every quote before `quote` (an index into the day's quotes) and was inside the
+// trading period `period` of its expanded schedule. Once strategy orders reached the book it had
+// `diverged` from the market data, with `consumed` the quantities they took from market orders.
+struct BookCheckpoint {
+    struct Level {
+        uint64_t price;
+        Side side;
+        size_t orders;  // number of orders of the level in `orders`
+    };
+    struct Order {
+        uint64_t uid, quantity, timestamp;
+    };
+
+    uint64_t timestamp;
+    size_t quote, period;
+    TradingStatus status;
+    std::vector<Level> levels;  // bids then asks, by ascending price
+    std::vector<Order> orders;  // level by level, in time priority
+    bool diverged;
+    std::vector<std::pair<uint64_t, uint64_t>> consumed;  // market uid, quantity taken by strategy orders
+
+    size_t bytes() const {
+        return sizeof(*this) + levels.capacity() * sizeof(Level) + orders.capacity() * sizeof(Order) + consumed.capacity() * sizeof(consumed[0]);
+    }
+};
+
+#endif  // __CHECKPOINT_HPP__
@@ -0,0 +1,128 @@
+#ifndef __CSV_HPP__
+#define __CSV_HPP__
+
+#include <charconv>
+#include <cmath>
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <vector>
+#include "market.hpp"
+#include "struct.hpp"
+#include "utils.hpp"
+
+// CSV output byte-compatible with what `DataFrame.to_csv(index=False)` writes for the frames
+// built by example/transaction.py and example/tick.py: floats as Python repr, NaN as an empty
+// field, and every timestamp of a column printed with the finest resolution the column needs.
+
+// numpy.round: round half to even at the given number of decimals
+inline double round_decimals(double value, int decimals) {
+    double scale = std::pow(10.0, decimals);
+    return std::nearbyint(value * scale) / scale;
+}
+
+// repr() of a Python float, NaN as an empty string
+inline std::string format_float(double value) {
+    if (std::isnan(value))
+        return "";
+    if (std::isinf(value))
+        return value > 0 ? "inf" : "-inf";
+    char buffer[32];
+    auto end = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::scientific).ptr;
+    std::string repr(buffer, end);  // shortest round trip, [-]d[.ddd]e[+-]dd
+
+    std::string sign = repr[0] == '-' ? "-" : "";
+    size_t e = repr.find('e');
+    std::string digits;
+    for (size_t i = sign.size(); i < e; ++i)
+        if (repr[i] != '.')
+            digits += repr[i];
+    int exponent = std::stoi(repr.substr(e + 1));
+
+    if (exponent < -4 || exponent >= 16) {
+        std::string mantissa = digits.substr(0, 1) + (digits.size() > 1 ? "." + digits.substr(1) : "");
+        std::string power = std::to_string(std::abs(exponent));
+        return sign + mantissa + (exponent < 0 ? "e-" : "e+") + (power.size() < 2 ? "0" : "") + power;
+    }
+    if (exponent < 0)
+        return sign + "0." + std::string(-exponent - 1, '0') + digits;
+    if ((size_t)exponent + 1 >= digits.size())
+        return sign + digits + std::string(exponent + 1 - digits.size(), '0') + ".0";
+    return sign + digits.substr(0, exponent + 1) + "." + digits.substr(exponent + 1);
+}
+
+// number of fractional second digits pandas prints for a datetime column: -1 for dates only,
+// otherwise 0, 3, 6 or 9
+template <typename Container, typename Timestamp>
+int timestamp_precision(const Container& items, Timestamp timestamp) {
+    bool dates_only = true, ms = false, us = false, ns = false;
+    for (auto& item : items) {
+        uint64_t value = timestamp(item);
+        dates_only = dates_only && value % nanoseconds_per_day == 0;
+        ns = ns || value % 1000 != 0;
+        us = us || (value / 1000) % 1000 != 0;
+        ms = ms || (value / 1000000) % 1000 != 0;
+    }
+    return dates_only && !items.empty() ? -1 : ns ? 9 : us ? 6 : ms ? 3 : 0;
+}
+
+inline std::string format_timestamp(uint64_t timestamp, int precision) {
+    time_t seconds = timestamp / nanoseconds_per_second;
+    std::tm gmt{};
+    gmtime_r(&seconds, &gmt);
+    char buffer[32];
+    std::strftime(buffer, sizeof(buffer), precision < 0 ? "%Y-%m-%d" : "%Y-%m-%d %H:%M:%S", &gmt);
+    std::string text(buffer);
+    if (precision > 0) {
+        std::string fraction = std::to_string(timestamp % nanoseconds_per_second);
+        fraction = std::string(9 - fraction.size(), '0') + fraction;
+        text += "." + fraction.substr(0, precision);
+    }
+    return text;
+}
+
+// the columns of example/transaction.py
+template <typename Container>
+void write_transactions_csv(std::ostream& os, const Container& transactions, size_t decimal_places) {
+    int precision = timestamp_precision(transactions, [](const Transaction& t) { return t.timestamp; });
+    const double scale_down = 1.0 / (double)pow10(decimal_places);  // as the book converts prices
+    os << "timestamp,bid_uid,ask_uid,price,volume\n";
+    for (auto& t : transactions)
+        os << format_timestamp(t.timestamp, precision) << ',' << t.bid_uid << ',' << t.ask_uid << ','
+           << format_float(round_decimals(t.price * scale_down, decimal_places)) << ',' << t.quantity << '\n';
+}
+
+// the columns of example/tick.py, followed by the configured features
+template <typename Container>
+void write_ticks_csv(std::ostream& os, const Container& ticks, size_t decimal_places, const std::vector<std::string>& features = {}) {
+    int precision = timestamp_precision(ticks, [](const Tick& t) { return t.timestamp; });
+    size_t topk = ticks.empty() ? 0 : ticks.begin()->bid_prices.size();
+    auto price = [&](double value) { return format_float(round_decimals(value, decimal_places)); };
+
+    os << "timestamp,open,high,low,close,volume,amount";
+    for (auto side : {"bid_price_", "ask_price_", "bid_volume_", "ask_volume_"})
+        for (size_t i = 0; i < topk; ++i)
+            os << ',' << side << i + 1;
+    for (auto& name : features)
+        os << ',' << name;
+    os << '\n';
+
+    for (auto& t : ticks) {
+        os << format_timestamp(t.timestamp, precision) << ',' << price(t.open) << ',' << price(t.high) << ','
+           << price(t.low) << ',' << price(t.close) << ',' << t.volume << ',' << price(t.amount);
+        for (auto value : t.bid_prices)
+            os << ',' << price(value);
+        for (auto value : t.ask_prices)
+            os << ',' << price(value);
+        for (auto value : t.bid_volumes)
+            os << ',' << value;
+        for (auto value : t.ask_volumes)
+            os << ',' << value;
+        for (auto value : t.features)
+            os << ',' << format_float(value);
+        os << '\n';
+    }
+}
+
+#endif  // __CSV_HPP__
@@ -0,0 +1,247 @@
+#ifndef __DEMUX_HPP__
+#define __DEMUX_HPP__
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "quote_file.hpp"
+#include "struct.hpp"
+
+// Splits a multi-symbol exchange file, `symbol,timestamp,uid,price,quantity,side,type` per line,
+// into the quotes of every symbol in one pass. The file is read in windows of `threads` chunks,
+// every chunk starts after a line break and is parsed on its own thread into per-symbol buckets,
+// then the buckets are handed on chunk by chunk, so every symbol receives its quotes in file order.
+//
+// The quotes of a symbol go to a book with route(symbol, book), which appends them as load() does,
+// or to a quote file with route_file(symbol, filename). route_all(pattern) writes every other symbol to
+// `pattern` with `{symbol}` replaced. Quote files are written in blocks and only opened to append a
+// block, so a file with more symbols than the descriptor limit can be split. Prices are parsed in
+// the demux's scale, a book must belong to a market with the same decimal places. Symbols without
+// a route are counted and skipped.
+class SymbolDemux {
+    typedef std::function<void(const std::vector<Quote>&)> Target;
+    typedef std::unordered_map<std::string, std::vector<Quote>> Buckets;
+
+    size_t decimal_places;
+    double scale_up;
+    size_t threads, chunk_size;
+    std::unordered_map<std::string, Target> targets;
+    std::vector<std::unique_ptr<QuoteFileWriter>> writers;
+    std::string pattern;
+    size_t skipped;
+
+    static uint64_t parse_uint(const char*& p, const char* end) {
+        const char* begin = p;
+        uint64_t value = 0;
+        while (p < end && *p >= '0' && *p <= '9')
+            value = value * 10 + (*p++ - '0');
+        if (p == begin)
+            throw std::runtime_error("malformed quote record");
+        return value;
+    }
+    static void expect_comma(const char*& p, const char* end) {
+        if (p == end || *p != ',')
+            throw std::runtime_error("record size is not 7");
+        ++p;
+    }
+    // parses the lines in [begin, end), which ends after a line break or at the end of the file
+    void parse(const char* begin, const char* end, Buckets& buckets) const {
+        std::string symbol;
+        std::vector<Quote>* bucket = nullptr;
+        for (const char* p = begin; p < end;) {
+            const char* eol = std::find(p, end, '\n');
+            const char* last = eol > p && eol[-1] == '\r' ? eol - 1 : eol;
+            if (last == p) {  // empty line
+                p = eol + 1;
+                continue;
+            }
+            const char* comma = std::find(p, last, ',');
+            // consecutive lines mostly share their symbol
+            if (!bucket || symbol.compare(0, std::string::npos, p, comma - p) != 0) {
+                symbol.assign(p, comma);
+                bucket = &buckets[symbol];
+            }
+            p = comma;
+            expect_comma(p, last);
+            uint64_t timestamp = parse_uint(p, last);
+            expect_comma(p, last);
+            uint64_t uid = parse_uint(p, last);
+            expect_comma(p, last);
+            char* price_end;
+            double price = std::strtod(p, &price_end);  // the field is followed by a comma
+            if (price_end == p || price_end > last)
+                throw std::runtime_error("malformed quote record");
+            p = price_end;
+            expect_comma(p, last);
+            uint64_t quantity = parse_uint(p, last);
+            expect_comma(p, last);
+            uint64_t side = parse_uint(p, last);
+            expect_comma(p, last);
+            uint64_t type = parse_uint(p, last);
+            if (p != last)
+                throw std::runtime_error("record size is not 7");
+            bucket->emplace_back(uid, (uint64_t)(price * scale_up + 0.5), quantity, timestamp, static_cast<Side>(side), static_cast<QuoteType>(type));
+            p = eol + 1;
+        }
+    }
+    void deliver(const std::string& symbol, const std::vector<Quote>& quotes) {
+        auto it = targets.find(symbol);
+        if (it == targets.end() && !pattern.empty()) {
+            std::string filename = pattern;
+            filename.replace(filename.find("{symbol}"), 8, symbol);
+            route_file(symbol, filename);
+            it = targets.find(symbol);
+        }
+        if (it == targets.end())
+            skipped += quotes.size();
+        else
+            it->second(quotes);
+    }
+
+   public:
+    SymbolDemux(size_t decimal_places, size_t threads = 0, size_t chunk_size = 1 << 24)
+        : decimal_places(decimal_places), scale_up(1), threads(threads), chunk_size(chunk_size), skipped(0) {
+        for (size_t i = 0; i < decimal_places; ++i)
+            scale_up *= 10;
+        if (this->threads == 0)
+            this->threads = std::max(1u, std::thread::hardware_concurrency());
+        if (chunk_size == 0)
+            throw std::invalid_argument("chunk size must be positive");
+    }
+    ~SymbolDemux() { close(); }
+
+    // appends the quotes of `symbol` to the loaded day of `book`
+    template <typename Book>
+    void route(const std::string& symbol, Book& book) {
+        if (Book::market_type::decimal_places != decimal_places)
+            throw std::invalid_argument("the market of the book has " + std::to_string(Book::market_type::decimal_places) + " decimal places, the demux " + std::to_string(decimal_places));
+        targets[symbol] = [&book](const std::vector<Quote>& quotes) {
+            for (auto& quote : quotes)
+                book.append(quote);
+        };
+    }
+    // writes the quotes of `symbol` to a .csv or .bin quote file in the demux's decimal places
+    void route_file(const std::string& symbol, const std::string& filename) {
+        // small buffers and no open descriptor between blocks, an exchange file can hold thousands of symbols
+        writers.emplace_back(new QuoteFileWriter(filename, decimal_places, 1 << 16, false));
+        QuoteFileWriter* writer = writers.back().get();
+        targets[symbol] = [writer](const std::vector<Quote>& quotes) {
+            for (auto& quote : quotes)
+                writer->write(quote);
+        };
+    }
+    void route_all(const std::string& pattern) {
+        if (pattern.find("{symbol}") == std::string::npos)
+            throw std::invalid_argument("pattern must contain {symbol}");
+        this->pattern = pattern;
+    }
+
+    // splits `filename`, returns the number of quotes routed
+    size_t scan(const std::string& filename, bool header = true);
+    // flushes and closes the quote files
+    void close() {
+        for (auto& writer : writers)
+            writer->close();
+    }
+
+    // the routed symbols, route_all() included
+    std::vector<std::string> get_symbols() const {
+        std::vector<std::string> symbols;
+        for (auto& target : targets)
+            symbols.push_back(target.first);
+        std::sort(symbols.begin(), symbols.end());
+        return symbols;
+    }
+    size_t skipped_count() const { return skipped; }
+};
+
+inline size_t SymbolDemux::scan(const std::string& filename, bool header) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("file is not open");
+    if (header) {
+        std::string line;
+        std::getline(file, line);
+    }
+
+    size_t count = 0;
+    std::vector<char> buffer;
+    std::string carry;  // the unfinished last line of the previous window
+    std::vector<Buckets> buckets(threads);
+    std::vector<std::exception_ptr> errors(threads);
+    while (true) {
+        buffer.assign(carry.begin(), carry.end());
+        buffer.resize(carry.size() + threads * chunk_size);
+        file.read(buffer.data() + carry.size(), threads * chunk_size);
+        buffer.resize(carry.size() + file.gcount() + 1);
+        buffer.back() = '\0';  // stops strtod on a malformed last line
+        bool eof = !file;
+        const char* begin = buffer.data();
+        const char* end = begin + buffer.size() - 1;
+        if (!eof) {
+            const char* eol = end;
+            while (eol > begin && eol[-1] != '\n')
+                --eol;
+            if (eol == begin)
+                throw std::runtime_error("line longer than a window");
+            carry.assign(eol, end);
+            end = eol;
+        }
+        if (begin == end)
+            break;
+
+        // chunk i starts after the first line break at or past i * size
+        size_t size = (end - begin + threads - 1) / threads;
+        std::vector<const char*> bounds{begin};
+        for (size_t i = 1; i < threads; ++i) {
+            const char* p = std::max(bounds.back(), std::min(end, begin + i * size));
+            if (p > begin && p < end && p[-1] != '\n')
+                p = std::min(end, std::find(p, end, '\n') + 1);
+            bounds.push_back(p);
+        }
+        bounds.push_back(end);
+
+        std::vector<std::thread> workers;
+        for (size_t i = 0; i < threads; ++i) {
+            if (bounds[i] == bounds[i + 1])
+                continue;
+            workers.emplace_back([&, i] {
+                try {
+                    parse(bounds[i], bounds[i + 1], buckets[i]);
+                } catch (...) {
+                    errors[i] = std::current_exception();
+                }
+            });
+        }
+        for (auto& worker : workers)
+            worker.join();
+        for (auto& error : errors)
+            if (error)
+                std::rethrow_exception(error);
+
+        for (auto& chunk : buckets) {
+            for (auto& bucket : chunk) {
+                if (bucket.second.empty())
+                    continue;
+                size_t before = skipped;
+                deliver(bucket.first, bucket.second);
+                count += bucket.second.size() - (skipped - before);
+                bucket.second.clear();  // keeps the capacity for the next window
+            }
+        }
+        if (eof)
+            break;
+    }
+    return count;
+}
+
+#endif  // __DEMUX_HPP__
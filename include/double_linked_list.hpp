@@ -2,25 +2,29 @@
 #define __DOUBLE_LINKED_LIST_HPP__
 
 #include <iostream>
-#include <memory>
+#include <stdexcept>
+#include "arena.hpp"
 
 template <typename T>
 struct ListNode {
     T value;
-    std::shared_ptr<ListNode> next;
-    std::weak_ptr<ListNode> prev;
+    ListNode *next, *prev;
 
     ListNode(T value)
-        : value(value) {}
+        : value(value), next(nullptr), prev(nullptr) {}
 };
 
+// the list does not own its nodes, they are borrowed from (and returned to) a pool shared by
+// every list of the same type
 template <typename T>
 class DoubleLinkedList {
+    ObjectPool<ListNode<T>>* pool;
+
    public:
     size_t size;
-    std::shared_ptr<ListNode<T>> head, tail;
-    DoubleLinkedList()
-        : size(0), head(nullptr), tail(nullptr) {}
+    ListNode<T> *head, *tail;
+    DoubleLinkedList(ObjectPool<ListNode<T>>& pool)
+        : pool(&pool), size(0), head(nullptr), tail(nullptr) {}
     inline bool empty() { return size == 0; }
     void push_back(const T& value);
     void push_front(const T& value);
@@ -33,10 +37,10 @@ class DoubleLinkedList {
 template <typename T>
 void DoubleLinkedList<T>::push_back(const T& value) {
     if (!head) {
-        head = std::make_shared<ListNode<T>>(value);
+        head = pool->create(value);
         tail = head;
     } else {
-        tail->next = std::make_shared<ListNode<T>>(value);
+        tail->next = pool->create(value);
         tail->next->prev = tail;
         tail = tail->next;
     }
@@ -46,10 +50,10 @@ void DoubleLinkedList<T>::push_back(const T& value) {
 template <typename T>
 void DoubleLinkedList<T>::push_front(const T& value) {
     if (!head) {
-        head = std::make_shared<ListNode<T>>(value);
+        head = pool->create(value);
         tail = head;
     } else {
-        head->prev = std::make_shared<ListNode<T>>(value);
+        head->prev = pool->create(value);
         head->prev->next = head;
         head = head->prev;
     }
@@ -61,14 +65,16 @@ T DoubleLinkedList<T>::pop_back() {
     if (!head)
         throw std::runtime_error("Empty list");
 
-    T value = tail->value;
+    ListNode<T>* node = tail;
+    T value = node->value;
     if (head == tail) {
         head = nullptr;
         tail = nullptr;
     } else {
-        tail = tail->prev.lock();
+        tail = tail->prev;
         tail->next = nullptr;
     }
+    pool->destroy(node);
     --size;
     return value;
 }
@@ -78,14 +84,16 @@ T DoubleLinkedList<T>::pop_front() {
     if (!head)
         throw std::runtime_error("Empty list");
 
-    T value = head->value;
+    ListNode<T>* node = head;
+    T value = node->value;
     if (head == tail) {
         head = nullptr;
         tail = nullptr;
     } else {
         head = head->next;
-        head->prev = std::weak_ptr<ListNode<T>>();
+        head->prev = nullptr;
     }
+    pool->destroy(node);
     --size;
     return value;
 }
@@ -108,7 +116,7 @@ T& DoubleLinkedList<T>::back() {
 
 template <typename T>
 std::ostream& operator<<(std::ostream& os, const DoubleLinkedList<T>& list) {
-    std::shared_ptr<ListNode<T>> current = list.head;
+    ListNode<T>* current = list.head;
     while (current) {
         os << current->value << " ";
         current = current->next;
@@ -116,4 +124,4 @@ std::ostream& operator<<(std::ostream& os, const DoubleLinkedList<T>& list) {
     return os;
 }
 
-#endif  // __DOUBLE_LINKED_LIST_HPP__
\ No newline at end of file
+#endif  // __DOUBLE_LINKED_LIST_HPP__
@@ -0,0 +1,143 @@
+#ifndef __FEATURE_HPP__
+#define __FEATURE_HPP__
+
+#include <cmath>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "struct.hpp"
+
+// microstructure features emitted with every tick, in the order they are configured
+//   * Spread              best ask - best bid
+//   * MidPrice            (best ask + best bid) / 2
+//   * Imbalance           (bid volume - ask volume) / (bid volume + ask volume) at the best level
+//   * DepthImbalance      same as Imbalance over the top-k levels
+//   * MicroPrice          best prices weighted by the opposite best volume
+//   * WeightedMidPrice    mean of the volume weighted prices of the top-k levels of both sides
+//   * TradeFlowImbalance  (buy volume - sell volume) / (buy volume + sell volume) since the last
+//                         tick by the side of the incoming order, call auction trades have no
+//                         aggressor and are left out
+enum Feature {
+    Spread,
+    MidPrice,
+    Imbalance,
+    DepthImbalance,
+    MicroPrice,
+    WeightedMidPrice,
+    TradeFlowImbalance
+};
+
+const std::vector<std::string> FEATURE_NAMES = {
+    "spread",
+    "mid_price",
+    "imbalance",
+    "depth_imbalance",
+    "micro_price",
+    "weighted_mid_price",
+    "trade_flow_imbalance",
+};
+
+// Computes the configured features from the top-k levels already collected for the tick, the
+// trade flow is accumulated as transactions happen, so a snapshot never walks the book again.
+class FeatureSet {
+    std::vector<Feature> features;
+    uint64_t buy_volume, sell_volume;
+
+   public:
+    FeatureSet()
+        : buy_volume(0), sell_volume(0) {}
+
+    void set(const std::vector<std::string>& names);
+    std::vector<std::string> names() const;
+    bool empty() const { return features.empty(); }
+    size_t size() const { return features.size(); }
+    void clear() { buy_volume = sell_volume = 0; }
+
+    // `aggressor` is the Side of the incoming order or TradeDetails::no_aggressor
+    inline void track(const Transaction& transaction, uint8_t aggressor);
+    std::vector<double> snapshot(const std::vector<double>& bid_prices,
+                                 const std::vector<double>& ask_prices,
+                                 const std::vector<uint64_t>& bid_volumes,
+                                 const std::vector<uint64_t>& ask_volumes);
+};
+
+inline void FeatureSet::set(const std::vector<std::string>& names) {
+    std::vector<Feature> parsed;
+    for (auto& name : names) {
+        size_t i = 0;
+        while (i < FEATURE_NAMES.size() && FEATURE_NAMES[i] != name)
+            ++i;
+        if (i == FEATURE_NAMES.size())
+            throw std::invalid_argument("Unknown feature: " + name);
+        parsed.push_back((Feature)i);
+    }
+    features.swap(parsed);
+}
+
+inline std::vector<std::string> FeatureSet::names() const {
+    std::vector<std::string> names;
+    for (auto feature : features)
+        names.push_back(FEATURE_NAMES[feature]);
+    return names;
+}
+
+inline void FeatureSet::track(const Transaction& transaction, uint8_t aggressor) {
+    if (aggressor == Side::Bid)
+        buy_volume += transaction.quantity;
+    else if (aggressor == Side::Ask)
+        sell_volume += transaction.quantity;
+}
+
+inline std::vector<double> FeatureSet::snapshot(const std::vector<double>& bid_prices,
+                                                const std::vector<double>& ask_prices,
+                                                const std::vector<uint64_t>& bid_volumes,
+                                                const std::vector<uint64_t>& ask_volumes) {
+    // empty levels are NaN prices with zero volume, so every sum below skips them
+    double bid = bid_prices.empty() ? std::nan("") : bid_prices[0];
+    double ask = ask_prices.empty() ? std::nan("") : ask_prices[0];
+    double bid_volume = bid_volumes.empty() ? 0 : bid_volumes[0];
+    double ask_volume = ask_volumes.empty() ? 0 : ask_volumes[0];
+    double bid_depth = 0, ask_depth = 0, bid_amount = 0, ask_amount = 0;
+    for (size_t i = 0; i < bid_volumes.size() && bid_volumes[i] > 0; ++i) {
+        bid_depth += bid_volumes[i];
+        bid_amount += bid_prices[i] * bid_volumes[i];
+    }
+    for (size_t i = 0; i < ask_volumes.size() && ask_volumes[i] > 0; ++i) {
+        ask_depth += ask_volumes[i];
+        ask_amount += ask_prices[i] * ask_volumes[i];
+    }
+    auto ratio = [](double a, double b) { return a + b > 0 ? (a - b) / (a + b) : std::nan(""); };
+
+    std::vector<double> values;
+    values.reserve(features.size());
+    for (auto feature : features) {
+        switch (feature) {
+            case Feature::Spread:
+                values.push_back(ask - bid);
+                break;
+            case Feature::MidPrice:
+                values.push_back((ask + bid) / 2);
+                break;
+            case Feature::Imbalance:
+                values.push_back(ratio(bid_volume, ask_volume));
+                break;
+            case Feature::DepthImbalance:
+                values.push_back(ratio(bid_depth, ask_depth));
+                break;
+            case Feature::MicroPrice:
+                values.push_back((bid * ask_volume + ask * bid_volume) / (bid_volume + ask_volume));
+                break;
+            case Feature::WeightedMidPrice:
+                values.push_back((bid_amount / bid_depth + ask_amount / ask_depth) / 2);
+                break;
+            case Feature::TradeFlowImbalance:
+                values.push_back(ratio(buy_volume, sell_volume));
+                break;
+        }
+    }
+    buy_volume = sell_volume = 0;
+    return values;
+}
+
+#endif  // __FEATURE_HPP__
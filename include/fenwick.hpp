@@ -0,0 +1,49 @@
+#ifndef __FENWICK_HPP__
+#define __FENWICK_HPP__
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+// Fenwick (binary indexed) tree over a growing sequence: point update, prefix sum and append
+// are all O(log n). `tree[i]` holds the sum of the elements in (i - lowbit(i), i], 1-based.
+template <typename T>
+class FenwickTree {
+    std::pmr::vector<T> tree;
+
+    static inline size_t lowbit(size_t i) { return i & (~i + 1); }
+
+   public:
+    FenwickTree(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : tree(1, T(), resource) {}
+
+    size_t size() const { return tree.size() - 1; }
+    void clear() { tree.resize(1); }
+    void push_back(T value);
+    void add(size_t index, T delta);
+    T prefix(size_t n) const;  // sum of the first n elements
+};
+
+template <typename T>
+void FenwickTree<T>::push_back(T value) {
+    size_t i = tree.size();
+    for (size_t j = i - 1, stop = i - lowbit(i); j > stop; j -= lowbit(j))
+        value += tree[j];
+    tree.push_back(value);
+}
+
+template <typename T>
+void FenwickTree<T>::add(size_t index, T delta) {
+    for (size_t i = index + 1; i < tree.size(); i += lowbit(i))
+        tree[i] += delta;
+}
+
+template <typename T>
+T FenwickTree<T>::prefix(size_t n) const {
+    T sum = T();
+    for (size_t i = n; i > 0; i -= lowbit(i))
+        sum += tree[i];
+    return sum;
+}
+
+#endif  // __FENWICK_HPP__
@@ -0,0 +1,271 @@
+#ifndef __GENERATOR_HPP__
+#define __GENERATOR_HPP__
+
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "market.hpp"
+#include "quote_file.hpp"
+#include "struct.hpp"
+#include "utils.hpp"
+
+// Synthetic order flow for scale testing.
+//
+// Event times follow a Hawkes process with an exponential kernel: the intensity is `base_rate`
+// plus `excitation` for every past event, decaying at `decay` per second (a Poisson process when
+// `excitation` is 0, stationary while `excitation` < `decay`). Time runs on a trading clock that
+// only advances during the continuous trading periods of the schedule, the generator is exhausted
+// at the end of the last one.
+//
+// Every event is one of
+//   * a limit order 1 to `levels` ticks away from the best opposite price, it never crosses
+//   * a market order taking liquidity from the opposite side, on markets without market orders
+//     a limit order at the best opposite price for at most the quantity of that level
+//   * a best price order joining the best level of its own side
+//   * a cancel of a resting order chosen uniformly
+// picked with the given weights. The cancel weight applies when `resting_orders` orders rest and
+// scales with their number, so that the depth of the book stays around that size. Quantities are
+// `lot` times a uniform number of lots in [min_lots, max_lots].
+//
+// The generator keeps a price-time view of the resting orders, cancels always refer to orders the
+// book replaying the flow still holds.
+struct GeneratorConfig {
+    uint64_t seed = 0;
+    uint64_t date = 1664496000000000000UL;  // midnight of the generated day, 2022-09-30
+    std::string schedule;                   // empty for the market's default schedule
+    double base_rate = 1000, excitation = 0, decay = 1;
+    double price = 10;  // initial reference price
+    size_t levels = 10;
+    double limit_weight = 0.5, market_weight = 0.05, best_price_weight = 0.05, cancel_weight = 0.4;
+    size_t resting_orders = 1000;
+    uint64_t lot = 100, min_lots = 1, max_lots = 10;
+};
+
+// the base rate at which about `events` events fill the continuous trading periods of a day
+template <typename Market>
+double daily_rate(size_t events, const std::string& schedule = "") {
+    uint64_t duration = 0;
+    for (auto& hour : Market::schedule(schedule.empty() ? Market::name : schedule))
+        if (std::get<0>(hour) == TradingStatus::ContinuousTrading)
+            duration += std::get<2>(hour) - std::get<1>(hour);
+    return events * 1e9 / duration;
+}
+
+template <typename Market>
+class OrderFlowGenerator {
+    struct Resting {
+        uint64_t price, quantity;
+        Side side;
+        size_t slot;  // index in `live`
+    };
+    struct Level {
+        std::deque<uint64_t> queue;  // uids in time priority, cancelled ones are skipped
+        size_t count = 0;            // resting orders in the queue
+        uint64_t quantity = 0;
+    };
+    struct Period {
+        uint64_t start, end, offset;  // wall clock bounds, trading time before the period
+    };
+
+    GeneratorConfig config;
+    std::mt19937_64 rng;
+    std::uniform_real_distribution<double> uniform;
+    std::vector<Period> periods;
+    size_t period;
+    double clock, excess;  // trading time in seconds, excitation above the base rate at `clock`
+    uint64_t uid, reference;
+    std::unordered_map<uint64_t, Resting> orders;
+    std::vector<uint64_t> live;
+    std::map<uint64_t, Level> bids, asks;
+
+    // Ogata thinning: the intensity only decays between events, so its current value bounds it
+    bool advance(uint64_t& timestamp) {
+        while (true) {
+            double bound = config.base_rate + excess;
+            double wait = -std::log(1.0 - uniform(rng)) / bound;
+            clock += wait;
+            excess *= std::exp(-config.decay * wait);
+            if (uniform(rng) * bound <= config.base_rate + excess)
+                break;
+        }
+        excess += config.excitation;
+        uint64_t elapsed = (uint64_t)(clock * nanoseconds_per_second);
+        while (period < periods.size() && elapsed >= periods[period].offset + periods[period].end - periods[period].start)
+            ++period;
+        if (period == periods.size())
+            return false;
+        timestamp = config.date + periods[period].start + elapsed - periods[period].offset;
+        return true;
+    }
+
+    uint64_t quantity() {
+        return config.lot * std::uniform_int_distribution<uint64_t>(config.min_lots, config.max_lots)(rng);
+    }
+
+    // `n` ticks above / below a price, bids stay above zero
+    static uint64_t ticks_up(uint64_t price, size_t n) {
+        uint64_t tick = Market::tick_size(price), target = price + tick * n;
+        if (Market::tick_size(target - 1) == tick)  // the tick size is monotonic in the price
+            return target;
+        for (; n > 0; --n)
+            price += Market::tick_size(price);
+        return price;
+    }
+    static uint64_t ticks_down(uint64_t price, size_t n) {
+        uint64_t tick = Market::tick_size(price - 1);
+        if (price > tick * n && Market::tick_size(price - tick * n) == tick)
+            return price - tick * n;
+        for (; n > 0 && price > Market::tick_size(price - 1); --n)
+            price -= Market::tick_size(price - 1);
+        return price;
+    }
+
+    void rest(uint64_t id, Side side, uint64_t price, uint64_t quantity) {
+        auto& level = (side == Side::Bid ? bids : asks)[price];
+        level.queue.push_back(id);
+        ++level.count;
+        level.quantity += quantity;
+        orders.emplace(id, Resting{price, quantity, side, live.size()});
+        live.push_back(id);
+    }
+    void remove(typename std::unordered_map<uint64_t, Resting>::iterator it) {
+        auto& levels = it->second.side == Side::Bid ? bids : asks;
+        auto level = levels.find(it->second.price);
+        level->second.quantity -= it->second.quantity;
+        if (--level->second.count == 0)
+            levels.erase(level);
+        orders.find(live.back())->second.slot = it->second.slot;
+        live[it->second.slot] = live.back();
+        live.pop_back();
+        orders.erase(it);
+    }
+
+    template <typename Sink>
+    void limit_order(Side side, uint64_t timestamp, Sink& sink) {
+        size_t distance = std::uniform_int_distribution<size_t>(1, config.levels)(rng);
+        uint64_t price;
+        if (side == Side::Bid)
+            price = ticks_down(asks.empty() ? reference : asks.begin()->first, distance);
+        else
+            price = ticks_up(bids.empty() ? reference : bids.rbegin()->first, distance);
+        uint64_t q = quantity();
+        rest(++uid, side, price, q);
+        sink(Quote(uid, price, q, timestamp, side, QuoteType::LimitOrder));
+    }
+
+    // takes from the front of the best opposite levels, what is left when the side runs dry is dropped
+    template <typename Sink>
+    void market_order(Side side, uint64_t timestamp, Sink& sink) {
+        auto& levels = side == Side::Bid ? asks : bids;
+        uint64_t q = quantity();
+        if (Market::allows(QuoteType::MarketOrder)) {
+            sink(Quote(++uid, 0, q, timestamp, side, QuoteType::MarketOrder));
+        } else {
+            auto& best = side == Side::Bid ? *levels.begin() : *levels.rbegin();
+            q = std::min(q, best.second.quantity);
+            sink(Quote(++uid, best.first, q, timestamp, side, QuoteType::LimitOrder));
+        }
+        while (q > 0 && !levels.empty()) {
+            auto level = side == Side::Bid ? levels.begin() : std::prev(levels.end());
+            auto it = orders.find(level->second.queue.front());
+            if (it == orders.end()) {
+                level->second.queue.pop_front();
+                continue;
+            }
+            uint64_t taken = std::min(q, it->second.quantity);
+            q -= taken;
+            it->second.quantity -= taken;
+            level->second.quantity -= taken;
+            reference = level->first;
+            if (it->second.quantity == 0) {
+                level->second.queue.pop_front();
+                remove(it);
+            }
+        }
+    }
+
+    template <typename Sink>
+    void best_price_order(Side side, uint64_t timestamp, Sink& sink) {
+        uint64_t price = side == Side::Bid ? bids.rbegin()->first : asks.begin()->first;
+        uint64_t q = quantity();
+        rest(++uid, side, price, q);
+        sink(Quote(uid, price, q, timestamp, side, QuoteType::BestPriceOrder));
+    }
+
+    template <typename Sink>
+    void cancel_order(uint64_t timestamp, Sink& sink) {
+        uint64_t id = live[std::uniform_int_distribution<size_t>(0, live.size() - 1)(rng)];
+        auto it = orders.find(id);
+        Quote quote(id, it->second.price, it->second.quantity, timestamp, it->second.side, QuoteType::CancelOrder);
+        remove(it);
+        sink(quote);
+    }
+
+   public:
+    OrderFlowGenerator(const GeneratorConfig& config = GeneratorConfig())
+        : config(config), rng(config.seed), period(0), clock(0), excess(0), uid(0) {
+        if (config.base_rate <= 0 || config.decay <= 0 || config.excitation < 0)
+            throw std::invalid_argument("base_rate and decay must be positive, excitation non-negative");
+        if (config.levels == 0 || config.min_lots == 0 || config.min_lots > config.max_lots || config.resting_orders == 0)
+            throw std::invalid_argument("levels, resting_orders and min_lots must be positive, min_lots <= max_lots");
+        if (!Market::allows(QuoteType::BestPriceOrder))
+            this->config.best_price_weight = 0;
+        uint64_t offset = 0;
+        for (auto& hour : Market::schedule(config.schedule.empty() ? Market::name : config.schedule)) {
+            if (std::get<0>(hour) != TradingStatus::ContinuousTrading)
+                continue;
+            periods.push_back({std::get<1>(hour), std::get<2>(hour), offset});
+            offset += std::get<2>(hour) - std::get<1>(hour);
+        }
+        reference = (uint64_t)(config.price * pow10(Market::decimal_places) + 0.5);
+        reference = std::max(reference - reference % Market::tick_size(reference), Market::tick_size(0));
+    }
+
+    bool exhausted() const { return period == periods.size(); }
+    size_t resting() const { return live.size(); }
+
+    // Generates up to `n` events and hands each quote to `sink(quote)`, returns the number of events,
+    // fewer than `n` once the trading day is over.
+    template <typename Sink>
+    size_t generate(size_t n, Sink sink) {
+        const double weight = config.limit_weight + config.market_weight + config.best_price_weight;
+        size_t count = 0;
+        uint64_t timestamp;
+        for (; count < n && advance(timestamp); ++count) {
+            double cancel = config.cancel_weight * live.size() / config.resting_orders;
+            double u = uniform(rng) * (weight + cancel);
+            Side side = rng() & 1 ? Side::Ask : Side::Bid;
+            bool opposite = !(side == Side::Bid ? asks : bids).empty(), own = !(side == Side::Bid ? bids : asks).empty();
+            if (u < config.market_weight && opposite)
+                market_order(side, timestamp, sink);
+            else if (u >= config.market_weight && u < config.market_weight + config.best_price_weight && own)
+                best_price_order(side, timestamp, sink);
+            else if (u >= weight && !live.empty())
+                cancel_order(timestamp, sink);
+            else
+                limit_order(side, timestamp, sink);
+        }
+        return count;
+    }
+
+    template <typename Book>
+    size_t feed(Book& book, size_t n) {
+        return generate(n, [&](const Quote& quote) { book.write(quote); });
+    }
+
+    // writes the events to a .csv or .bin file, see quote_file.hpp
+    size_t write(const std::string& filename, size_t n) {
+        QuoteFileWriter writer(filename, Market::decimal_places);
+        size_t count = generate(n, [&](const Quote& quote) { writer.write(quote); });
+        writer.close();
+        return count;
+    }
+};
+
+#endif  // __GENERATOR_HPP__
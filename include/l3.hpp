@@ -0,0 +1,106 @@
+#ifndef __L3_HPP__
+#define __L3_HPP__
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "stream_writer.hpp"
+
+// Full depth of a book at one moment, order by order, see LimitOrderBook::dump_l3. The levels are
+// bids then asks by ascending price, the orders are level by level in time priority, the first
+// `level_orders[0]` belong to the first level and so on. Prices are in the market's scale.
+struct L3Snapshot {
+    uint64_t timestamp = 0;
+    std::vector<uint64_t> level_price, level_quantity, level_orders;
+    std::vector<uint8_t> level_side;
+    std::vector<uint64_t> order_uid, order_quantity, order_timestamp;
+
+    size_t levels() const { return level_price.size(); }
+    size_t orders() const { return order_uid.size(); }
+    // keeps the capacity, a snapshot taken again into the same columns does not allocate
+    void clear() {
+        level_price.clear();
+        level_quantity.clear();
+        level_orders.clear();
+        level_side.clear();
+        order_uid.clear();
+        order_quantity.clear();
+        order_timestamp.clear();
+    }
+    size_t bytes() const { return levels() * (3 * sizeof(uint64_t) + sizeof(uint8_t)) + orders() * 3 * sizeof(uint64_t); }
+};
+
+// Binary L3 files: a ResultFileHeader, then for every snapshot its timestamp, the number of levels
+// and of orders, followed by the columns in the order of L3Snapshot, in native byte order.
+const char L3_FILE_MAGIC[8] = {'F', 'L', 'O', 'B', 'L', '3', '0', '1'};
+
+class L3FileWriter {
+    std::ofstream file;
+
+    template <typename T>
+    void write_column(const std::vector<T>& column) { file.write(reinterpret_cast<const char*>(column.data()), column.size() * sizeof(T)); }
+
+   public:
+    L3FileWriter(const std::string& filename, size_t decimal_places)
+        : file(filename, std::ios::binary) {
+        if (!file.is_open())
+            throw std::runtime_error("cannot open " + filename);
+        ResultFileHeader header{{}, decimal_places, 0, 0};
+        std::memcpy(header.magic, L3_FILE_MAGIC, sizeof(header.magic));
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+
+    void write(const L3Snapshot& snapshot) {
+        uint64_t counts[3] = {snapshot.timestamp, snapshot.levels(), snapshot.orders()};
+        file.write(reinterpret_cast<const char*>(counts), sizeof(counts));
+        write_column(snapshot.level_price);
+        write_column(snapshot.level_quantity);
+        write_column(snapshot.level_orders);
+        write_column(snapshot.level_side);
+        write_column(snapshot.order_uid);
+        write_column(snapshot.order_quantity);
+        write_column(snapshot.order_timestamp);
+        if (!file)
+            throw std::runtime_error("failed to write L3 snapshot");
+    }
+    void flush() { file.flush(); }
+};
+
+inline std::vector<L3Snapshot> read_l3_file(const std::string& filename, size_t decimal_places) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("file is not open");
+    ResultFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, L3_FILE_MAGIC, sizeof(header.magic)) != 0)
+        throw std::runtime_error(filename + " is not a binary L3 file");
+    if (header.decimal_places != decimal_places)
+        throw std::runtime_error("L3 file has " + std::to_string(header.decimal_places) + " decimal places, the market has " + std::to_string(decimal_places));
+
+    auto read_column = [&](auto& column, size_t size) {
+        column.resize(size);
+        if (!file.read(reinterpret_cast<char*>(column.data()), size * sizeof(column[0])))
+            throw std::runtime_error("truncated L3 file");
+    };
+    std::vector<L3Snapshot> snapshots;
+    uint64_t counts[3];
+    while (file.read(reinterpret_cast<char*>(counts), sizeof(counts))) {
+        snapshots.emplace_back();
+        L3Snapshot& snapshot = snapshots.back();
+        snapshot.timestamp = counts[0];
+        read_column(snapshot.level_price, counts[1]);
+        read_column(snapshot.level_quantity, counts[1]);
+        read_column(snapshot.level_orders, counts[1]);
+        read_column(snapshot.level_side, counts[1]);
+        read_column(snapshot.order_uid, counts[2]);
+        read_column(snapshot.order_quantity, counts[2]);
+        read_column(snapshot.order_timestamp, counts[2]);
+    }
+    if (file.gcount() != 0)
+        throw std::runtime_error("truncated L3 file");
+    return snapshots;
+}
+
+#endif  // __L3_HPP__
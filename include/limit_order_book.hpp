@@ -1,115 +1,242 @@
 #ifndef __LIMIT_ORDER_BOOK_HPP__
 #define __LIMIT_ORDER_BOOK_HPP__
 
+#include <algorithm>
 #include <cassert>
 #include <cmath>
+#include <deque>
 #include <fstream>
 #include <iostream>
+#include <limits>
 #include <memory>
+#include <memory_resource>
+#include <queue>
+#include <random>
 #include <sstream>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
+#include "arena.hpp"
+#include "bar.hpp"
+#include "checkpoint.hpp"
 #include "double_linked_list.hpp"
+#include "feature.hpp"
+#include "l3.hpp"
+#include "market.hpp"
+#include "observer.hpp"
+#include "quote_file.hpp"
+#include "record_log.hpp"
+#include "reorder.hpp"
+#include "stats.hpp"
+#include "stream_writer.hpp"
 #include "struct.hpp"
 #include "treap.hpp"
 #include "utils.hpp"
 
-const std::vector<std::tuple<TradingStatus, uint64_t, uint64_t>> CHINA_A_SHARE_TRADING_SCHEDULE = {
-    // Opening Call Auction: 09:15:00 - 09:25:00
-    {TradingStatus::CallAuction, 33300000000000UL, 33900000000000UL},
-    // Continuous Auction (Morning): 09:30:00 - 11:30:00
-    {TradingStatus::ContinuousTrading, 34200000000000UL, 41400000000000},
-    // Continuous Auction (Afternoon): 13:00:00 - 14:57:00
-    {TradingStatus::ContinuousTrading, 46800000000000UL, 53820000000000UL},
-    // Closing Call Auction: 14:57:00 - 15:00:00
-    {TradingStatus::CallAuction, 53820000000000UL, 54000000000000UL},
-};
-
-const std::vector<std::tuple<TradingStatus, uint64_t, uint64_t>> HKEX_SECURITIES_FULL_DAY_TRADING_SCHEDULE = {
-    // Opening Call Auction: 09:00:00 - 09:30:00
-    {TradingStatus::CallAuction, 32400000000000UL, 34200000000000UL},
-    // Continuous Auction (Morning): 09:30:00 - 12:00:00
-    {TradingStatus::ContinuousTrading, 34200000000000UL, 43200000000000UL},
-    // Continuous Auction (Extended Morning): 12:00:00 - 13:00:00
-    {TradingStatus::ContinuousTrading, 43200000000000UL, 46800000000000UL},
-    // Continuous Auction (Afternoon): 13:00:00 - 16:00:00
-    {TradingStatus::ContinuousTrading, 46800000000000UL, 57600000000000UL},
-    // Closing Call Auction: 16:00:00 - 16:10:00
-    {TradingStatus::CallAuction, 57600000000000UL, 58200000000000UL},
-};
-
-const std::vector<std::tuple<TradingStatus, uint64_t, uint64_t>> HKEX_SECURITIES_HALF_DAY_TRADING_SCHEDULE = {
-    // Opening Call Auction: 09:00:00 - 09:30:00
-    {TradingStatus::CallAuction, 32400000000000UL, 34200000000000UL},
-    // Continuous Auction (Morning): 09:30:00 - 12:00:00
-    {TradingStatus::ContinuousTrading, 34200000000000UL, 43200000000000UL},
-    // Closing Call Auction: 12:00:00 - 12:10:00
-    {TradingStatus::CallAuction, 43200000000000UL, 43800000000000UL},
-};
+template <typename Book>
+class MultiBookReplay;
 
+template <typename Market, typename Observer = NullObserver>
 class LimitOrderBook {
-    typedef std::tuple<TradingStatus, uint64_t, uint64_t> TradingHour;
+    template <typename Book>
+    friend class MultiBookReplay;
 
     TradingStatus status = TradingStatus::ContinuousTrading;
     std::vector<TradingHour> schedule;
-    size_t decimal_places;
-    double scale_up, scale_down;
 
-    std::shared_ptr<Treap<Limit>> bid_limits, ask_limits;
-    std::shared_ptr<Limit> bid_best_limit, ask_best_limit;  // TODO: get best limit in O(1) time
-    std::unordered_map<uint64_t, std::shared_ptr<Limit>> bid_price_map, ask_price_map;
-    std::unordered_map<uint64_t, std::shared_ptr<Order>> uid_order_map;
+    static constexpr size_t decimal_places = Market::decimal_places;
+    static constexpr uint64_t scale = pow10(decimal_places);
+    static constexpr double scale_up = scale, scale_down = 1.0 / scale_up;
+
+    // every per-day object of the book lives in the arena, clear() simply rewinds it. The nodes and
+    // buckets of the maps and the Fenwick trees of the queues come from a pool on top of it, which
+    // reuses the blocks freed during the day.
+    MonotonicArena arena;
+    std::pmr::unsynchronized_pool_resource pool;
+    ObjectPool<Order> order_pool;
+    ObjectPool<Limit> limit_pool;
+    ObjectPool<Node<Limit>> tree_node_pool;
+    ObjectPool<QueueIndex> queue_pool;
+
+    Treap<Limit> bid_limits, ask_limits;
+    std::pmr::unordered_map<uint64_t, Limit*> bid_price_map, ask_price_map;
+    std::pmr::unordered_map<uint64_t, Order*> uid_order_map;
+    // levels whose quantity changed since the subtree aggregates above them were refreshed,
+    // the refresh is deferred to the next depth query, see sync()
+    std::vector<Limit*> stale_limits;
 
-    std::deque<Transaction> transactions;
+    RecordLog<Transaction, CompactTransaction> transactions;
+    TradeDetails trade_details;
+    // the incoming order of the last continuous trade and the levels it has traded through, a
+    // market order walks the book through several match() calls at one timestamp
+    uint64_t sweep_uid, sweep_timestamp, sweep_price;
+    uint32_t sweep_level;
     std::deque<Tick> ticks;
-    std::deque<Quote> quotes;
+    RecordLog<Quote, CompactQuote> quotes;
+    // set by stream_transactions() / stream_ticks(), the records are only kept in memory as well
+    // when asked to
+    std::unique_ptr<StreamWriter<Transaction, TransactionEncoder>> transaction_stream;
+    std::unique_ptr<StreamWriter<Tick, TickEncoder>> tick_stream;
+    bool keep_transactions, keep_ticks;
+    // time travel, see book_at(): run() copies the quotes it writes, strategy quotes included, to
+    // `history` and records the resting orders every `checkpoint_interval` nanoseconds of market time
+    uint64_t checkpoint_interval, next_checkpoint;
+    size_t current_period;  // index in the expanded schedule of the period run() is in
+    bool checkpointing;
+    RecordLog<Quote, CompactQuote> history;
+    std::vector<BookCheckpoint> checkpoints;
+    size_t checkpoint_bytes;  // of all checkpoints, kept as they are taken
+    // full depth dumps taken by run() at the scheduled times (absolute after begin_run()), kept in
+    // memory or written to `l3_file`
+    std::vector<uint64_t> l3_schedule, l3_times;
+    size_t l3_next;
+    std::unique_ptr<L3FileWriter> l3_file;
+    std::vector<L3Snapshot> l3_snapshots;
+    size_t l3_bytes;  // of all snapshots
+    L3Snapshot l3_buffer;
 
     uint64_t open, high, low, close, volume, amount;
+    BarAggregator bars;
+    FeatureSet features;
     size_t topk;
     uint64_t start_of_day, snapshot_gap;
+    uint64_t now;  // timestamp of the quote being processed
+    Observer observer;
+    size_t peak_memory;
+#ifdef FLOB_STATS
+    BookStats statistics;
+    PerfCounters perf;
+#endif
+
+    // strategy orders wait in `pending` until their simulated arrival, see submit()
+    struct PendingQuote {
+        uint64_t arrival, sequence;
+        uint64_t uid, price, quantity;
+        Side side;
+        QuoteType type;
+        bool operator>(const PendingQuote& other) const { return std::make_pair(arrival, sequence) > std::make_pair(other.arrival, other.sequence); }
+    };
+    std::priority_queue<PendingQuote, std::vector<PendingQuote>, std::greater<PendingQuote>> pending;
+    uint64_t strategy_sequence;
+    uint64_t latency, latency_jitter;
+    std::mt19937_64 latency_rng;
+    RecordLog<Transaction, CompactTransaction> fills;
+    std::pmr::unordered_map<uint64_t, uint64_t> consumed;  // market uid -> quantity taken by strategy orders
+    // once strategy orders entered the book the replay diverges from the recorded market: quotes
+    // may refer to orders that were filled differently, they are clamped or ignored instead of failing
+    bool diverged;
 
     void write_limit_order(const Quote& quote);
     void write_market_order(const Quote& quote);
     void write_best_price_order(const Quote& quote);
     void write_cancel_order(const Quote& quote);
     void write_fill_order(const Quote& quote);
+    void write_modify_order(const Quote& quote);
     void write_chinext_limit_order(const Quote& quote);  // TODO: Support ChiNext Market
     void write_chinext_cancel_order(const Quote& quote);
-    void track_transaction(const Transaction& transaction);
+    void track_transaction(const Transaction& transaction, uint8_t aggressor);
+    void trade(Order* ask_order, Order* bid_order, uint64_t quantity, uint64_t price, uint64_t timestamp);
+    inline void fill(Order* order, uint64_t quantity);
+    void release_pending(uint64_t timestamp, bool inclusive);
+    void write_strategy(const Quote& quote);
+    inline uint64_t unconsumed(uint64_t uid, uint64_t quantity);
+
+    Limit* insert_limit(Side side, uint64_t price);
+    inline void notify_level(Limit* limit) { observer.on_level_change(limit->side, limit->price, limit->quantity, now); }
+    Order* indexed_order(uint64_t uid);
+    void release_limit(Limit* limit);
+    inline void touch(Limit* limit);
+    inline void untouch(Limit* limit);
+    void sync();
+    uint64_t quantity_below(Side side, uint64_t price, bool inclusive);
+    void collect_topk(Side side, size_t k, std::vector<double>& prices, std::vector<uint64_t>& volumes);
 
+    inline void track_queue(Limit* limit);
+    template <typename Map>
+    static size_t map_bytes(const Map& map) { return map.size() * (sizeof(void*) + sizeof(typename Map::value_type)) + map.bucket_count() * sizeof(void*); }
+    std::vector<TradingHour> expand_schedule() const;
+    std::vector<TradingHour> begin_run();
+    void end_run();
+    inline void step();
+    inline uint64_t next_timestamp() const { return quotes.empty() ? std::numeric_limits<uint64_t>::max() : quotes.front().timestamp; }
+    // pulls the next quote and the best levels, what the next step is likely to touch, into the cache
+    inline void prefetch() const {
+        quotes.prefetch_front();
+        if (bid_limits.last)
+            __builtin_prefetch(bid_limits.last->value_ptr);
+        if (ask_limits.first)
+            __builtin_prefetch(ask_limits.first->value_ptr);
+    }
+    void checkpoint(uint64_t timestamp);
+    void restore(const BookCheckpoint& checkpoint);
+    void take_l3_dumps(uint64_t timestamp);
     void on_period_start(TradingStatus status, uint64_t timestamp);
     void on_period_end(TradingStatus status, uint64_t timestamp);
     void execute(std::tuple<TradingStatus, uint64_t, uint64_t>& period);
 
-    inline uint64_t double2int(double value) { return (uint64_t)(value * scale_up); }
-    inline double int2double(uint64_t value) { return (double)value * scale_down; }
-    inline std::string int2string(uint64_t value) {
-        uint64_t scale = (uint64_t)pow(10, decimal_places);
+    static inline uint64_t double2int(double value) { return (uint64_t)(value * scale_up + 0.5); }
+    static inline double int2double(uint64_t value) { return (double)value * scale_down; }
+    static inline std::string int2string(uint64_t value) {
         std::string integer_part = std::to_string(value / scale);
         std::string fractional_part = std::to_string(value % scale);
         fractional_part = std::string(decimal_places - fractional_part.size(), '0') + fractional_part;
         return integer_part + "." + fractional_part;
     }
+    // reads a .csv or .bin quote file, calls `f(quote)` for every quote
+    template <typename F>
+    static void read_quotes(const std::string& filename, bool header, F f);
+    size_t finish_load();
     inline uint64_t shift_timestamp(uint64_t timestamp) { return timestamp < nanoseconds_per_day ? timestamp + start_of_day : timestamp; }
 
    public:
-    LimitOrderBook(size_t decimal_places = 2, uint64_t snapshot_gap = 0, size_t topk = 5, const std::string& schedule = "AShare")
-        : decimal_places(decimal_places),
-          scale_up(std::pow(10, decimal_places)),
-          scale_down(1.0 / scale_up),
-          bid_limits(std::make_shared<Treap<Limit>>(Treap<Limit>())),
-          ask_limits(std::make_shared<Treap<Limit>>(Treap<Limit>())),
-          bid_best_limit(nullptr),
-          ask_best_limit(nullptr),
+    typedef Market market_type;
+    typedef Observer observer_type;
+
+    // uids of strategy orders have the highest bit set, they never collide with market data
+    static constexpr uint64_t strategy_uid_flag = 1UL << 63;
+    static constexpr bool is_strategy(uint64_t uid) { return uid & strategy_uid_flag; }
+
+    LimitOrderBook(uint64_t snapshot_gap = 0, size_t topk = 5, const std::string& schedule = Market::name)
+        : pool(&arena),
+          order_pool(arena),
+          limit_pool(arena),
+          tree_node_pool(arena),
+          queue_pool(arena),
+          bid_limits(tree_node_pool),
+          ask_limits(tree_node_pool),
+          bid_price_map(&pool),
+          ask_price_map(&pool),
+          uid_order_map(&pool),
+          sweep_uid(0),
+          sweep_timestamp(0),
+          sweep_price(0),
+          sweep_level(0),
+          keep_transactions(true),
+          keep_ticks(true),
+          checkpoint_interval(0),
+          next_checkpoint(0),
+          current_period(0),
+          checkpointing(false),
+          checkpoint_bytes(0),
+          l3_next(0),
+          l3_bytes(0),
           open(0),
           high(0),
           low(0),
           close(0),
           volume(0),
           amount(0),
+          bars(scale_down),
           topk(topk),
-          start_of_day(0) {
+          start_of_day(0),
+          now(0),
+          peak_memory(0),
+          strategy_sequence(0),
+          latency(0),
+          latency_jitter(0),
+          consumed(&pool),
+          diverged(false) {
         set_schedule(schedule);
         set_snapshot_gap(snapshot_gap);
     }
@@ -117,25 +244,83 @@ class LimitOrderBook {
     void write(const Quote& quote);
     void trade(uint64_t ask_uid, uint64_t bid_uid, uint64_t quantity, uint64_t price = 0, uint64_t timestamp = 0);
 
+    void set_latency(uint64_t latency, uint64_t jitter = 0, uint64_t seed = 0);
+    uint64_t submit(Side side, uint64_t price, uint64_t quantity, uint64_t timestamp);
+    void cancel(uint64_t uid, uint64_t timestamp);
+
     void set_status(TradingStatus status) { this->status = status; }
     void set_status(const std::string& status);
     void set_schedule(const std::vector<TradingHour>& schedule) { this->schedule = schedule; }
     void set_schedule(const std::string& schedule);
 
     void set_snapshot_gap(uint64_t snapshot_gap) { this->snapshot_gap = snapshot_gap; }
+    void set_bar_frequencies(const std::vector<uint64_t>& frequencies, bool vwap = false, bool count = false) { bars.set_frequencies(frequencies, vwap, count); }
+    void set_features(const std::vector<std::string>& names) { features.set(names); }
+    std::vector<std::string> get_feature_names() const { return features.names(); }
 
     void match(uint64_t ref_price = 0, uint64_t timestamp = 0);
     void match_call_auction(uint64_t timestamp = 0);
+    void snapshot(uint64_t timestamp);
 
     void show(size_t n = 10);
     void show_transactions(size_t n = 10);
 
     size_t load(const std::string& filename, bool header = true);
+    // appends a quote to the loaded day, as load() does for every quote of a file
+    void append(const Quote& quote) {
+        if (quotes.empty() && start_of_day == 0)
+            start_of_day = quote.timestamp - quote.timestamp % nanoseconds_per_day;
+        quotes.push_back(quote);
+    }
+    // Loads several quote files at once, e.g. the channels of one feed, each in time order. Every
+    // file is decoded on its own thread and the quotes are merged by (timestamp, uid) through a
+    // ReorderBuffer instead of a sort, see reorder.hpp. Throws std::runtime_error when a file is out
+    // of time order, the quotes behind the merge are dropped.
+    size_t load(const std::vector<std::string>& filenames, bool header = true);
     void until(uint64_t timestamp);
     void run();
 
-    std::vector<Transaction> get_transactions() const { return std::vector<Transaction>(transactions.begin(), transactions.end()); }
+    // Streams the transactions / ticks to a .csv or .bin file from a background thread, see
+    // stream_writer.hpp. Only a bounded buffer stays in memory unless `keep` is set, the buffer is
+    // handed over at the end of every trading period and run() returns once the file is written.
+    // Set the features before streaming ticks. The files stay open across clear() until
+    // close_streams(), the next call or the destruction of the book, an empty filename closes one.
+    void stream_transactions(const std::string& filename, bool keep = false);
+    void stream_ticks(const std::string& filename, bool keep = false);
+    void close_streams();
+
+    // Time travel: with a positive interval run() keeps a copy of the quotes it writes and records
+    // the resting orders every `interval` nanoseconds of market time (0 turns it off, set it before
+    // run()). book_at() then returns a new book as it was right after the quotes up to `timestamp`
+    // (absolute, or since midnight): the nearest earlier checkpoint is restored and only the quotes
+    // since are replayed, period ends included. Strategy orders that reached the book by then are
+    // part of it, with what they took from market orders; the ones still on their way are not.
+    void set_checkpoint_interval(uint64_t interval) { checkpoint_interval = interval; }
+    std::unique_ptr<LimitOrderBook> book_at(uint64_t timestamp) const;
+    size_t checkpoint_count() const { return checkpoints.size(); }
+
+    // Full depth order by order (L3): every level and every resting order in queue order, into the
+    // columns of `snapshot`, whose capacity is reused. The timestamp defaults to the last quote.
+    void dump_l3(L3Snapshot& snapshot, uint64_t timestamp = 0) const;
+    L3Snapshot dump_l3(uint64_t timestamp = 0) const {
+        L3Snapshot snapshot;
+        dump_l3(snapshot, timestamp);
+        return snapshot;
+    }
+    // Schedules L3 dumps inside run() at the given times (absolute, or since midnight), each sees
+    // the quotes up to and including its time; a dump at the end of a call auction is taken before
+    // the auction match, unlike book_at(). They are kept in memory (get_l3_snapshots()) or
+    // written to a binary L3 file, see l3.hpp. An empty schedule turns it off.
+    void schedule_l3(const std::vector<uint64_t>& times, const std::string& filename = "");
+    const std::vector<L3Snapshot>& get_l3_snapshots() const { return l3_snapshots; }
+
+    std::vector<Transaction> get_transactions() const { return transactions.to_vector(); }
+    // aggressor side, sweep level, level depletion and queue age of every transaction in memory
+    const TradeDetails& get_trade_details() const { return trade_details; }
     std::vector<Tick> get_ticks() const { return std::vector<Tick>(ticks.begin(), ticks.end()); }
+    std::vector<Transaction> get_fills() const { return fills.to_vector(); }
+    Observer& get_observer() { return observer; }
+    const Bars& get_bars(uint64_t frequency) const { return bars.get(frequency); }
 
     std::vector<double> get_topk_bid_price(size_t k, bool fill = false);
     std::vector<double> get_topk_ask_price(size_t k, bool fill = false);
@@ -145,54 +330,228 @@ class LimitOrderBook {
     double get_kth_ask_price(size_t k);
     uint64_t get_kth_bid_volume(size_t k);
     uint64_t get_kth_ask_volume(size_t k);
+
+    // depth queries, O(log n) in the number of price levels; depth_within_ticks() adds O(log n) in
+    // the ticks for every band of the spread table it crosses, see ticks_above()
+    uint64_t depth_between(Side side, double lo, double hi);
+    uint64_t volume_to_price(Side side, double price);
+    double price_for_volume(Side side, uint64_t quantity);
+    uint64_t depth_within_ticks(Side side, size_t n);
+
+    // position of a resting order in its level queue, O(log n) in the length of the queue
+    uint64_t queue_ahead(uint64_t uid);
+    size_t queue_position(uint64_t uid);
+
+    // latency histograms, counters and per-phase hardware counters, see stats.hpp
+    BookStats stats();
+    void reset_stats();
+
+    // Compact mode keeps the loaded quotes, the transactions and the fills as 32-byte records with
+    // 32-bit prices and quantities, records that do not fit throw. Set it while the book is empty.
+    void set_compact(bool compact);
+    bool is_compact() const { return quotes.is_compact(); }
+    MemoryUsage memory_usage();
 };
 
-void LimitOrderBook::on_period_start(TradingStatus status, uint64_t timestamp) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::on_period_start(TradingStatus status, uint64_t timestamp) {
     ;
 }
 
-void LimitOrderBook::on_period_end(TradingStatus status, uint64_t timestamp) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::on_period_end(TradingStatus status, uint64_t timestamp) {
+    if (l3_next < l3_times.size())
+        take_l3_dumps(timestamp + 1);  // the times up to the end, before the call auction match
     switch (status) {
         case TradingStatus::CallAuction:
             match_call_auction(timestamp);
             break;
 
         case TradingStatus::Snapshot:
-            ticks.emplace_back(timestamp,
-                               open == 0 ? std::nan("") : int2double(open),
-                               high == 0 ? std::nan("") : int2double(high),
-                               low == 0 ? std::nan("") : int2double(low),
-                               close == 0 ? std::nan("") : int2double(close),
-                               volume,
-                               amount,
-                               get_topk_bid_price(topk, true),
-                               get_topk_ask_price(topk, true),
-                               get_topk_bid_volume(topk, true),
-                               get_topk_ask_volume(topk, true));
-            open = high = low = volume = amount = 0;
+            snapshot(timestamp);
             break;
 
         default:
             break;
     }
+    bars.flush(timestamp);
+    observer.on_period_end(status, timestamp);
+    if (transaction_stream)
+        transaction_stream->flush();
+    if (tick_stream)
+        tick_stream->flush();
 }
 
-void LimitOrderBook::set_schedule(const std::string& schedule) {
-    if (schedule == "AShare")
-        this->schedule = CHINA_A_SHARE_TRADING_SCHEDULE;
-    else
-        throw std::invalid_argument("Unknown trading schedule: " + schedule);
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::stream_transactions(const std::string& filename, bool keep) {
+    if (transaction_stream)
+        std::exchange(transaction_stream, nullptr)->close();
+    keep_transactions = true;
+    if (filename.empty())
+        return;
+    transaction_stream.reset(new StreamWriter<Transaction, TransactionEncoder>(filename, TransactionEncoder(is_binary_quote_file(filename), decimal_places)));
+    keep_transactions = keep;
 }
 
-void LimitOrderBook::execute(std::tuple<TradingStatus, uint64_t, uint64_t>& period) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::stream_ticks(const std::string& filename, bool keep) {
+    if (tick_stream)
+        std::exchange(tick_stream, nullptr)->close();
+    keep_ticks = true;
+    if (filename.empty())
+        return;
+    tick_stream.reset(new StreamWriter<Tick, TickEncoder>(filename, TickEncoder(is_binary_quote_file(filename), decimal_places, topk, features.names())));
+    keep_ticks = keep;
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::close_streams() {
+    stream_transactions("");
+    stream_ticks("");
+}
+
+// appends a tick with the OHLCV since the previous tick and the current top-k levels
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::snapshot(uint64_t timestamp) {
+    FLOB_TIMED(statistics.snapshot);
+    std::vector<double> bid_prices, ask_prices;
+    std::vector<uint64_t> bid_volumes, ask_volumes;
+    collect_topk(Side::Bid, topk, bid_prices, bid_volumes);
+    collect_topk(Side::Ask, topk, ask_prices, ask_volumes);
+    std::vector<double> values;
+    if (!features.empty())
+        values = features.snapshot(bid_prices, ask_prices, bid_volumes, ask_volumes);
+    Tick tick(timestamp,
+              open == 0 ? std::nan("") : int2double(open),
+              high == 0 ? std::nan("") : int2double(high),
+              low == 0 ? std::nan("") : int2double(low),
+              close == 0 ? std::nan("") : int2double(close),
+              volume,
+              amount,
+              bid_prices,
+              ask_prices,
+              bid_volumes,
+              ask_volumes,
+              values);
+    if (tick_stream)
+        tick_stream->push(tick);
+    if (!tick_stream || keep_ticks)
+        ticks.push_back(tick);
+    observer.on_snapshot(tick);
+    open = high = low = volume = amount = 0;
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::set_schedule(const std::string& schedule) {
+    this->schedule = Market::schedule(schedule);
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::execute(std::tuple<TradingStatus, uint64_t, uint64_t>& period) {
+#ifdef FLOB_STATS
+    uint64_t before[3], after[3];
+    perf.read(before);
+    auto start = std::chrono::steady_clock::now();
+#endif
     on_period_start(std::get<0>(period), shift_timestamp(std::get<1>(period)));
     set_status(std::get<0>(period));
     until(std::get<2>(period));
     on_period_end(std::get<0>(period), shift_timestamp(std::get<2>(period)));
+    memory_usage();  // tracks the peak
+#ifdef FLOB_STATS
+    perf.read(after);
+    auto& phase = statistics.phases[std::get<0>(period)];
+    ++phase.count;
+    phase.nanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+    phase.cycles += after[0] - before[0];
+    phase.instructions += after[1] - before[1];
+    phase.cache_misses += after[2] - before[2];
+#endif
+}
+
+template <typename Market, typename Observer>
+BookStats LimitOrderBook<Market, Observer>::stats() {
+    BookStats result;
+#ifdef FLOB_STATS
+    result = statistics;
+    result.enabled = true;
+    result.perf_available = perf.available();
+#endif
+    result.resting_orders = uid_order_map.size();
+    result.bid_levels = bid_limits.size();
+    result.ask_levels = ask_limits.size();
+    result.bid_tree_height = bid_limits.height();
+    result.ask_tree_height = ask_limits.height();
+    return result;
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::set_compact(bool compact) {
+    if (!quotes.empty() || !transactions.empty() || !fills.empty() || !history.empty())
+        throw std::runtime_error("the compact mode can only change while the book holds no records");
+    quotes.set_compact(compact);
+    history.set_compact(compact);
+    transactions.set_compact(compact);
+    fills.set_compact(compact);
 }
 
-std::vector<double> LimitOrderBook::get_topk_bid_price(size_t k, bool fill) {
-    auto nodes = bid_limits->nlargest(k);
+template <typename Market, typename Observer>
+MemoryUsage LimitOrderBook<Market, Observer>::memory_usage() {
+    MemoryUsage usage;
+    usage.orders = order_pool.size() * sizeof(Order);
+    usage.levels = limit_pool.size() * sizeof(Limit);
+    usage.tree_nodes = tree_node_pool.size() * sizeof(Node<Limit>);
+    usage.queue_indexes = queue_pool.size() * sizeof(QueueIndex);
+    usage.hash_maps = map_bytes(bid_price_map) + map_bytes(ask_price_map) + map_bytes(uid_order_map) + map_bytes(consumed);
+    usage.arena_used = arena.size();
+    usage.arena_reserved = arena.capacity();
+    usage.quotes = quotes.bytes();
+    usage.transactions = transactions.bytes() + trade_details.bytes();
+    usage.fills = fills.bytes();
+    usage.ticks = ticks.size() * (sizeof(Tick) + topk * 2 * (sizeof(double) + sizeof(uint64_t)) + features.size() * sizeof(double));
+    usage.pending = pending.size() * sizeof(PendingQuote) + stale_limits.capacity() * sizeof(Limit*);
+    usage.streams = (transaction_stream ? transaction_stream->bytes() : 0) + (tick_stream ? tick_stream->bytes() : 0);
+    usage.checkpoints = history.bytes() + checkpoint_bytes;
+    usage.l3 = l3_bytes;
+    usage.total = usage.arena_reserved + usage.quotes + usage.transactions + usage.fills + usage.ticks + usage.pending + usage.streams + usage.checkpoints + usage.l3;
+    peak_memory = std::max(peak_memory, usage.total);
+    usage.peak = peak_memory;
+    return usage;
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::reset_stats() {
+#ifdef FLOB_STATS
+    statistics = BookStats();
+#endif
+}
+
+// the longest level queue and the most resting orders seen so far
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::track_queue(Limit* limit) {
+#ifdef FLOB_STATS
+    statistics.max_queue_length = std::max<uint64_t>(statistics.max_queue_length, limit->orders.size);
+    statistics.max_resting_orders = std::max<uint64_t>(statistics.max_resting_orders, uid_order_map.size());
+#endif
+}
+
+// best `k` levels of one side in a single walk along the level thread, padded to `k`
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::collect_topk(Side side, size_t k, std::vector<double>& prices, std::vector<uint64_t>& volumes) {
+    prices.reserve(k);
+    volumes.reserve(k);
+    auto node = side == Side::Bid ? bid_limits.max() : ask_limits.min();
+    for (; node && prices.size() < k; node = side == Side::Bid ? node->prev() : node->next()) {
+        prices.push_back(int2double(node->value().price));
+        volumes.push_back(node->value().quantity);
+    }
+    prices.resize(k, std::nan(""));
+    volumes.resize(k, 0);
+}
+
+template <typename Market, typename Observer>
+std::vector<double> LimitOrderBook<Market, Observer>::get_topk_bid_price(size_t k, bool fill) {
+    auto nodes = bid_limits.nlargest(k);
     std::vector<double> prices;
     for (auto& node : nodes)
         prices.push_back(int2double(node->value().price));
@@ -202,8 +561,9 @@ std::vector<double> LimitOrderBook::get_topk_bid_price(size_t k, bool fill) {
     return prices;
 }
 
-std::vector<double> LimitOrderBook::get_topk_ask_price(size_t k, bool fill) {
-    auto nodes = ask_limits->nsmallest(k);
+template <typename Market, typename Observer>
+std::vector<double> LimitOrderBook<Market, Observer>::get_topk_ask_price(size_t k, bool fill) {
+    auto nodes = ask_limits.nsmallest(k);
     std::vector<double> prices;
     for (auto& node : nodes)
         prices.push_back(int2double(node->value().price));
@@ -213,8 +573,9 @@ std::vector<double> LimitOrderBook::get_topk_ask_price(size_t k, bool fill) {
     return prices;
 }
 
-std::vector<uint64_t> LimitOrderBook::get_topk_bid_volume(size_t k, bool fill) {
-    auto nodes = bid_limits->nlargest(k);
+template <typename Market, typename Observer>
+std::vector<uint64_t> LimitOrderBook<Market, Observer>::get_topk_bid_volume(size_t k, bool fill) {
+    auto nodes = bid_limits.nlargest(k);
     std::vector<uint64_t> quantities;
     for (auto& node : nodes)
         quantities.push_back(node->value().quantity);
@@ -224,8 +585,9 @@ std::vector<uint64_t> LimitOrderBook::get_topk_bid_volume(size_t k, bool fill) {
     return quantities;
 }
 
-std::vector<uint64_t> LimitOrderBook::get_topk_ask_volume(size_t k, bool fill) {
-    auto nodes = ask_limits->nsmallest(k);
+template <typename Market, typename Observer>
+std::vector<uint64_t> LimitOrderBook<Market, Observer>::get_topk_ask_volume(size_t k, bool fill) {
+    auto nodes = ask_limits.nsmallest(k);
     std::vector<uint64_t> quantities;
     for (auto& node : nodes)
         quantities.push_back(node->value().quantity);
@@ -235,36 +597,180 @@ std::vector<uint64_t> LimitOrderBook::get_topk_ask_volume(size_t k, bool fill) {
     return quantities;
 }
 
-double LimitOrderBook::get_kth_bid_price(size_t k) {
-    auto node = bid_limits->kth_largest(k);
+template <typename Market, typename Observer>
+double LimitOrderBook<Market, Observer>::get_kth_bid_price(size_t k) {
+    auto node = bid_limits.kth_largest(k);
     return node ? int2double(node->value().price) : 0;
 }
 
-double LimitOrderBook::get_kth_ask_price(size_t k) {
-    auto node = ask_limits->kth_smallest(k);
+template <typename Market, typename Observer>
+double LimitOrderBook<Market, Observer>::get_kth_ask_price(size_t k) {
+    auto node = ask_limits.kth_smallest(k);
     return node ? int2double(node->value().price) : 0;
 }
 
-uint64_t LimitOrderBook::get_kth_bid_volume(size_t k) {
-    auto node = bid_limits->kth_largest(k);
+template <typename Market, typename Observer>
+uint64_t LimitOrderBook<Market, Observer>::get_kth_bid_volume(size_t k) {
+    auto node = bid_limits.kth_largest(k);
     return node ? node->value().quantity : 0;
 }
 
-uint64_t LimitOrderBook::get_kth_ask_volume(size_t k) {
-    auto node = ask_limits->kth_smallest(k);
+template <typename Market, typename Observer>
+uint64_t LimitOrderBook<Market, Observer>::get_kth_ask_volume(size_t k) {
+    auto node = ask_limits.kth_smallest(k);
     return node ? node->value().quantity : 0;
 }
 
-void LimitOrderBook::clear() {
-    bid_limits->clear();
-    ask_limits->clear();
-    uid_order_map.clear();
-    bid_best_limit = nullptr;
-    ask_best_limit = nullptr;
-    open = high = low = close = volume = 0;
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::touch(Limit* limit) {
+    if (limit->stale != Limit::not_stale)
+        return;
+    limit->stale = stale_limits.size();
+    stale_limits.push_back(limit);
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::untouch(Limit* limit) {
+    if (limit->stale == Limit::not_stale)
+        return;
+    Limit* last = stale_limits.back();
+    last->stale = limit->stale;
+    stale_limits[limit->stale] = last;
+    stale_limits.pop_back();
+    limit->stale = Limit::not_stale;
+}
+
+// Refreshes `sum_quantity`/`count_orders` along the path from every touched level to the root.
+// Nodes whose subtree holds no touched level are always exact (structural changes of the treap
+// update the nodes they move), so after this every aggregate is exact again.
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::sync() {
+    for (auto limit : stale_limits) {
+        for (auto node = limit->node; node; node = node->parent)
+            node->update();
+        limit->stale = Limit::not_stale;
+    }
+    stale_limits.clear();
+}
+
+// total quantity of the levels on `side` priced below (or at, if `inclusive`) the given price
+template <typename Market, typename Observer>
+uint64_t LimitOrderBook<Market, Observer>::quantity_below(Side side, uint64_t price, bool inclusive) {
+    sync();
+    uint64_t quantity = 0;
+    auto node = side == Side::Bid ? bid_limits.root : ask_limits.root;
+    while (node) {
+        if (node->value().price < price || (inclusive && node->value().price == price)) {
+            quantity += node->value().quantity + (node->left ? node->left->sum_quantity : 0);
+            node = node->right;
+        } else {
+            node = node->left;
+        }
+    }
+    return quantity;
+}
+
+// total quantity resting on `side` with a price in [lo, hi]
+template <typename Market, typename Observer>
+uint64_t LimitOrderBook<Market, Observer>::depth_between(Side side, double lo, double hi) {
+    uint64_t lo_price = double2int(lo), hi_price = double2int(hi);
+    if (lo_price > hi_price)
+        return 0;
+    return quantity_below(side, hi_price, true) - quantity_below(side, lo_price, false);
+}
+
+// cumulative quantity from the best price of `side` through the given price
+template <typename Market, typename Observer>
+uint64_t LimitOrderBook<Market, Observer>::volume_to_price(Side side, double price) {
+    if (side == Side::Ask)
+        return quantity_below(side, double2int(price), true);
+    sync();
+    uint64_t total = bid_limits.root ? bid_limits.root->sum_quantity : 0;
+    return total - quantity_below(side, double2int(price), false);
+}
+
+// price of the level at which the cumulative quantity from the best price of `side` reaches
+// `quantity`, NaN if the whole side holds less
+template <typename Market, typename Observer>
+double LimitOrderBook<Market, Observer>::price_for_volume(Side side, uint64_t quantity) {
+    sync();
+    quantity = std::max<uint64_t>(quantity, 1);  // zero asks for the best level
+    auto node = side == Side::Bid ? bid_limits.root : ask_limits.root;
+    while (node) {
+        // walk from the best price: ascending for asks, descending for bids
+        auto near = side == Side::Bid ? node->right : node->left;
+        auto far = side == Side::Bid ? node->left : node->right;
+        uint64_t before = near ? near->sum_quantity : 0;
+        if (quantity <= before) {
+            node = near;
+        } else if (quantity <= before + node->value().quantity) {
+            return int2double(node->value().price);
+        } else {
+            quantity -= before + node->value().quantity;
+            node = far;
+        }
+    }
+    return std::nan("");
+}
+
+// total quantity of `side` priced within `n` ticks of its best price, the best level included
+template <typename Market, typename Observer>
+uint64_t LimitOrderBook<Market, Observer>::depth_within_ticks(Side side, size_t n) {
+    if (side == Side::Bid ? bid_limits.empty() : ask_limits.empty())
+        return 0;
+    if (side == Side::Bid) {
+        uint64_t price = ticks_below<Market>(bid_limits.max()->value().price, n);
+        sync();
+        return bid_limits.root->sum_quantity - quantity_below(side, price, false);
+    } else {
+        return quantity_below(side, ticks_above<Market>(ask_limits.min()->value().price, n), true);
+    }
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::clear() {
+    memory_usage();  // tracks the peak
+    // the maps hand their nodes back to the pool, then the object pools forget their free lists,
+    // the pool releases its blocks to the arena (a no-op) and the arena rewinds to its first chunk
+    bid_limits.clear();
+    ask_limits.clear();
+    std::pmr::unordered_map<uint64_t, Limit*>(&pool).swap(bid_price_map);
+    std::pmr::unordered_map<uint64_t, Limit*>(&pool).swap(ask_price_map);
+    std::pmr::unordered_map<uint64_t, Order*>(&pool).swap(uid_order_map);
+    std::pmr::unordered_map<uint64_t, uint64_t>(&pool).swap(consumed);
+    order_pool.reset();
+    limit_pool.reset();
+    tree_node_pool.reset();
+    queue_pool.reset();
+    pool.release();
+    arena.reset();
+    stale_limits.clear();
+
+    transactions.clear();
+    trade_details.clear();
+    sweep_uid = sweep_timestamp = sweep_price = 0;
+    sweep_level = 0;
+    ticks.clear();
+    quotes.clear();
+    fills.clear();
+    history.clear();
+    checkpoints.clear();
+    checkpoint_bytes = 0;
+    l3_snapshots.clear();
+    l3_bytes = 0;
+    pending = decltype(pending)();
+    strategy_sequence = 0;
+    diverged = false;
+    bars.clear();
+    features.clear();
+    status = TradingStatus::ContinuousTrading;
+    open = high = low = close = volume = amount = 0;
+    start_of_day = 0;
+    now = 0;
 }
 
-void LimitOrderBook::set_status(const std::string& status) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::set_status(const std::string& status) {
     assert(status == "CallAuction" || status == "ContinuousTrading" || status == "ClosingAuction");
     if (status == "CallAuction" || status == "ClosingAuction")
         this->status = TradingStatus::CallAuction;
@@ -272,7 +778,12 @@ void LimitOrderBook::set_status(const std::string& status) {
         this->status = TradingStatus::ContinuousTrading;
 }
 
-void LimitOrderBook::write(const Quote& quote) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::write(const Quote& quote) {
+    if (!Market::allows(quote.type))
+        throw std::invalid_argument(std::string("quote type is not allowed in ") + Market::name);
+    FLOB_TIMED(statistics.quotes[quote.type]);
+    now = quote.timestamp;
     switch (quote.type) {
         case QuoteType::LimitOrder:
             write_limit_order(quote);
@@ -289,134 +800,300 @@ void LimitOrderBook::write(const Quote& quote) {
         case QuoteType::FillOrder:
             write_fill_order(quote);
             break;
+        case QuoteType::ModifyOrder:
+            write_modify_order(quote);
+            break;
     }
 }
 
-void LimitOrderBook::write_limit_order(const Quote& quote) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::write_limit_order(const Quote& quote) {
     assert(quote.type == QuoteType::LimitOrder);
-    // create order
-    auto order = std::make_shared<Order>(quote.uid, quote.price, quote.quantity, quote.timestamp);
-
     if (uid_order_map.find(quote.uid) != uid_order_map.end())
         throw std::runtime_error("order already exists");
+
+    // create order
+    auto order = order_pool.create(quote.uid, quote.quantity, quote.timestamp);
     uid_order_map[quote.uid] = order;
+    auto limit = insert_limit(quote.side, quote.price);
+    limit->insert(order);
+    FLOB_COUNT(track_queue(limit));
+    notify_level(limit);
+    if (status == TradingStatus::ContinuousTrading)
+        match();
+}
 
-    auto& limits = quote.side == Side::Bid ? bid_limits : ask_limits;
-    auto& price_map = quote.side == Side::Bid ? bid_price_map : ask_price_map;
+template <typename Market, typename Observer>
+Limit* LimitOrderBook<Market, Observer>::insert_limit(Side side, uint64_t price) {
+    auto& limits = side == Side::Bid ? bid_limits : ask_limits;
+    auto& price_map = side == Side::Bid ? bid_price_map : ask_price_map;
 
-    auto limit = price_map[quote.price];
+    auto& limit = price_map[price];
     if (!limit) {
-        limit = std::make_shared<Limit>(quote.price, quote.side);
-        limits->insert(limit);
-        price_map[quote.price] = limit;
+        limit = limit_pool.create(price, side);
+        limit->node = limits.insert(limit);
+        FLOB_COUNT(++statistics.levels_created);
+    }
+    touch(limit);  // the caller is about to add quantity
+    return limit;
+}
+
+// resting order by uid, the queue index of its level is built on first use and maintained afterwards
+template <typename Market, typename Observer>
+Order* LimitOrderBook<Market, Observer>::indexed_order(uint64_t uid) {
+    auto it = uid_order_map.find(uid);
+    if (it == uid_order_map.end())
+        throw std::runtime_error("order does not exist: " + std::to_string(uid));
+    auto limit = it->second->limit;
+    if (!limit->queue) {
+        limit->queue = queue_pool.create(&pool);
+        limit->queue->rebuild(limit->orders);
+    }
+    return it->second;
+}
+
+// resting quantity ahead of the order in its level queue
+template <typename Market, typename Observer>
+uint64_t LimitOrderBook<Market, Observer>::queue_ahead(uint64_t uid) {
+    auto order = indexed_order(uid);
+    return order->limit->queue->quantity.prefix(order->slot);
+}
+
+// number of resting orders ahead of the order in its level queue, 0 for the front of the queue
+template <typename Market, typename Observer>
+size_t LimitOrderBook<Market, Observer>::queue_position(uint64_t uid) {
+    auto order = indexed_order(uid);
+    return order->limit->queue->count.prefix(order->slot);
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::release_limit(Limit* limit) {
+    auto& limits = limit->side == Side::Bid ? bid_limits : ask_limits;
+    auto& price_map = limit->side == Side::Bid ? bid_price_map : ask_price_map;
+
+    while (!limit->orders.empty() && limit->orders.front()->quantity == 0)
+        order_pool.destroy(limit->orders.pop_front());
+    notify_level(limit);
+    if (limit->quantity == 0) {
+        untouch(limit);
+        limits.remove(*limit);
+        price_map.erase(limit->price);
+        if (limit->queue)
+            queue_pool.destroy(limit->queue);
+        limit_pool.destroy(limit);
+        FLOB_COUNT(++statistics.levels_destroyed);
+    } else {
+        touch(limit);
     }
-    limit->insert(order);
-    if (status == TradingStatus::ContinuousTrading)
-        match();
 }
 
-void LimitOrderBook::write_market_order(const Quote& quote) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::write_market_order(const Quote& quote) {
     assert(quote.type == QuoteType::MarketOrder);
     assert(status == TradingStatus::ContinuousTrading);
-    if ((quote.side == Side::Bid && ask_limits->empty()) || (quote.side == Side::Ask && bid_limits->empty()))
+    if ((quote.side == Side::Bid && ask_limits.empty()) || (quote.side == Side::Ask && bid_limits.empty()))
         return;
-    uint64_t price = quote.side == Side::Bid ? ask_limits->min()->value().price : bid_limits->max()->value().price;
-    uint64_t quantity = quote.side == Side::Bid ? ask_limits->min()->value().quantity : bid_limits->max()->value().quantity;
+    uint64_t price = quote.side == Side::Bid ? ask_limits.min()->value().price : bid_limits.max()->value().price;
+    uint64_t quantity = quote.side == Side::Bid ? ask_limits.min()->value().quantity : bid_limits.max()->value().quantity;
     quantity = std::min(quantity, quote.quantity);
     write_limit_order(Quote(quote.uid, price, quantity, quote.timestamp, quote.side, LimitOrder));
     if (quote.quantity > quantity)
         write_market_order(Quote(quote.uid, 0, quote.quantity - quantity, quote.timestamp, quote.side, MarketOrder));
 }
 
-void LimitOrderBook::write_best_price_order(const Quote& quote) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::write_best_price_order(const Quote& quote) {
     assert(quote.type == QuoteType::BestPriceOrder);
     assert(status == TradingStatus::ContinuousTrading);
-    if ((quote.side == Side::Bid && bid_limits->empty()) || (quote.side == Side::Ask && ask_limits->empty()))
+    if ((quote.side == Side::Bid && bid_limits.empty()) || (quote.side == Side::Ask && ask_limits.empty()))
         return;
-    uint64_t price = quote.side == Side::Bid ? bid_limits->max()->value().price : ask_limits->min()->value().price;
+    uint64_t price = quote.side == Side::Bid ? bid_limits.max()->value().price : ask_limits.min()->value().price;
     write_limit_order(Quote(quote.uid, price, quote.quantity, quote.timestamp, quote.side, LimitOrder));
 }
 
-void LimitOrderBook::write_cancel_order(const Quote& quote) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::write_cancel_order(const Quote& quote) {
     assert(quote.type == QuoteType::CancelOrder);
-    auto& limits = quote.side == Side::Bid ? bid_limits : ask_limits;
-    auto& price_map = quote.side == Side::Bid ? bid_price_map : ask_price_map;
-    if (uid_order_map.find(quote.uid) == uid_order_map.end())
+    auto it = uid_order_map.find(quote.uid);
+    if (it == uid_order_map.end()) {
+        if (diverged)
+            return;
         throw std::runtime_error("trying to cancel non-existing order: " + std::to_string(quote.uid));
-    auto order = uid_order_map[quote.uid];
-    auto limit = order->limit.lock();
+    }
+    auto order = it->second;
+    auto limit = order->limit;
     assert(limit);
-    limit->quantity -= quote.quantity;
-    order->quantity -= quote.quantity;
+    limit->reduce(order, diverged ? std::min(quote.quantity, order->quantity) : quote.quantity);
     if (order->quantity == 0)
-        uid_order_map.erase(quote.uid);
-    while (!limit->orders.empty() && limit->orders.front()->quantity == 0)
-        limit->orders.pop_front();
-    if (limit->quantity == 0) {
-        limits->remove(*limit);
-        price_map.erase(limit->price);
-    }
+        uid_order_map.erase(it);
+    release_limit(limit);
 }
 
-void LimitOrderBook::write_fill_order(const Quote& quote) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::write_fill_order(const Quote& quote) {
     assert(quote.type == QuoteType::FillOrder);
-    auto& limits = quote.side == Side::Bid ? bid_limits : ask_limits;
-    auto& price_map = quote.side == Side::Bid ? bid_price_map : ask_price_map;
-    auto order = uid_order_map[quote.uid];
-    auto limit = order->limit.lock();
+    auto it = uid_order_map.find(quote.uid);
+    if (it == uid_order_map.end()) {
+        if (diverged)
+            return;
+        throw std::runtime_error("trying to fill non-existing order: " + std::to_string(quote.uid));
+    }
+    auto order = it->second;
+    auto limit = order->limit;
     assert(limit);
-    limit->quantity -= quote.quantity;
-    order->quantity -= quote.quantity;
+    limit->reduce(order, diverged ? std::min(quote.quantity, order->quantity) : quote.quantity);
     if (order->quantity == 0)
         uid_order_map.erase(quote.uid);
-    while (!limit->orders.empty() && limit->orders.front()->quantity == 0)
-        limit->orders.pop_front();
-    if (limit->quantity == 0) {
-        limits->remove(*limit);
-        price_map.erase(limit->price);
+    release_limit(limit);
+}
+
+// Amend of a resting order, `quote.price` is the new price (0 keeps the current one) and
+// `quote.quantity` the new remaining quantity. Reducing the quantity keeps the queue position,
+// a price change or a quantity increase moves the order to the back of the target level.
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::write_modify_order(const Quote& quote) {
+    assert(quote.type == QuoteType::ModifyOrder);
+    auto it = uid_order_map.find(quote.uid);
+    if (it == uid_order_map.end()) {
+        if (diverged)
+            return;
+        throw std::runtime_error("trying to modify non-existing order: " + std::to_string(quote.uid));
+    }
+    auto order = it->second;
+    auto limit = order->limit;
+    assert(limit);
+    uint64_t price = quote.price == 0 ? limit->price : quote.price;
+    uint64_t quantity = diverged ? unconsumed(quote.uid, quote.quantity) : quote.quantity;
+
+    if (quantity == 0 || (price == limit->price && quantity <= order->quantity)) {
+        limit->reduce(order, order->quantity - quantity);
+        if (order->quantity == 0)
+            uid_order_map.erase(it);
+        release_limit(limit);
+        return;
     }
+
+    // the old record stays in its queue with zero quantity until it reaches the front
+    auto moved = order_pool.create(quote.uid, quantity, quote.timestamp);
+    limit->reduce(order, order->quantity);
+    it->second = moved;
+    auto target = insert_limit(limit->side, price);
+    target->insert(moved);
+    FLOB_COUNT(track_queue(target));
+    notify_level(target);
+    release_limit(limit);
+    if (status == TradingStatus::ContinuousTrading)
+        match();
 }
 
-void LimitOrderBook::track_transaction(const Transaction& transaction) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::track_transaction(const Transaction& transaction, uint8_t aggressor) {
     open = open == 0 ? transaction.price : open;
     high = high == 0 ? transaction.price : std::max(high, transaction.price);
     low = low == 0 ? transaction.price : std::min(low, transaction.price);
     close = transaction.price;
     volume += transaction.quantity;
     amount += transaction.price * transaction.quantity;
+    bars.track(transaction.timestamp, transaction.price, transaction.quantity);
+    features.track(transaction, aggressor);
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::trade(uint64_t ask_uid, uint64_t bid_uid, uint64_t quantity, uint64_t price, uint64_t timestamp) {
+    auto ask = uid_order_map.find(ask_uid), bid = uid_order_map.find(bid_uid);
+    if (ask == uid_order_map.end() || bid == uid_order_map.end())
+        throw std::runtime_error("trying to trade non-existing order");
+    trade(ask->second, bid->second, quantity, price, timestamp);
 }
 
-void LimitOrderBook::trade(uint64_t ask_uid, uint64_t bid_uid, uint64_t quantity, uint64_t price, uint64_t timestamp) {
-    auto ask_order = uid_order_map[ask_uid];
-    auto bid_order = uid_order_map[bid_uid];
-    if (price == 0)
-        price = ask_uid < bid_uid ? ask_order->price : bid_order->price;
+// a trade between two resting orders, `quantity` is at most what is left of either
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::trade(Order* ask_order, Order* bid_order, uint64_t quantity, uint64_t price, uint64_t timestamp) {
+    uint64_t ask_uid = ask_order->uid, bid_uid = bid_order->uid;
+    bool strategy = is_strategy(ask_uid) || is_strategy(bid_uid);
+    // the resting order sets the price: the earlier uid for market data, strategy orders are
+    // stamped with their arrival time and come after market quotes of the same timestamp
+    bool ask_rests = ask_uid < bid_uid;
+    if (strategy)
+        ask_rests = ask_order->timestamp != bid_order->timestamp ? ask_order->timestamp < bid_order->timestamp
+                    : is_strategy(ask_uid) != is_strategy(bid_uid) ? is_strategy(bid_uid)
+                                                                   : ask_uid < bid_uid;
+    bool continuous = price == 0;  // a call auction gives the price, neither side is the aggressor
+    if (continuous)
+        price = ask_rests ? ask_order->price() : bid_order->price();
     if (timestamp == 0)
         timestamp = std::max(ask_order->timestamp, bid_order->timestamp);
-    transactions.emplace_back(bid_uid, ask_uid, price, quantity, timestamp, int2double(price));
-    track_transaction(transactions.back());
-    write_fill_order(Quote(ask_uid, price, quantity, timestamp, Side::Ask, FillOrder));
-    write_fill_order(Quote(bid_uid, price, quantity, timestamp, Side::Bid, FillOrder));
-}
-
-void LimitOrderBook::match(uint64_t ref_price, uint64_t timestamp) {
-    while (!ask_limits->empty() && !bid_limits->empty() && ask_limits->min()->value().price <= bid_limits->max()->value().price) {
-        Limit& ask_limit = ask_limits->min()->value();
-        Limit& bid_limit = bid_limits->max()->value();
-        std::shared_ptr<Order>& ask_order = ask_limit.orders.front();
-        std::shared_ptr<Order>& bid_order = bid_limit.orders.front();
+    if (strategy) {
+        // simulated fills stay out of the market data: no transaction, no OHLC, no bars
+        Transaction fill(bid_uid, ask_uid, price, quantity, timestamp);
+        fills.push_back(fill);
+        if (!is_strategy(ask_uid))
+            consumed[ask_uid] += quantity;
+        if (!is_strategy(bid_uid))
+            consumed[bid_uid] += quantity;
+        observer.on_fill(fill);
+    } else {
+        Transaction transaction(bid_uid, ask_uid, price, quantity, timestamp);
+        uint8_t aggressor = continuous ? (ask_rests ? Side::Bid : Side::Ask) : TradeDetails::no_aggressor;
+        if (transaction_stream)
+            transaction_stream->push(transaction);
+        if (!transaction_stream || keep_transactions) {
+            transactions.push_back(transaction);
+            Order* resting = ask_rests ? ask_order : bid_order;
+            uint32_t sweep = 0;
+            if (continuous) {
+                uint64_t incoming = ask_rests ? bid_uid : ask_uid;
+                uint64_t arrival = ask_rests ? bid_order->timestamp : ask_order->timestamp;
+                if (incoming != sweep_uid || arrival != sweep_timestamp) {
+                    sweep_uid = incoming;
+                    sweep_timestamp = arrival;
+                    sweep_level = 0;
+                } else if (price != sweep_price) {
+                    ++sweep_level;
+                }
+                sweep_price = price;
+                sweep = sweep_level;
+            }
+            trade_details.push_back(aggressor, sweep, resting->limit->quantity == quantity, timestamp - resting->timestamp);
+        }
+        track_transaction(transaction, aggressor);
+        observer.on_trade(transaction);
+    }
+    fill(ask_order, quantity);
+    fill(bid_order, quantity);
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::fill(Order* order, uint64_t quantity) {
+    auto limit = order->limit;
+    limit->reduce(order, quantity);
+    if (order->quantity == 0)
+        uid_order_map.erase(order->uid);
+    release_limit(limit);
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::match(uint64_t ref_price, uint64_t timestamp) {
+    FLOB_TIMED(statistics.match);
+    while (!ask_limits.empty() && !bid_limits.empty() && ask_limits.min()->value().price <= bid_limits.max()->value().price) {
+        Limit& ask_limit = ask_limits.min()->value();
+        Limit& bid_limit = bid_limits.max()->value();
+        Order* ask_order = ask_limit.orders.front();
+        Order* bid_order = bid_limit.orders.front();
         uint64_t quantity = std::min(ask_order->quantity, bid_order->quantity);
-        trade(ask_order->uid, bid_order->uid, quantity, ref_price, timestamp);
+        trade(ask_order, bid_order, quantity, ref_price, timestamp);
     }
 }
 
-void LimitOrderBook::match_call_auction(uint64_t timestamp)  // TODO: auto parse input timestamp
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::match_call_auction(uint64_t timestamp)  // TODO: auto parse input timestamp
 {
+    FLOB_TIMED(statistics.match_call_auction);
     uint64_t ref_price = 0;
     uint64_t ask_cum_quantity = 0, bid_cum_quantity = 0;
-    std::shared_ptr<Node<Limit>> ask_node, bid_node;
-    ask_node = ask_limits->min();
-    bid_node = bid_limits->max();
+    Node<Limit> *ask_node, *bid_node;
+    ask_node = ask_limits.min();
+    bid_node = bid_limits.max();
     if (!ask_node || !bid_node)
         return;
     while (ask_node && bid_node && (ask_node->value().price <= ref_price || ref_price <= bid_node->value().price)) {
@@ -437,13 +1114,13 @@ void LimitOrderBook::match_call_auction(uint64_t timestamp)  // TODO: auto parse
     if (ask_cum_quantity == bid_cum_quantity) {
         ask_node = ask_node->prev();
         bid_node = bid_node->next();
-        ref_price = ask_node->value().price + bid_node->value().price;
-        ref_price = (ref_price >> 1) + ((ref_price & 2) ? (ref_price & 1) : 0);
+        ref_price = Market::auction_price(ask_node->value().price, bid_node->value().price);
     }
     match(ref_price, timestamp);
 }
 
-void LimitOrderBook::show(size_t n) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::show(size_t n) {
     auto table = Table<std::string, uint64_t>({"Price", "Quantity"});
 
     auto topk_ask_price = get_topk_ask_price(n);
@@ -466,18 +1143,24 @@ void LimitOrderBook::show(size_t n) {
     table.print(std::cout);
 }
 
-void LimitOrderBook::show_transactions(size_t n) {
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::show_transactions(size_t n) {
     auto table = Table<std::string, std::string, uint64_t>({"Timestamp", "Price", "Quantity"});
     for (size_t i = std::max(0, (int)transactions.size() - (int)n); i < transactions.size(); ++i)
         table.add_row(strftime(transactions[i].timestamp, "%H:%M:%S"), int2string(transactions[i].price), transactions[i].quantity);
     table.print(std::cout);
 }
 
-size_t LimitOrderBook::load(const std::string& filename, bool header) {
-    std::cout << "Loading " << filename << "..." << std::endl;
+template <typename Market, typename Observer>
+template <typename F>
+void LimitOrderBook<Market, Observer>::read_quotes(const std::string& filename, bool header, F f) {
+    if (is_binary_quote_file(filename)) {
+        read_binary_quotes(filename, decimal_places, f);
+        return;
+    }
     // check it is a csv file
     if (filename.substr(filename.find_last_of(".") + 1) != "csv")
-        throw std::runtime_error("file is not a csv file");
+        throw std::runtime_error("file is not a csv or bin file");
 
     // open file
     std::ifstream file(filename);
@@ -503,49 +1186,338 @@ size_t LimitOrderBook::load(const std::string& filename, bool header) {
         Side side = static_cast<Side>(std::stoi(record[4]));
         QuoteType type = static_cast<QuoteType>(std::stoi(record[5]));
 
-        quotes.emplace_back(uid, price, quantity, timestamp, side, type);
+        f(Quote(uid, price, quantity, timestamp, side, type));
     }
+}
+
+template <typename Market, typename Observer>
+size_t LimitOrderBook<Market, Observer>::finish_load() {
     start_of_day = quotes.empty() ? 0 : quotes.front().timestamp - quotes.front().timestamp % nanoseconds_per_day;
     std::cout << "read " << quotes.size() << " quotes" << std::endl;
+    memory_usage();
     return quotes.size();
 }
 
-void LimitOrderBook::until(uint64_t timestamp) {
+template <typename Market, typename Observer>
+size_t LimitOrderBook<Market, Observer>::load(const std::string& filename, bool header) {
+    std::cout << "Loading " << filename << "..." << std::endl;
+    read_quotes(filename, header, [&](const Quote& quote) { quotes.push_back(quote); });
+    return finish_load();
+}
+
+template <typename Market, typename Observer>
+size_t LimitOrderBook<Market, Observer>::load(const std::vector<std::string>& filenames, bool header) {
+    std::cout << "Loading " << filenames.size() << " files..." << std::endl;
+    if (filenames.empty())
+        return finish_load();
+    ReorderBuffer buffer(filenames.size());
+    std::vector<std::exception_ptr> errors(filenames.size());
+    std::vector<std::thread> decoders;
+    for (size_t i = 0; i < filenames.size(); ++i)
+        decoders.emplace_back([&, i] {
+            try {
+                read_quotes(filenames[i], header, [&](const Quote& quote) { buffer.push(i, quote); });
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            buffer.close(i);
+        });
+    buffer.run([&](const Quote& quote) { quotes.push_back(quote); });
+    for (auto& decoder : decoders)
+        decoder.join();
+    for (auto& error : errors)
+        if (error)
+            std::rethrow_exception(error);
+    // refuse a day with dropped quotes rather than replay it
+    if (buffer.late_count() > 0 || !buffer.get_gaps().empty()) {
+        std::string message = std::to_string(buffer.late_count()) + " quotes out of time order";
+        for (auto& gap : buffer.get_gaps())
+            message += ", sequences " + std::to_string(gap.expected) + " to " + std::to_string(gap.received - 1) + " missing";
+        throw std::runtime_error(message);
+    }
+    return finish_load();
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::until(uint64_t timestamp) {
     const uint64_t oneday = 24UL * 60UL * 60UL * 1000000000UL;  // unit: nanosecond
     if (quotes.empty())
         return;
     timestamp = quotes.front().timestamp - (quotes.front().timestamp % oneday) + timestamp;
-    while (!quotes.empty() && quotes.front().timestamp <= timestamp) {
-        write(quotes.front());
-        quotes.pop_front();
-    }
-}
-
-void LimitOrderBook::run() {
-    if (snapshot_gap != 0) {
-        std::vector<TradingHour> tmp(schedule.begin(), schedule.end());
-        schedule.clear();
-        for (auto& period : tmp) {
-            if (std::get<0>(period) == TradingStatus::CallAuction) {
-                schedule.emplace_back(TradingStatus::CallAuction, std::get<1>(period), std::get<2>(period));
-                schedule.emplace_back(TradingStatus::Snapshot, std::get<2>(period), std::get<2>(period));
-            } else if (std::get<0>(period) == TradingStatus::ContinuousTrading) {
-                for (uint64_t t = std::get<1>(period); t < std::get<2>(period); t += snapshot_gap) {
-                    schedule.emplace_back(TradingStatus::ContinuousTrading, t, t + snapshot_gap);
-                    schedule.emplace_back(TradingStatus::Snapshot, t + snapshot_gap, t + snapshot_gap);
-                }
-                if ((std::get<2>(period) - std::get<1>(period)) % snapshot_gap != 0) {
-                    schedule.emplace_back(TradingStatus::ContinuousTrading, std::get<2>(period) - (std::get<2>(period) - std::get<1>(period)) % snapshot_gap, std::get<2>(period));
-                    schedule.emplace_back(TradingStatus::Snapshot, std::get<2>(period), std::get<2>(period));
-                }
-            } else {
-                schedule.emplace_back(std::get<0>(period), std::get<1>(period), std::get<2>(period));
+    while (!quotes.empty() && quotes.front().timestamp <= timestamp)
+        step();
+    if (!pending.empty())
+        release_pending(timestamp, true);
+}
+
+// writes the next loaded quote, after the strategy orders that reach the book before it
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::step() {
+    if (l3_next < l3_times.size() && l3_times[l3_next] < quotes.front().timestamp)
+        take_l3_dumps(quotes.front().timestamp);
+    if (!pending.empty())
+        release_pending(quotes.front().timestamp, false);
+    if (checkpointing) {
+        if (quotes.front().timestamp >= next_checkpoint)
+            checkpoint(quotes.front().timestamp);
+        history.push_back(quotes.front());
+    }
+    write(quotes.front());
+    quotes.pop_front();
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::set_latency(uint64_t latency, uint64_t jitter, uint64_t seed) {
+    this->latency = latency;
+    this->latency_jitter = jitter;
+    latency_rng.seed(seed);
+}
+
+// Submits a strategy limit order decided at `timestamp`, it reaches the book after the simulated
+// latency: `latency` plus a uniform jitter in [0, jitter]. Returns the uid of the order.
+template <typename Market, typename Observer>
+uint64_t LimitOrderBook<Market, Observer>::submit(Side side, uint64_t price, uint64_t quantity, uint64_t timestamp) {
+    uint64_t arrival = shift_timestamp(timestamp) + latency + (latency_jitter ? latency_rng() % (latency_jitter + 1) : 0);
+    uint64_t uid = strategy_uid_flag | ++strategy_sequence;
+    pending.push({arrival, strategy_sequence, uid, price, quantity, side, QuoteType::LimitOrder});
+    return uid;
+}
+
+// Cancels whatever is left of a strategy order when the cancel arrives, a no-op if the order is
+// filled by then
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::cancel(uint64_t uid, uint64_t timestamp) {
+    if (!is_strategy(uid))
+        throw std::invalid_argument("not a strategy order: " + std::to_string(uid));
+    uint64_t arrival = shift_timestamp(timestamp) + latency + (latency_jitter ? latency_rng() % (latency_jitter + 1) : 0);
+    pending.push({arrival, ++strategy_sequence, uid, 0, 0, Side::Bid, QuoteType::CancelOrder});
+}
+
+// writes the strategy quotes arriving before (or at, if `inclusive`) the given timestamp
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::release_pending(uint64_t timestamp, bool inclusive) {
+    while (!pending.empty() && (pending.top().arrival < timestamp || (inclusive && pending.top().arrival == timestamp))) {
+        PendingQuote quote = pending.top();
+        pending.pop();
+        diverged = true;
+        if (quote.type == QuoteType::CancelOrder) {
+            auto it = uid_order_map.find(quote.uid);
+            if (it != uid_order_map.end())
+                write_strategy(Quote(quote.uid, 0, it->second->quantity, quote.arrival, quote.side, QuoteType::CancelOrder));
+        } else {
+            write_strategy(Quote(quote.uid, quote.price, quote.quantity, quote.arrival, quote.side, quote.type));
+        }
+    }
+}
+
+// writes a strategy quote as it reaches the book, book_at() replays it after the market quotes
+// written before it
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::write_strategy(const Quote& quote) {
+    if (checkpointing)
+        history.push_back(quote);
+    write(quote);
+}
+
+// quantity of an amended market order net of what strategy orders took from it
+template <typename Market, typename Observer>
+uint64_t LimitOrderBook<Market, Observer>::unconsumed(uint64_t uid, uint64_t quantity) {
+    auto it = consumed.find(uid);
+    if (it == consumed.end())
+        return quantity;
+    return quantity > it->second ? quantity - it->second : 0;
+}
+
+// the schedule with every continuous trading period cut into slices of `snapshot_gap`, each
+// followed by a snapshot
+template <typename Market, typename Observer>
+std::vector<TradingHour> LimitOrderBook<Market, Observer>::expand_schedule() const {
+    if (snapshot_gap == 0)
+        return schedule;
+    std::vector<TradingHour> periods;
+    for (auto& period : schedule) {
+        if (std::get<0>(period) == TradingStatus::CallAuction) {
+            periods.emplace_back(TradingStatus::CallAuction, std::get<1>(period), std::get<2>(period));
+            periods.emplace_back(TradingStatus::Snapshot, std::get<2>(period), std::get<2>(period));
+        } else if (std::get<0>(period) == TradingStatus::ContinuousTrading) {
+            for (uint64_t t = std::get<1>(period); t < std::get<2>(period); t += snapshot_gap) {
+                periods.emplace_back(TradingStatus::ContinuousTrading, t, t + snapshot_gap);
+                periods.emplace_back(TradingStatus::Snapshot, t + snapshot_gap, t + snapshot_gap);
+            }
+            if ((std::get<2>(period) - std::get<1>(period)) % snapshot_gap != 0) {
+                periods.emplace_back(TradingStatus::ContinuousTrading, std::get<2>(period) - (std::get<2>(period) - std::get<1>(period)) % snapshot_gap, std::get<2>(period));
+                periods.emplace_back(TradingStatus::Snapshot, std::get<2>(period), std::get<2>(period));
             }
+        } else {
+            periods.emplace_back(std::get<0>(period), std::get<1>(period), std::get<2>(period));
         }
     }
+    return periods;
+}
+
+// prepares a replay of the loaded day, returns its periods
+template <typename Market, typename Observer>
+std::vector<TradingHour> LimitOrderBook<Market, Observer>::begin_run() {
+#ifdef FLOB_STATS
+    perf.open();  // the counters follow the thread that replays
+#endif
+    bars.reset(schedule, start_of_day);
+    checkpointing = checkpoint_interval > 0;
+    next_checkpoint = 0;
+    l3_times.clear();
+    for (auto time : l3_schedule)
+        l3_times.push_back(shift_timestamp(time));
+    std::sort(l3_times.begin(), l3_times.end());
+    l3_next = 0;
+    return expand_schedule();
+}
 
-    for (auto& period : schedule)
-        execute(period);
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::end_run() {
+    checkpointing = false;
+    take_l3_dumps(std::numeric_limits<uint64_t>::max());  // the times after the last quote
+    if (l3_file)
+        l3_file->flush();
+    if (transaction_stream)
+        transaction_stream->drain();
+    if (tick_stream)
+        tick_stream->drain();
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::run() {
+    // expand into a local copy so that the book can run again on the next day
+    std::vector<TradingHour> periods = begin_run();
+    for (current_period = 0; current_period < periods.size(); ++current_period)
+        execute(periods[current_period]);
+    end_run();
+}
+
+// records the resting orders before the quote at `timestamp` is written
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::checkpoint(uint64_t timestamp) {
+    BookCheckpoint checkpoint{timestamp, history.size(), current_period, status, {}, {}, diverged, {consumed.begin(), consumed.end()}};
+    checkpoint.levels.reserve(bid_limits.size() + ask_limits.size());
+    checkpoint.orders.reserve(uid_order_map.size());
+    for (auto limits : {&bid_limits, &ask_limits})
+        for (auto node = limits->first; node; node = node->next()) {
+            auto& limit = node->value();
+            size_t count = checkpoint.orders.size();
+            for (auto order = limit.orders.head; order; order = order->next)
+                if (order->quantity > 0)
+                    checkpoint.orders.push_back({order->uid, order->quantity, order->timestamp});
+            checkpoint.levels.push_back({limit.price, limit.side, checkpoint.orders.size() - count});
+        }
+    checkpoint_bytes += checkpoint.bytes();
+    checkpoints.push_back(std::move(checkpoint));
+    next_checkpoint = timestamp - timestamp % checkpoint_interval + checkpoint_interval;
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::dump_l3(L3Snapshot& snapshot, uint64_t timestamp) const {
+    snapshot.clear();
+    snapshot.timestamp = timestamp ? timestamp : now;
+    snapshot.level_price.reserve(bid_limits.size() + ask_limits.size());
+    snapshot.order_uid.reserve(uid_order_map.size());
+    for (auto limits : {&bid_limits, &ask_limits})
+        for (auto node = limits->first; node; node = node->next()) {
+            auto& limit = node->value();
+            size_t count = snapshot.order_uid.size();
+            for (auto order = limit.orders.head; order; order = order->next)
+                if (order->quantity > 0) {
+                    snapshot.order_uid.push_back(order->uid);
+                    snapshot.order_quantity.push_back(order->quantity);
+                    snapshot.order_timestamp.push_back(order->timestamp);
+                }
+            snapshot.level_price.push_back(limit.price);
+            snapshot.level_quantity.push_back(limit.quantity);
+            snapshot.level_orders.push_back(snapshot.order_uid.size() - count);
+            snapshot.level_side.push_back(limit.side);
+        }
+}
+
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::schedule_l3(const std::vector<uint64_t>& times, const std::string& filename) {
+    l3_schedule = times;
+    l3_file.reset(filename.empty() ? nullptr : new L3FileWriter(filename, decimal_places));
+}
+
+// takes the scheduled dumps before `timestamp`, with the strategy orders that arrived by then
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::take_l3_dumps(uint64_t timestamp) {
+    for (; l3_next < l3_times.size() && l3_times[l3_next] < timestamp; ++l3_next) {
+        if (!pending.empty())
+            release_pending(l3_times[l3_next], true);
+        if (l3_file) {
+            dump_l3(l3_buffer, l3_times[l3_next]);
+            l3_file->write(l3_buffer);
+        } else {
+            l3_snapshots.emplace_back();
+            dump_l3(l3_snapshots.back(), l3_times[l3_next]);
+            l3_bytes += l3_snapshots.back().bytes();
+        }
+    }
+}
+
+// rebuilds the levels and queues of a checkpoint in an empty book
+template <typename Market, typename Observer>
+void LimitOrderBook<Market, Observer>::restore(const BookCheckpoint& checkpoint) {
+    std::vector<Limit*> levels[2];
+    uid_order_map.reserve(checkpoint.orders.size());
+    auto order = checkpoint.orders.begin();
+    for (auto& level : checkpoint.levels) {
+        auto limit = limit_pool.create(level.price, level.side);
+        (level.side == Side::Bid ? bid_price_map : ask_price_map)[level.price] = limit;
+        for (size_t i = 0; i < level.orders; ++i, ++order) {
+            auto resting = order_pool.create(order->uid, order->quantity, order->timestamp);
+            uid_order_map[order->uid] = resting;
+            limit->insert(resting);
+        }
+        levels[level.side].push_back(limit);
+    }
+    bid_limits.build_from_sorted(levels[Side::Bid]);
+    ask_limits.build_from_sorted(levels[Side::Ask]);
+    for (auto limits : {&bid_limits, &ask_limits})
+        for (auto node = limits->first; node; node = node->next())
+            node->value().node = node;
+    status = checkpoint.status;
+    diverged = checkpoint.diverged;
+    consumed.insert(checkpoint.consumed.begin(), checkpoint.consumed.end());
+}
+
+template <typename Market, typename Observer>
+std::unique_ptr<LimitOrderBook<Market, Observer>> LimitOrderBook<Market, Observer>::book_at(uint64_t timestamp) const {
+    if (checkpoints.empty())
+        throw std::runtime_error("no checkpoints, set a checkpoint interval before run()");
+    timestamp = timestamp < nanoseconds_per_day ? timestamp + start_of_day : timestamp;
+    auto it = std::upper_bound(checkpoints.begin(), checkpoints.end(), timestamp,
+                               [](uint64_t t, const BookCheckpoint& checkpoint) { return t < checkpoint.timestamp; });
+    const BookCheckpoint& checkpoint = it == checkpoints.begin() ? *it : *std::prev(it);
+
+    std::unique_ptr<LimitOrderBook> book(new LimitOrderBook(snapshot_gap, topk, Market::name));
+    book->set_schedule(schedule);
+    book->set_features(features.names());
+    book->set_compact(is_compact());
+    book->start_of_day = start_of_day;
+    book->restore(checkpoint);
+    book->strategy_sequence = strategy_sequence;  // new strategy orders do not reuse a uid
+    for (size_t i = checkpoint.quote; i < history.size() && history[i].timestamp <= timestamp; ++i) {
+        book->quotes.push_back(history[i]);
+        book->diverged |= is_strategy(history[i].uid);  // the market quotes before it never need the leniency
+    }
+
+    // replays the rest of the period of the checkpoint and the periods after it up to `timestamp`
+    auto periods = expand_schedule();
+    for (size_t i = checkpoint.period; i < periods.size(); ++i) {
+        auto& period = periods[i];
+        if (i > checkpoint.period)
+            book->set_status(std::get<0>(period));
+        book->until(std::min(std::get<2>(period), timestamp - start_of_day));
+        if (book->shift_timestamp(std::get<2>(period)) > timestamp)
+            break;
+        book->on_period_end(std::get<0>(period), book->shift_timestamp(std::get<2>(period)));
+    }
+    return book;
 }
 
 #endif  // __LIMIT_ORDER_BOOK_HPP__
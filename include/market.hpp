@@ -0,0 +1,150 @@
+#ifndef __MARKET_HPP__
+#define __MARKET_HPP__
+
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <vector>
+#include "struct.hpp"
+
+typedef std::tuple<TradingStatus, uint64_t, uint64_t> TradingHour;
+
+constexpr uint64_t pow10(size_t n) { return n == 0 ? 1 : 10 * pow10(n - 1); }
+
+const std::vector<TradingHour> CHINA_A_SHARE_TRADING_SCHEDULE = {
+    // Opening Call Auction: 09:15:00 - 09:25:00
+    {TradingStatus::CallAuction, 33300000000000UL, 33900000000000UL},
+    // Continuous Auction (Morning): 09:30:00 - 11:30:00
+    {TradingStatus::ContinuousTrading, 34200000000000UL, 41400000000000},
+    // Continuous Auction (Afternoon): 13:00:00 - 14:57:00
+    {TradingStatus::ContinuousTrading, 46800000000000UL, 53820000000000UL},
+    // Closing Call Auction: 14:57:00 - 15:00:00
+    {TradingStatus::CallAuction, 53820000000000UL, 54000000000000UL},
+};
+
+const std::vector<TradingHour> HKEX_SECURITIES_FULL_DAY_TRADING_SCHEDULE = {
+    // Opening Call Auction: 09:00:00 - 09:30:00
+    {TradingStatus::CallAuction, 32400000000000UL, 34200000000000UL},
+    // Continuous Auction (Morning): 09:30:00 - 12:00:00
+    {TradingStatus::ContinuousTrading, 34200000000000UL, 43200000000000UL},
+    // Continuous Auction (Extended Morning): 12:00:00 - 13:00:00
+    {TradingStatus::ContinuousTrading, 43200000000000UL, 46800000000000UL},
+    // Continuous Auction (Afternoon): 13:00:00 - 16:00:00
+    {TradingStatus::ContinuousTrading, 46800000000000UL, 57600000000000UL},
+    // Closing Call Auction: 16:00:00 - 16:10:00
+    {TradingStatus::CallAuction, 57600000000000UL, 58200000000000UL},
+};
+
+const std::vector<TradingHour> HKEX_SECURITIES_HALF_DAY_TRADING_SCHEDULE = {
+    // Opening Call Auction: 09:00:00 - 09:30:00
+    {TradingStatus::CallAuction, 32400000000000UL, 34200000000000UL},
+    // Continuous Auction (Morning): 09:30:00 - 12:00:00
+    {TradingStatus::ContinuousTrading, 34200000000000UL, 43200000000000UL},
+    // Closing Call Auction: 12:00:00 - 12:10:00
+    {TradingStatus::CallAuction, 43200000000000UL, 43800000000000UL},
+};
+
+// A market policy describes everything about a venue that is fixed at compile time:
+//   * decimal_places      number of decimal places of the integer price representation
+//   * tick_size(price)    minimum price increment at the given (integer) price
+//   * allows(type)        whether the venue accepts the quote type at all
+//   * auction_price(a, b) reference price of a call auction whose cumulative volumes
+//                         tie between the last matched ask price `a` and bid price `b`
+//   * schedule(name)      trading schedules known to the venue, the first is the default
+
+// Shanghai / Shenzhen A-Share, prices in 0.01 CNY
+struct AShare {
+    static constexpr const char* name = "AShare";
+    static constexpr size_t decimal_places = 2;
+
+    static constexpr uint64_t tick_size(uint64_t price) { return 1; }
+    static constexpr bool allows(QuoteType type) { return true; }
+    static constexpr uint64_t auction_price(uint64_t ask_price, uint64_t bid_price) {
+        uint64_t price = ask_price + bid_price;
+        return (price >> 1) + ((price & 2) ? (price & 1) : 0);
+    }
+    static const std::vector<TradingHour>& schedule(const std::string& name) {
+        if (name == "AShare")
+            return CHINA_A_SHARE_TRADING_SCHEDULE;
+        throw std::invalid_argument("Unknown trading schedule: " + name);
+    }
+};
+
+// Hong Kong securities market, prices in 0.001 HKD
+struct HKEX {
+    static constexpr const char* name = "HKEX";
+    static constexpr size_t decimal_places = 3;
+
+    // HKEX spread table (part A)
+    static constexpr uint64_t tick_size(uint64_t price) {
+        return price < 250 ? 1 : price < 500 ? 5 : price < 10000 ? 10 : price < 20000 ? 20 : price < 100000 ? 50 : price < 200000 ? 100 : price < 500000 ? 200 : price < 1000000 ? 500 : price < 2000000 ? 1000 : price < 5000000 ? 2000 : 5000;
+    }
+    // no market or best price orders in the continuous trading session
+    static constexpr bool allows(QuoteType type) {
+        return type == QuoteType::LimitOrder || type == QuoteType::CancelOrder || type == QuoteType::FillOrder || type == QuoteType::ModifyOrder;
+    }
+    // midpoint rounded down onto the spread table
+    static constexpr uint64_t auction_price(uint64_t ask_price, uint64_t bid_price) {
+        uint64_t price = (ask_price + bid_price) >> 1;
+        return price - price % tick_size(price);
+    }
+    static const std::vector<TradingHour>& schedule(const std::string& name) {
+        if (name == "HKEX" || name == "HKEXFullDay")
+            return HKEX_SECURITIES_FULL_DAY_TRADING_SCHEDULE;
+        if (name == "HKEXHalfDay")
+            return HKEX_SECURITIES_HALF_DAY_TRADING_SCHEDULE;
+        throw std::invalid_argument("Unknown trading schedule: " + name);
+    }
+};
+
+// Prices `n` ticks above and below `price` on the spread table of a market, in O(log n) per band of
+// one tick size: inside a band the move is n ticks at once, a band left on the way is crossed by
+// bisecting for its last tick. Tick sizes grow with the price, as on every venue's table.
+template <typename Market>
+uint64_t ticks_above(uint64_t price, uint64_t n) {
+    const uint64_t max = std::numeric_limits<uint64_t>::max();
+    while (n > 0) {
+        uint64_t tick = Market::tick_size(price);
+        if (n > (max - price) / tick)
+            return max;
+        // k ticks stay in the band when the last price they cross still has its tick size
+        auto within = [&](uint64_t k) { return Market::tick_size(price + tick * k - 1) == tick; };
+        if (within(n))
+            return price + tick * n;
+        uint64_t lo = 1, hi = n;  // within(lo), !within(hi), a price off the table moves one tick
+        if (within(lo))
+            while (hi - lo > 1) {
+                uint64_t mid = lo + (hi - lo) / 2;
+                (within(mid) ? lo : hi) = mid;
+            }
+        price += tick * lo;
+        n -= lo;
+    }
+    return price;
+}
+
+// stops at 0
+template <typename Market>
+uint64_t ticks_below(uint64_t price, uint64_t n) {
+    while (n > 0 && price > 0) {
+        uint64_t tick = Market::tick_size(price - 1);
+        if (price <= tick)
+            return 0;
+        auto within = [&](uint64_t k) { return k <= (price - 1) / tick && Market::tick_size(price - tick * k) == tick; };
+        if (within(n))
+            return price - tick * n;
+        uint64_t lo = 1, hi = n;
+        if (within(lo))
+            while (hi - lo > 1) {
+                uint64_t mid = lo + (hi - lo) / 2;
+                (within(mid) ? lo : hi) = mid;
+            }
+        price -= tick * lo;
+        n -= lo;
+    }
+    return price;
+}
+
+#endif  // __MARKET_HPP__
@@ -0,0 +1,86 @@
+#ifndef __MULTI_BOOK_HPP__
+#define __MULTI_BOOK_HPP__
+
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+#include "limit_order_book.hpp"
+#include "struct.hpp"
+
+// Replays the loaded days of several books on one thread in global timestamp order, e.g. an ETF
+// and its constituents. Within every trading period the next quotes of the books are merged by
+// (timestamp, book) and each is written to its book, so every book sees exactly the sequence its
+// own run() would. The period ends, call auction matching and snapshots included, happen for all
+// books at once, after which `on_period_end(status, timestamp)` sees a consistent cross section.
+//
+// The books must share one expanded schedule (market, schedule and snapshot gap). Per-phase
+// statistics of FLOB_STATS are only collected by run() of a single book.
+template <typename Book>
+class MultiBookReplay {
+    std::vector<Book*> books;
+
+   public:
+    MultiBookReplay(const std::vector<Book*>& books = {})
+        : books(books) {}
+    void add(Book& book) { books.push_back(&book); }
+    size_t size() const { return books.size(); }
+    const std::vector<Book*>& get_books() const { return books; }
+
+    void run() {
+        run([](TradingStatus, uint64_t) {});
+    }
+
+    template <typename F>
+    void run(F on_period_end) {
+        if (books.empty())
+            return;
+        std::vector<TradingHour> periods = books[0]->begin_run();
+        for (size_t i = 1; i < books.size(); ++i)
+            if (books[i]->begin_run() != periods)
+                throw std::invalid_argument("the books of a multi-book replay must share their schedule and snapshot gap");
+
+        typedef std::pair<uint64_t, size_t> Head;  // timestamp of the next quote, book
+        std::priority_queue<Head, std::vector<Head>, std::greater<Head>> heads;
+        std::vector<bool> loaded(books.size());
+        for (size_t p = 0; p < periods.size(); ++p) {
+            auto& period = periods[p];
+            for (size_t i = 0; i < books.size(); ++i) {
+                Book* book = books[i];
+                book->current_period = p;
+                book->on_period_start(std::get<0>(period), book->shift_timestamp(std::get<1>(period)));
+                book->set_status(std::get<0>(period));
+                loaded[i] = book->next_timestamp() != std::numeric_limits<uint64_t>::max();
+                // the end of the period is a time of day, each book has its own date
+                if (book->next_timestamp() <= book->shift_timestamp(std::get<2>(period)))
+                    heads.emplace(book->next_timestamp(), i);
+            }
+            while (!heads.empty()) {
+                Book* book = books[heads.top().second];
+                size_t index = heads.top().second;
+                heads.pop();
+                if (!heads.empty())
+                    books[heads.top().second]->prefetch();
+                book->step();
+                if (book->next_timestamp() <= book->shift_timestamp(std::get<2>(period)))
+                    heads.emplace(book->next_timestamp(), index);
+            }
+            for (size_t i = 0; i < books.size(); ++i) {
+                Book* book = books[i];
+                uint64_t end = book->shift_timestamp(std::get<2>(period));
+                if (loaded[i] && !book->pending.empty())  // as until() does
+                    book->release_pending(end, true);
+                book->on_period_end(std::get<0>(period), end);
+                book->memory_usage();  // tracks the peak
+            }
+            on_period_end(std::get<0>(period), books[0]->shift_timestamp(std::get<2>(period)));
+        }
+        for (auto book : books)
+            book->end_run();
+    }
+};
+
+#endif  // __MULTI_BOOK_HPP__
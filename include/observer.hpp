@@ -0,0 +1,131 @@
+#ifndef __OBSERVER_HPP__
+#define __OBSERVER_HPP__
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <vector>
+#include "struct.hpp"
+
+// An observer is the second template parameter of LimitOrderBook, its hooks are called inline
+// from the matching code, prices are integers in the market's scale:
+//   * on_trade(transaction)                             after every transaction
+//   * on_fill(transaction)                              after every fill of a strategy order
+//   * on_level_change(side, price, quantity, timestamp) after the quantity of a price level
+//                                                       changed, 0 when the level is gone
+//   * on_snapshot(tick)                                 after every tick
+//   * on_period_end(status, timestamp)                  after a trading period is processed
+
+// the default observer, every hook is empty and compiles away
+struct NullObserver {
+    inline void on_trade(const Transaction& transaction) {}
+    inline void on_fill(const Transaction& transaction) {}
+    inline void on_level_change(Side side, uint64_t price, uint64_t quantity, uint64_t timestamp) {}
+    inline void on_snapshot(const Tick& tick) {}
+    inline void on_period_end(TradingStatus status, uint64_t timestamp) {}
+};
+
+// columnar buffer of observed events
+struct EventBatch {
+    std::vector<uint64_t> trade_timestamp, trade_bid_uid, trade_ask_uid, trade_price, trade_quantity;
+    std::vector<uint64_t> fill_timestamp, fill_bid_uid, fill_ask_uid, fill_price, fill_quantity;
+    std::vector<uint64_t> level_timestamp, level_price, level_quantity;
+    std::vector<uint8_t> level_side;  // Side
+    std::vector<Tick> snapshots;
+    std::vector<uint64_t> period_timestamp;
+    std::vector<TradingStatus> period_status;
+
+    size_t size() const { return trade_timestamp.size() + fill_timestamp.size() + level_timestamp.size() + snapshots.size() + period_timestamp.size(); }
+    void clear() {
+        trade_timestamp.clear();
+        trade_bid_uid.clear();
+        trade_ask_uid.clear();
+        trade_price.clear();
+        trade_quantity.clear();
+        fill_timestamp.clear();
+        fill_bid_uid.clear();
+        fill_ask_uid.clear();
+        fill_price.clear();
+        fill_quantity.clear();
+        level_timestamp.clear();
+        level_price.clear();
+        level_quantity.clear();
+        level_side.clear();
+        snapshots.clear();
+        period_timestamp.clear();
+        period_status.clear();
+    }
+};
+
+// Buffers the events and hands them to `sink` in batches of `batch_size` events, the owner calls
+// flush() to deliver the rest. Nothing is recorded until a sink is set.
+class BatchObserver {
+    EventBatch batch;
+    std::function<void(const EventBatch&)> sink;
+    size_t batch_size;
+
+    inline void maybe_flush() {
+        if (batch.size() >= batch_size)
+            flush();
+    }
+
+   public:
+    BatchObserver()
+        : batch_size(4096) {}
+
+    void set_sink(std::function<void(const EventBatch&)> sink, size_t batch_size = 4096) {
+        flush();
+        this->sink = std::move(sink);
+        this->batch_size = std::max<size_t>(batch_size, 1);
+    }
+    void flush() {
+        if (sink && batch.size() > 0)
+            sink(batch);
+        batch.clear();
+    }
+
+    inline void on_trade(const Transaction& transaction) {
+        if (!sink)
+            return;
+        batch.trade_timestamp.push_back(transaction.timestamp);
+        batch.trade_bid_uid.push_back(transaction.bid_uid);
+        batch.trade_ask_uid.push_back(transaction.ask_uid);
+        batch.trade_price.push_back(transaction.price);
+        batch.trade_quantity.push_back(transaction.quantity);
+        maybe_flush();
+    }
+    inline void on_fill(const Transaction& transaction) {
+        if (!sink)
+            return;
+        batch.fill_timestamp.push_back(transaction.timestamp);
+        batch.fill_bid_uid.push_back(transaction.bid_uid);
+        batch.fill_ask_uid.push_back(transaction.ask_uid);
+        batch.fill_price.push_back(transaction.price);
+        batch.fill_quantity.push_back(transaction.quantity);
+        maybe_flush();
+    }
+    inline void on_level_change(Side side, uint64_t price, uint64_t quantity, uint64_t timestamp) {
+        if (!sink)
+            return;
+        batch.level_timestamp.push_back(timestamp);
+        batch.level_side.push_back(side);
+        batch.level_price.push_back(price);
+        batch.level_quantity.push_back(quantity);
+        maybe_flush();
+    }
+    inline void on_snapshot(const Tick& tick) {
+        if (!sink)
+            return;
+        batch.snapshots.push_back(tick);
+        maybe_flush();
+    }
+    inline void on_period_end(TradingStatus status, uint64_t timestamp) {
+        if (!sink)
+            return;
+        batch.period_timestamp.push_back(timestamp);
+        batch.period_status.push_back(status);
+        maybe_flush();
+    }
+};
+
+#endif  // __OBSERVER_HPP__
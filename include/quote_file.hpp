@@ -0,0 +1,157 @@
+#ifndef __QUOTE_FILE_HPP__
+#define __QUOTE_FILE_HPP__
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "struct.hpp"
+
+// Quote files read by LimitOrderBook::load(), the format follows the extension:
+//   * .csv  `timestamp,uid,price,quantity,side,type` with a header line, prices in decimal
+//   * .bin  a QuoteFileHeader followed by QuoteRecords in native byte order, prices as integers
+//           in the market's scale, which is checked against the book when loading
+
+struct QuoteFileHeader {
+    char magic[8];
+    uint64_t decimal_places;
+};
+
+struct QuoteRecord {
+    uint64_t timestamp, uid, price, quantity;
+    uint8_t side, type;
+    uint8_t padding[6];
+};
+
+static_assert(sizeof(QuoteFileHeader) == 16 && sizeof(QuoteRecord) == 40, "quote files have a fixed layout");
+
+const char QUOTE_FILE_MAGIC[8] = {'F', 'L', 'O', 'B', 'Q', 'T', '0', '1'};
+
+inline bool is_binary_quote_file(const std::string& filename) {
+    return filename.size() > 4 && filename.substr(filename.size() - 4) == ".bin";
+}
+
+// Reads a binary quote file in chunks, calls `f(quote)` for every record and returns the count.
+template <typename F>
+size_t read_binary_quotes(const std::string& filename, size_t decimal_places, F f) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open())
+        throw std::runtime_error("file is not open");
+    QuoteFileHeader header;
+    if (!file.read(reinterpret_cast<char*>(&header), sizeof(header)) || std::memcmp(header.magic, QUOTE_FILE_MAGIC, sizeof(header.magic)) != 0)
+        throw std::runtime_error("file is not a binary quote file");
+    if (header.decimal_places != decimal_places)
+        throw std::runtime_error("quote file has " + std::to_string(header.decimal_places) + " decimal places, the market has " + std::to_string(decimal_places));
+
+    std::vector<QuoteRecord> records(1 << 16);
+    size_t count = 0;
+    while (file) {
+        file.read(reinterpret_cast<char*>(records.data()), records.size() * sizeof(QuoteRecord));
+        size_t n = file.gcount() / sizeof(QuoteRecord);
+        if (file.gcount() % sizeof(QuoteRecord) != 0)
+            throw std::runtime_error("truncated binary quote file");
+        for (size_t i = 0; i < n; ++i) {
+            auto& r = records[i];
+            f(Quote(r.uid, r.price, r.quantity, r.timestamp, static_cast<Side>(r.side), static_cast<QuoteType>(r.type)));
+        }
+        count += n;
+    }
+    return count;
+}
+
+// Writes quotes to a .csv or .bin file, buffered in blocks of `buffer_size` bytes. Without
+// `keep_open` the file is only open while a block is appended to it, so that thousands of writers
+// do not hold a file descriptor each.
+class QuoteFileWriter {
+    std::ofstream file;
+    std::string filename;
+    bool binary, keep_open, closed;
+    uint64_t scale;
+    size_t decimal_places, buffer_size;
+    std::string buffer;
+
+    void append(uint64_t value) {
+        char digits[24];
+        buffer.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+    }
+
+   public:
+    QuoteFileWriter(const std::string& filename, size_t decimal_places, size_t buffer_size = 1 << 20, bool keep_open = true)
+        : file(filename, std::ios::binary), filename(filename), binary(is_binary_quote_file(filename)), keep_open(keep_open), closed(false), scale(1), decimal_places(decimal_places), buffer_size(buffer_size) {
+        if (!file.is_open())
+            throw std::runtime_error("cannot open " + filename);
+        for (size_t i = 0; i < decimal_places; ++i)
+            scale *= 10;
+        if (keep_open)
+            buffer.reserve(buffer_size);
+        if (binary) {
+            QuoteFileHeader header;
+            std::memcpy(header.magic, QUOTE_FILE_MAGIC, sizeof(header.magic));
+            header.decimal_places = decimal_places;
+            file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        } else {
+            buffer += "timestamp,uid,price,quantity,side,type\n";
+        }
+        if (!keep_open)
+            flush();
+    }
+    ~QuoteFileWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    void write(const Quote& quote) {
+        if (binary) {
+            QuoteRecord record{quote.timestamp, quote.uid, quote.price, quote.quantity, (uint8_t)quote.side, (uint8_t)quote.type, {}};
+            buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+        } else {
+            append(quote.timestamp);
+            buffer += ',';
+            append(quote.uid);
+            buffer += ',';
+            append(quote.price / scale);
+            if (decimal_places > 0) {
+                char digits[24];
+                auto end = std::to_chars(digits, digits + sizeof(digits), quote.price % scale).ptr;
+                buffer += '.';
+                buffer.append(decimal_places - (end - digits), '0');
+                buffer.append(digits, end);
+            }
+            buffer += ',';
+            append(quote.quantity);
+            buffer += ',';
+            append(quote.side);
+            buffer += ',';
+            append(quote.type);
+            buffer += '\n';
+        }
+        if (buffer.size() >= buffer_size)
+            flush();
+    }
+    // writes the buffered quotes to the file
+    void flush() {
+        if (!file.is_open())
+            file.open(filename, std::ios::binary | std::ios::app);
+        file.write(buffer.data(), buffer.size());
+        if (!file)
+            throw std::runtime_error("failed to write " + filename);
+        buffer.clear();
+        if (!keep_open)
+            file.close();
+    }
+    void close() {
+        if (closed)
+            return;
+        closed = true;
+        flush();
+        if (file.is_open())
+            file.close();
+    }
+};
+
+#endif  // __QUOTE_FILE_HPP__
@@ -0,0 +1,104 @@
+#ifndef __RECORD_LOG_HPP__
+#define __RECORD_LOG_HPP__
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "struct.hpp"
+
+// 32-byte forms of the records a book keeps for a whole day, with 32-bit prices and quantities.
+// Prices stay in the market's scale (not ticks) and quantities in shares (not lots), so packing
+// is a range check and no rounding can occur; records that do not fit raise an error. They are
+// used in compact mode, see LimitOrderBook::set_compact.
+inline uint32_t narrow(uint64_t value, const char* field) {
+    if (value > std::numeric_limits<uint32_t>::max())
+        throw std::runtime_error(std::string(field) + " " + std::to_string(value) + " does not fit the compact mode");
+    return (uint32_t)value;
+}
+
+struct CompactQuote {
+    uint64_t uid, timestamp;
+    uint32_t price, quantity;
+    uint8_t side, type;
+
+    static CompactQuote pack(const Quote& quote) {
+        return {quote.uid, quote.timestamp, narrow(quote.price, "price"), narrow(quote.quantity, "quantity"), (uint8_t)quote.side, (uint8_t)quote.type};
+    }
+    Quote unpack() const { return Quote(uid, price, quantity, timestamp, static_cast<Side>(side), static_cast<QuoteType>(type)); }
+};
+
+struct CompactTransaction {
+    uint64_t bid_uid, ask_uid, timestamp;
+    uint32_t price, quantity;
+
+    static CompactTransaction pack(const Transaction& transaction) {
+        return {transaction.bid_uid, transaction.ask_uid, transaction.timestamp, narrow(transaction.price, "price"), narrow(transaction.quantity, "quantity")};
+    }
+    Transaction unpack() const { return Transaction(bid_uid, ask_uid, price, quantity, timestamp); }
+};
+
+static_assert(sizeof(CompactQuote) == 32 && sizeof(CompactTransaction) == 32, "compact records are 32 bytes");
+
+// Append-only log read from the front, holding either full or packed records. The mode can only
+// change while the log is empty.
+template <typename Record, typename Packed>
+class RecordLog {
+    std::deque<Record> records;
+    std::deque<Packed> packed;
+    bool compact;
+
+   public:
+    RecordLog()
+        : compact(false) {}
+
+    void set_compact(bool compact) {
+        if (compact != this->compact && !empty())
+            throw std::runtime_error("the compact mode can only change while the book holds no records");
+        this->compact = compact;
+    }
+    bool is_compact() const { return compact; }
+
+    inline void push_back(const Record& record) {
+        if (compact)
+            packed.push_back(Packed::pack(record));
+        else
+            records.push_back(record);
+    }
+    inline Record front() const { return compact ? packed.front().unpack() : records.front(); }
+    inline Record operator[](size_t i) const { return compact ? packed[i].unpack() : records[i]; }
+    inline void prefetch_front() const {
+        if (compact && !packed.empty())
+            __builtin_prefetch(&packed.front());
+        else if (!compact && !records.empty())
+            __builtin_prefetch(&records.front());
+    }
+    inline void pop_front() {
+        if (compact)
+            packed.pop_front();
+        else
+            records.pop_front();
+    }
+    size_t size() const { return compact ? packed.size() : records.size(); }
+    bool empty() const { return size() == 0; }
+    void clear() {
+        records.clear();
+        packed.clear();
+    }
+    // bytes of the records, the deque blocks add about one pointer per 512 bytes
+    size_t bytes() const { return records.size() * sizeof(Record) + packed.size() * sizeof(Packed); }
+
+    std::vector<Record> to_vector() const {
+        if (!compact)
+            return std::vector<Record>(records.begin(), records.end());
+        std::vector<Record> result;
+        result.reserve(size());
+        for (auto& record : packed)
+            result.push_back(record.unpack());
+        return result;
+    }
+};
+
+#endif  // __RECORD_LOG_HPP__
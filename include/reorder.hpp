@@ -0,0 +1,188 @@
+#ifndef __REORDER_HPP__
+#define __REORDER_HPP__
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "struct.hpp"
+
+// Reorder stage in front of LimitOrderBook::write() for feeds split over several channels. Every
+// channel is written by one decoder thread, in its own order, through a bounded lock-free ring;
+// a single consumer thread merges the channels with poll() or run() and releases the quotes in
+// order as soon as that is safe.
+//
+// Without sequence numbers quotes are ordered by (timestamp, uid, channel). The head of a channel
+// is released once every other channel either holds a quote, is closed or promised with
+// heartbeat() that nothing at or before its timestamp follows. Within a channel quotes of one
+// timestamp keep their order, e.g. a cancel of an older order after a new one.
+//
+// With sequence numbers (`sequenced`, one counter across all channels) the quote carrying the next
+// sequence is released at once. A missing sequence is a gap once every channel is past it, the
+// gap is recorded and the merge goes on.
+//
+// The stage is bounded: push() waits while the ring of its channel is full, a channel that stays
+// silent holds the merge back until it sends a heartbeat or is closed. A quote that arrives behind
+// what was already released (an earlier (timestamp, uid) than a quote of another channel, an earlier
+// timestamp than its own channel, or a sequence already passed) is dropped and counted.
+class ReorderBuffer {
+   public:
+    struct Gap {
+        uint64_t expected, received;  // sequences in [expected, received) never arrived
+    };
+
+   private:
+    struct Event {
+        uint64_t sequence, uid, price, quantity, timestamp;
+        Side side;
+        QuoteType type;
+    };
+    // single producer single consumer ring, the indexes only grow
+    struct Channel {
+        std::vector<Event> ring;
+        alignas(64) std::atomic<size_t> write{0};
+        alignas(64) std::atomic<size_t> read{0};
+        std::atomic<uint64_t> watermark{0};  // see heartbeat()
+        std::atomic<bool> closed{false};
+
+        Channel(size_t capacity)
+            : ring(capacity) {}
+    };
+
+    std::vector<std::unique_ptr<Channel>> channels;
+    std::vector<size_t> writes;  // write index of every channel at the last head scan of poll()
+    bool sequenced;
+    bool started;
+    uint64_t next;            // sequence expected next
+    uint64_t last_timestamp, last_uid;  // of the last released quote
+    const Channel* last_channel;
+    std::vector<Gap> gaps;
+    size_t late;
+
+    bool before(const Event& a, const Event& b) const {
+        if (sequenced)
+            return a.sequence < b.sequence;
+        return a.timestamp != b.timestamp ? a.timestamp < b.timestamp : a.uid < b.uid;
+    }
+    bool behind(const Event& event, const Channel* channel) const {
+        if (!started)
+            return false;
+        if (sequenced)
+            return event.sequence < next;
+        if (event.timestamp != last_timestamp)
+            return event.timestamp < last_timestamp;
+        return event.uid < last_uid && channel != last_channel;
+    }
+
+   public:
+    ReorderBuffer(size_t channels, size_t capacity = 1 << 16, bool sequenced = false)
+        : sequenced(sequenced), started(false), next(0), last_timestamp(0), last_uid(0), last_channel(nullptr), late(0) {
+        if (channels == 0 || capacity == 0)
+            throw std::invalid_argument("channels and capacity must be positive");
+        for (size_t i = 0; i < channels; ++i)
+            this->channels.emplace_back(new Channel(capacity));
+        writes.resize(channels);
+    }
+
+    // producer side, one thread per channel
+    void push(size_t channel, const Quote& quote, uint64_t sequence = 0) {
+        Channel& c = *channels.at(channel);
+        size_t write = c.write.load(std::memory_order_relaxed);
+        while (write - c.read.load(std::memory_order_acquire) == c.ring.size())
+            std::this_thread::yield();
+        c.ring[write % c.ring.size()] = {sequence, quote.uid, quote.price, quote.quantity, quote.timestamp, quote.side, quote.type};
+        c.write.store(write + 1, std::memory_order_release);
+    }
+    // nothing earlier than `key`, a sequence when sequenced, or nothing at or before `key`, a
+    // timestamp, will follow on the channel
+    void heartbeat(size_t channel, uint64_t key) { channels.at(channel)->watermark.store(key, std::memory_order_release); }
+    void close(size_t channel) { channels.at(channel)->closed.store(true, std::memory_order_release); }
+
+    // consumer side: hands every quote that is safe to release to `f(quote)`, returns their number
+    template <typename F>
+    size_t poll(F f) {
+        size_t count = 0;
+        while (true) {
+            Channel* best = nullptr;
+            const Event* head = nullptr;
+            for (size_t i = 0; i < channels.size(); ++i) {
+                Channel* c = channels[i].get();
+                size_t read = c->read.load(std::memory_order_relaxed), write = c->write.load(std::memory_order_acquire);
+                writes[i] = write;
+                if (read == write)
+                    continue;
+                const Event& event = c->ring[read % c->ring.size()];
+                if (!head || before(event, *head)) {
+                    best = c;
+                    head = &event;
+                }
+            }
+            if (!head)
+                return count;
+            if (behind(*head, best)) {
+                ++late;
+                best->read.store(best->read.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+                continue;
+            }
+            bool ready = sequenced && started && head->sequence == next, rescan = false;
+            if (!ready) {
+                // every channel that was empty at the scan must be closed or past the head, and
+                // still empty: a quote pushed since may come before the head
+                ready = true;
+                uint64_t key = sequenced ? head->sequence : head->timestamp;
+                for (size_t i = 0; i < channels.size() && ready && !rescan; ++i) {
+                    Channel& c = *channels[i];
+                    if (c.read.load(std::memory_order_relaxed) != writes[i])
+                        continue;
+                    uint64_t watermark = c.watermark.load(std::memory_order_acquire);  // past the head when at its key
+                    ready = c.closed.load(std::memory_order_acquire) || watermark >= key;
+                    rescan = c.write.load(std::memory_order_acquire) != writes[i];
+                }
+            }
+            if (rescan)
+                continue;
+            if (!ready)
+                return count;
+
+            if (sequenced && started && head->sequence != next)
+                gaps.push_back({next, head->sequence});
+            started = true;
+            next = head->sequence + 1;
+            last_timestamp = head->timestamp;
+            last_uid = head->uid;
+            last_channel = best;
+            Quote quote(head->uid, head->price, head->quantity, head->timestamp, head->side, head->type);
+            best->read.store(best->read.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            f(quote);
+            ++count;
+        }
+    }
+    // polls until every channel is closed and drained
+    template <typename F>
+    size_t run(F f) {
+        size_t count = 0;
+        while (true) {
+            bool closed = true;
+            for (auto& c : channels)
+                closed = closed && c->closed.load(std::memory_order_acquire);
+            count += poll(f);
+            if (closed && empty())
+                return count;
+            std::this_thread::yield();
+        }
+    }
+
+    bool empty() const {
+        for (auto& c : channels)
+            if (c->read.load(std::memory_order_relaxed) != c->write.load(std::memory_order_acquire))
+                return false;
+        return true;
+    }
+    const std::vector<Gap>& get_gaps() const { return gaps; }
+    size_t late_count() const { return late; }
+};
+
+#endif  // __REORDER_HPP__
@@ -0,0 +1,146 @@
+#ifndef __REPLAY_HPP__
+#define __REPLAY_HPP__
+
+#include <algorithm>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include "csv.hpp"
+#include "generator.hpp"
+#include "limit_order_book.hpp"
+#include "market.hpp"
+#include "quote_file.hpp"
+
+// The command line replay of one trading day: load(), run() and write the transactions and ticks,
+// with the options of example/transaction.py and example/tick.py in one invocation.
+//
+//   flob-replay (--data FILE | --generate N [--seed 0]) [--market AShare] [--schedule NAME]
+//               [--snapshot_gap 3s] [--topk 5] [--features spread,imbalance]
+//               [--transactions data/transactions.csv] [--ticks data/ticks.csv]
+//
+// `--generate` replays N synthetic events of OrderFlowGenerator instead of a file, spread over
+// the continuous trading periods of the day, so a build can be trained without market data.
+// CSV outputs match the files written by the example scripts, .bin outputs are streamed while
+// replaying (see stream_writer.hpp), an empty output is not written. The same entry point is
+// exposed as `flob.replay(args)`, so one workload trains both the executable and the extension
+// of a profile guided build.
+
+struct ReplayOptions {
+    std::string data, market = "AShare", schedule;
+    std::string transactions = "data/transactions.csv", ticks = "data/ticks.csv";
+    uint64_t snapshot_gap = 3000000000UL;
+    size_t topk = 5;
+    size_t generate = 0;  // synthetic events replayed instead of `data`
+    uint64_t seed = 0;
+    std::vector<std::string> features;
+};
+
+// a pandas style duration such as `3s`, `500ms` or `1min`, plain numbers are nanoseconds
+inline uint64_t parse_duration(const std::string& text) {
+    size_t end = 0;
+    double value = std::stod(text, &end);
+    std::string unit = text.substr(end);
+    const std::pair<const char*, uint64_t> units[] = {{"", 1}, {"ns", 1}, {"us", 1000}, {"ms", 1000000}, {"s", 1000000000}, {"min", 60000000000}, {"h", 3600000000000}};
+    for (auto& u : units)
+        if (unit == u.first)
+            return (uint64_t)(value * u.second + 0.5);
+    throw std::invalid_argument("unknown duration: " + text);
+}
+
+inline ReplayOptions parse_replay_options(const std::vector<std::string>& args) {
+    ReplayOptions options;
+    for (size_t i = 0; i < args.size(); i += 2) {
+        const std::string& key = args[i];
+        if (i + 1 == args.size())
+            throw std::invalid_argument("missing value of option: " + key);
+        const std::string& value = args[i + 1];
+        if (key == "--data")
+            options.data = value;
+        else if (key == "--market")
+            options.market = value;
+        else if (key == "--schedule")
+            options.schedule = value;
+        else if (key == "--snapshot_gap")
+            options.snapshot_gap = parse_duration(value);
+        else if (key == "--topk")
+            options.topk = std::stoull(value);
+        else if (key == "--features") {
+            options.features.clear();
+            for (size_t start = 0; start < value.size();) {
+                size_t comma = std::min(value.find(',', start), value.size());
+                if (comma > start)
+                    options.features.push_back(value.substr(start, comma - start));
+                start = comma + 1;
+            }
+        } else if (key == "--generate")
+            options.generate = std::stoull(value);
+        else if (key == "--seed")
+            options.seed = std::stoull(value);
+        else if (key == "--transactions")
+            options.transactions = value;
+        else if (key == "--ticks")
+            options.ticks = value;
+        else
+            throw std::invalid_argument("unknown option: " + key);
+    }
+    if (options.data.empty() == (options.generate == 0))
+        throw std::invalid_argument("give either --data or --generate");
+    return options;
+}
+
+template <typename Market>
+void replay(const ReplayOptions& options) {
+    typedef LimitOrderBook<Market> Book;
+    Book book(options.snapshot_gap, options.topk, options.schedule.empty() ? Market::name : options.schedule);
+    book.set_features(options.features);
+    bool stream_transactions = is_binary_quote_file(options.transactions), stream_ticks = is_binary_quote_file(options.ticks);
+    if (stream_transactions)
+        book.stream_transactions(options.transactions);
+    if (stream_ticks)
+        book.stream_ticks(options.ticks);
+    if (options.generate > 0) {
+        GeneratorConfig config;
+        config.seed = options.seed;
+        config.schedule = options.schedule;
+        config.base_rate = daily_rate<Market>(options.generate, options.schedule);
+        OrderFlowGenerator<Market>(config).generate(options.generate, [&](const Quote& quote) { book.append(quote); });
+    } else {
+        book.load(options.data);
+    }
+    book.run();
+    book.close_streams();
+
+    auto write = [](const std::string& filename, auto f) {
+        std::ofstream file(filename, std::ios::binary);
+        if (!file.is_open())
+            throw std::runtime_error("cannot open " + filename);
+        f(file);
+    };
+    if (!options.transactions.empty() && !stream_transactions)
+        write(options.transactions, [&](std::ostream& os) { write_transactions_csv(os, book.get_transactions(), Market::decimal_places); });
+    if (!options.ticks.empty() && !stream_ticks)
+        write(options.ticks, [&](std::ostream& os) { write_ticks_csv(os, book.get_ticks(), Market::decimal_places, book.get_feature_names()); });
+}
+
+// runs a replay for command line arguments (without the program name), returns the exit status
+inline int replay_main(const std::vector<std::string>& args) {
+    try {
+        ReplayOptions options = parse_replay_options(args);
+        if (options.market == "AShare")
+            replay<AShare>(options);
+        else if (options.market == "HKEX")
+            replay<HKEX>(options);
+        else
+            throw std::invalid_argument("unknown market: " + options.market);
+        return 0;
+    } catch (const std::exception& e) {
+        std::cerr << "error: " << e.what() << std::endl;
+        return 2;
+    }
+}
+
+#endif  // __REPLAY_HPP__
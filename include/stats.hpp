@@ -0,0 +1,186 @@
+#ifndef __STATS_HPP__
+#define __STATS_HPP__
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "struct.hpp"
+
+#if defined(FLOB_STATS) && defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// Instrumentation of the book, compiled in with -DFLOB_STATS. Without it the macros below expand
+// to nothing and the book holds no statistics, LimitOrderBook::stats() reports `enabled == false`.
+#ifdef FLOB_STATS
+#define FLOB_TIMED(histogram) ScopedTimer flob_scoped_timer(histogram)
+#define FLOB_COUNT(statement) statement
+#else
+#define FLOB_TIMED(histogram)
+#define FLOB_COUNT(statement)
+#endif
+
+// Log-linear latency histogram in the spirit of HdrHistogram: values below 32 ns are exact, above
+// every power of two is split into 32 buckets, a relative error of at most 1/32. Values are
+// clamped to 2^40 ns (about 18 minutes).
+class LatencyHistogram {
+    static constexpr size_t sub_bits = 5, sub_buckets = 1 << sub_bits, max_bits = 40;
+    std::vector<uint64_t> buckets;
+
+    static size_t index(uint64_t value) {
+        if (value < sub_buckets)
+            return value;
+        size_t exponent = 63 - __builtin_clzll(value);
+        return (exponent - sub_bits + 1) * sub_buckets + ((value >> (exponent - sub_bits)) & (sub_buckets - 1));
+    }
+    // smallest value of the bucket
+    static uint64_t lower(size_t index) {
+        if (index < sub_buckets)
+            return index;
+        size_t exponent = index / sub_buckets + sub_bits - 1;
+        return (sub_buckets + index % sub_buckets) << (exponent - sub_bits);
+    }
+
+   public:
+    uint64_t count, total, min, max;
+
+    LatencyHistogram()
+        : buckets((max_bits - sub_bits + 1) * sub_buckets), count(0), total(0), min(0), max(0) {}
+
+    inline void record(uint64_t value) {
+        value = std::min<uint64_t>(value, (1UL << max_bits) - 1);
+        ++buckets[index(value)];
+        min = count == 0 ? value : std::min(min, value);
+        max = std::max(max, value);
+        total += value;
+        ++count;
+    }
+    double mean() const { return count ? (double)total / count : 0; }
+    // value at the given quantile, the middle of its bucket
+    uint64_t percentile(double q) const {
+        if (count == 0)
+            return 0;
+        uint64_t rank = std::max<uint64_t>(1, (uint64_t)(q * count + 0.5)), seen = 0;
+        for (size_t i = 0; i < buckets.size(); ++i) {
+            seen += buckets[i];
+            if (seen >= rank)
+                return std::min(max, std::max(min, (lower(i) + lower(i + 1) - 1) / 2));
+        }
+        return max;
+    }
+    void clear() { *this = LatencyHistogram(); }
+};
+
+struct ScopedTimer {
+    LatencyHistogram& histogram;
+    std::chrono::steady_clock::time_point start;
+
+    ScopedTimer(LatencyHistogram& histogram)
+        : histogram(histogram), start(std::chrono::steady_clock::now()) {}
+    ~ScopedTimer() { histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count()); }
+};
+
+// Hardware counters read through perf_event_open. They count the thread that called open(), a
+// book opens them when a run begins, on the thread that replays. They are unavailable (and read
+// as zero) before open(), without FLOB_STATS, outside Linux or when the kernel refuses them, e.g.
+// because of /proc/sys/kernel/perf_event_paranoid.
+class PerfCounters {
+    int fds[3] = {-1, -1, -1};
+    std::thread::id owner;
+
+#if defined(FLOB_STATS) && defined(__linux__)
+    static int open_counter(uint64_t config, int group) {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.config = config;
+        attr.disabled = group == -1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        return syscall(__NR_perf_event_open, &attr, 0, -1, group, 0);
+    }
+#endif
+
+   public:
+    PerfCounters() {}
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+    ~PerfCounters() { close(); }
+
+    // counts the calling thread from now on, a no-op if it already does
+    void open() {
+#if defined(FLOB_STATS) && defined(__linux__)
+        if (available() && owner == std::this_thread::get_id())
+            return;
+        close();
+        owner = std::this_thread::get_id();
+        fds[0] = open_counter(PERF_COUNT_HW_CPU_CYCLES, -1);
+        if (fds[0] < 0)
+            return;
+        fds[1] = open_counter(PERF_COUNT_HW_INSTRUCTIONS, fds[0]);
+        fds[2] = open_counter(PERF_COUNT_HW_CACHE_MISSES, fds[0]);
+        ioctl(fds[0], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP);
+#endif
+    }
+    void close() {
+        for (int& fd : fds) {
+#if defined(FLOB_STATS) && defined(__linux__)
+            if (fd >= 0)
+                ::close(fd);
+#endif
+            fd = -1;
+        }
+    }
+
+    bool available() const { return fds[0] >= 0; }
+    // cycles, instructions and cache misses so far
+    void read(uint64_t values[3]) const {
+        for (size_t i = 0; i < 3; ++i) {
+            values[i] = 0;
+#if defined(FLOB_STATS) && defined(__linux__)
+            if (fds[i] >= 0 && ::read(fds[i], &values[i], sizeof(values[i])) != sizeof(values[i]))
+                values[i] = 0;
+#endif
+        }
+    }
+};
+
+// totals of the trading periods of one status
+struct PhaseStats {
+    uint64_t count = 0, nanoseconds = 0, cycles = 0, instructions = 0, cache_misses = 0;
+};
+
+struct BookStats {
+    bool enabled = false;
+    LatencyHistogram quotes[6];  // write() by QuoteType
+    LatencyHistogram match, match_call_auction, snapshot;
+    uint64_t levels_created = 0, levels_destroyed = 0;
+    uint64_t max_queue_length = 0, max_resting_orders = 0;
+    PhaseStats phases[4];  // by TradingStatus
+    bool perf_available = false;
+    // filled in by LimitOrderBook::stats()
+    uint64_t resting_orders = 0, bid_levels = 0, ask_levels = 0, bid_tree_height = 0, ask_tree_height = 0;
+};
+
+// Bytes held by a book, see LimitOrderBook::memory_usage. The arena holds the order book itself:
+// the first fields are its live objects, hash maps are estimated from their sizes and bucket
+// counts. `total` counts the arena by its reserved chunks plus the day-long records, the
+// buffers of the result streams, the checkpoints with their copy of the quotes and the L3 dumps
+// kept in memory, `peak` is the largest total seen after a load, at the end of each trading period
+// and at every call. Every figure is a size or a running counter, taking it costs O(1).
+struct MemoryUsage {
+    size_t orders = 0, levels = 0, tree_nodes = 0, queue_indexes = 0, hash_maps = 0;
+    size_t arena_used = 0, arena_reserved = 0;
+    size_t quotes = 0, transactions = 0, fills = 0, ticks = 0, pending = 0, streams = 0, checkpoints = 0, l3 = 0;
+    size_t total = 0, peak = 0;
+};
+
+#endif  // __STATS_HPP__
@@ -0,0 +1,386 @@
+#ifndef __STREAM_WRITER_HPP__
+#define __STREAM_WRITER_HPP__
+
+#include <algorithm>
+#include <cmath>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "csv.hpp"
+#include "struct.hpp"
+
+// Result files written while a book runs, see LimitOrderBook::stream_transactions and
+// stream_ticks. The format follows the extension:
+//   * .csv  the columns of example/transaction.py and example/tick.py, with every timestamp
+//           printed to the nanosecond since the resolution of a column is unknown while streaming
+//   * .bin  a ResultFileHeader followed by delta encoded records: every integer field is stored
+//           as a LEB128 varint of its zigzag encoded difference to the same field of the previous
+//           record, quantities and volumes as plain varints, features as raw doubles. Prices are
+//           integers in the market's scale, 0 for a missing price (NaN).
+
+struct ResultFileHeader {
+    char magic[8];
+    uint64_t decimal_places, topk, features;  // topk and features are 0 for transactions
+};
+
+static_assert(sizeof(ResultFileHeader) == 32, "result files have a fixed layout");
+
+const char TRANSACTION_FILE_MAGIC[8] = {'F', 'L', 'O', 'B', 'T', 'R', '0', '1'};
+const char TICK_FILE_MAGIC[8] = {'F', 'L', 'O', 'B', 'T', 'K', '0', '1'};
+
+inline void append_varint(std::string& out, uint64_t value) {
+    while (value >= 0x80) {
+        out += (char)(value | 0x80);
+        value >>= 7;
+    }
+    out += (char)value;
+}
+
+inline void append_delta(std::string& out, uint64_t value, uint64_t& previous) {
+    int64_t delta = (int64_t)(value - previous);
+    append_varint(out, ((uint64_t)delta << 1) ^ (uint64_t)(delta >> 63));
+    previous = value;
+}
+
+inline std::string result_file_header(const char* magic, size_t decimal_places, size_t topk, size_t features) {
+    ResultFileHeader header;
+    std::memcpy(header.magic, magic, sizeof(header.magic));
+    header.decimal_places = decimal_places;
+    header.topk = topk;
+    header.features = features;
+    return std::string(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+
+class TransactionEncoder {
+    bool binary;
+    size_t decimal_places;
+    double scale_down;
+    uint64_t timestamp = 0, bid_uid = 0, ask_uid = 0, price = 0;
+
+   public:
+    TransactionEncoder(bool binary, size_t decimal_places)
+        : binary(binary), decimal_places(decimal_places), scale_down(1.0 / (double)pow10(decimal_places)) {}
+
+    std::string header() const {
+        return binary ? result_file_header(TRANSACTION_FILE_MAGIC, decimal_places, 0, 0) : "timestamp,bid_uid,ask_uid,price,volume\n";
+    }
+    void encode(const Transaction& t, std::string& out) {
+        if (binary) {
+            append_delta(out, t.timestamp, timestamp);
+            append_delta(out, t.bid_uid, bid_uid);
+            append_delta(out, t.ask_uid, ask_uid);
+            append_delta(out, t.price, price);
+            append_varint(out, t.quantity);
+        } else {
+            out += format_timestamp(t.timestamp, 9);
+            out += ',' + std::to_string(t.bid_uid) + ',' + std::to_string(t.ask_uid) + ',';
+            out += format_float(round_decimals(t.price * scale_down, decimal_places));
+            out += ',' + std::to_string(t.quantity) + '\n';
+        }
+    }
+};
+
+class TickEncoder {
+    bool binary;
+    size_t decimal_places, topk;
+    double scale_up;
+    std::vector<std::string> features;
+    uint64_t timestamp = 0, ohlc[4] = {};
+    std::vector<uint64_t> prices;  // bid then ask prices of the previous tick
+
+    uint64_t to_int(double value) const { return std::isnan(value) ? 0 : (uint64_t)(value * scale_up + 0.5); }
+    std::string format_price(double value) const { return format_float(round_decimals(value, decimal_places)); }
+
+   public:
+    TickEncoder(bool binary, size_t decimal_places, size_t topk, const std::vector<std::string>& features)
+        : binary(binary), decimal_places(decimal_places), topk(topk), scale_up((double)pow10(decimal_places)), features(features), prices(2 * topk) {}
+
+    std::string header() const {
+        if (binary)
+            return result_file_header(TICK_FILE_MAGIC, decimal_places, topk, features.size());
+        std::string header = "timestamp,open,high,low,close,volume,amount";
+        for (auto side : {"bid_price_", "ask_price_", "bid_volume_", "ask_volume_"})
+            for (size_t i = 0; i < topk; ++i)
+                header += std::string(",") + side + std::to_string(i + 1);
+        for (auto& name : features)
+            header += ',' + name;
+        return header + '\n';
+    }
+    void encode(const Tick& t, std::string& out) {
+        if (binary) {
+            append_delta(out, t.timestamp, timestamp);
+            double values[4] = {t.open, t.high, t.low, t.close};
+            for (size_t i = 0; i < 4; ++i)
+                append_delta(out, to_int(values[i]), ohlc[i]);
+            append_varint(out, t.volume);
+            append_varint(out, (uint64_t)t.amount);
+            for (size_t i = 0; i < topk; ++i)
+                append_delta(out, to_int(t.bid_prices[i]), prices[i]);
+            for (size_t i = 0; i < topk; ++i)
+                append_delta(out, to_int(t.ask_prices[i]), prices[topk + i]);
+            for (auto volume : t.bid_volumes)
+                append_varint(out, volume);
+            for (auto volume : t.ask_volumes)
+                append_varint(out, volume);
+            for (auto value : t.features)
+                out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        } else {
+            out += format_timestamp(t.timestamp, 9);
+            for (double value : {t.open, t.high, t.low, t.close})
+                out += ',' + format_price(value);
+            out += ',' + std::to_string(t.volume) + ',' + format_price(t.amount);
+            for (auto value : t.bid_prices)
+                out += ',' + format_price(value);
+            for (auto value : t.ask_prices)
+                out += ',' + format_price(value);
+            for (auto value : t.bid_volumes)
+                out += ',' + std::to_string(value);
+            for (auto value : t.ask_volumes)
+                out += ',' + std::to_string(value);
+            for (auto value : t.features)
+                out += ',' + format_float(value);
+            out += '\n';
+        }
+    }
+};
+
+// Encodes and writes records on a background thread. The caller fills a block of `block_size`
+// records, full blocks go through a ring of `blocks` slots to the writer thread and push() waits
+// while the ring is full, so at most `blocks + 2` blocks are ever held. Errors of the writer
+// thread are rethrown on the caller's thread by the next block handed over, drain() or close().
+template <typename Record, typename Encoder>
+class StreamWriter {
+    std::string filename;
+    std::ofstream file;
+    Encoder encoder;
+    size_t block_size;
+    std::vector<Record> block;
+    std::vector<std::vector<Record>> ring;
+    size_t head, count;
+    bool busy, closing;
+    std::exception_ptr error;
+    std::mutex mutex;
+    std::condition_variable ready, space;
+    std::thread thread;
+
+    void work() {
+        std::vector<Record> records;
+        std::string buffer;
+        while (true) {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                ready.wait(lock, [&] { return count > 0 || closing; });
+                if (count == 0)
+                    return;
+                records.swap(ring[head]);  // hands the emptied block of the last round back
+                head = (head + 1) % ring.size();
+                --count;
+                busy = true;
+            }
+            space.notify_all();
+            std::exception_ptr failure;
+            try {
+                for (auto& record : records)
+                    encoder.encode(record, buffer);
+                file.write(buffer.data(), buffer.size());
+                file.flush();
+                if (!file)
+                    throw std::runtime_error("cannot write " + filename);
+            } catch (...) {
+                failure = std::current_exception();
+            }
+            buffer.clear();
+            records.clear();
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                busy = false;
+                if (failure && !error)
+                    error = failure;
+            }
+            space.notify_all();
+        }
+    }
+    void rethrow() {
+        if (error)
+            std::rethrow_exception(std::exchange(error, nullptr));
+    }
+
+   public:
+    StreamWriter(const std::string& filename, const Encoder& encoder, size_t block_size = 4096, size_t blocks = 4)
+        : filename(filename), file(filename, std::ios::binary), encoder(encoder), block_size(std::max<size_t>(block_size, 1)), ring(std::max<size_t>(blocks, 1)), head(0), count(0), busy(false), closing(false) {
+        if (!file.is_open())
+            throw std::runtime_error("cannot open " + filename);
+        std::string header = this->encoder.header();
+        file.write(header.data(), header.size());
+        block.reserve(this->block_size);
+        thread = std::thread(&StreamWriter::work, this);
+    }
+    StreamWriter(const StreamWriter&) = delete;
+    StreamWriter& operator=(const StreamWriter&) = delete;
+    ~StreamWriter() {
+        try {
+            close();
+        } catch (...) {
+        }
+    }
+
+    inline void push(const Record& record) {
+        block.push_back(record);
+        if (block.size() >= block_size)
+            flush();
+    }
+    // hands the partial block to the writer thread without waiting for it
+    void flush() {
+        std::unique_lock<std::mutex> lock(mutex);
+        rethrow();
+        if (block.empty())
+            return;
+        space.wait(lock, [&] { return count < ring.size(); });
+        block.swap(ring[(head + count) % ring.size()]);
+        ++count;
+        lock.unlock();
+        ready.notify_one();
+        block.reserve(block_size);
+    }
+    // flushes and waits until everything pushed so far is in the file
+    void drain() {
+        flush();
+        std::unique_lock<std::mutex> lock(mutex);
+        space.wait(lock, [&] { return count == 0 && !busy; });
+        rethrow();
+    }
+    void close() {
+        if (!thread.joinable())
+            return;
+        std::exception_ptr failure;
+        try {
+            flush();
+        } catch (...) {
+            failure = std::current_exception();
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            closing = true;
+        }
+        ready.notify_one();
+        thread.join();
+        file.close();
+        if (failure)
+            std::rethrow_exception(failure);
+        rethrow();
+    }
+
+    // upper bound of the memory held by the blocks, without what records own on the heap
+    size_t bytes() const { return (ring.size() + 2) * block_size * sizeof(Record); }
+};
+
+// Reads a binary result file, checks its magic and scale.
+class ResultFileReader {
+    std::string data;
+    size_t position;
+
+   public:
+    ResultFileHeader header;
+
+    ResultFileReader(const std::string& filename, const char* magic, size_t decimal_places)
+        : position(sizeof(ResultFileHeader)) {
+        std::ifstream file(filename, std::ios::binary);
+        if (!file.is_open())
+            throw std::runtime_error("file is not open");
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        if (data.size() < sizeof(header) || std::memcmp(data.data(), magic, sizeof(header.magic)) != 0)
+            throw std::runtime_error(filename + " is not a binary " + (magic == TICK_FILE_MAGIC ? "tick" : "transaction") + " file");
+        std::memcpy(&header, data.data(), sizeof(header));
+        if (header.decimal_places != decimal_places)
+            throw std::runtime_error("result file has " + std::to_string(header.decimal_places) + " decimal places, the market has " + std::to_string(decimal_places));
+    }
+
+    bool done() const { return position == data.size(); }
+    uint64_t varint() {
+        uint64_t value = 0;
+        for (size_t shift = 0; shift < 64; shift += 7) {
+            if (position == data.size())
+                throw std::runtime_error("truncated result file");
+            uint8_t byte = data[position++];
+            value |= (uint64_t)(byte & 0x7f) << shift;
+            if (byte < 0x80)
+                return value;
+        }
+        throw std::runtime_error("corrupted result file");
+    }
+    uint64_t delta(uint64_t& previous) {
+        uint64_t zigzag = varint();
+        previous += (zigzag >> 1) ^ -(zigzag & 1);
+        return previous;
+    }
+    double raw_double() {
+        double value;
+        if (data.size() - position < sizeof(value))
+            throw std::runtime_error("truncated result file");
+        std::memcpy(&value, data.data() + position, sizeof(value));
+        position += sizeof(value);
+        return value;
+    }
+};
+
+// Reads a binary transaction file written by a book, calls `f(transaction)` for every record and
+// returns the count.
+template <typename F>
+size_t read_transaction_file(const std::string& filename, size_t decimal_places, F f) {
+    ResultFileReader reader(filename, TRANSACTION_FILE_MAGIC, decimal_places);
+    uint64_t timestamp = 0, bid_uid = 0, ask_uid = 0, price = 0;
+    size_t count = 0;
+    for (; !reader.done(); ++count) {
+        reader.delta(timestamp);
+        reader.delta(bid_uid);
+        reader.delta(ask_uid);
+        reader.delta(price);
+        f(Transaction(bid_uid, ask_uid, price, reader.varint(), timestamp));
+    }
+    return count;
+}
+
+// Reads a binary tick file written by a book, calls `f(tick)` for every record and returns the
+// count. Prices come back as the book computes them, missing ones as NaN.
+template <typename F>
+size_t read_tick_file(const std::string& filename, size_t decimal_places, F f) {
+    ResultFileReader reader(filename, TICK_FILE_MAGIC, decimal_places);
+    const double scale_down = 1.0 / (double)pow10(decimal_places);
+    size_t topk = reader.header.topk;
+    auto to_double = [&](uint64_t value) { return value == 0 ? std::nan("") : (double)value * scale_down; };
+    uint64_t timestamp = 0, ohlc[4] = {};
+    std::vector<uint64_t> prices(2 * topk);
+    std::vector<double> bid_prices(topk), ask_prices(topk), features(reader.header.features);
+    std::vector<uint64_t> bid_volumes(topk), ask_volumes(topk);
+    size_t count = 0;
+    for (; !reader.done(); ++count) {
+        reader.delta(timestamp);
+        for (auto& value : ohlc)
+            reader.delta(value);
+        uint64_t volume = reader.varint(), amount = reader.varint();
+        for (size_t i = 0; i < topk; ++i)
+            bid_prices[i] = to_double(reader.delta(prices[i]));
+        for (size_t i = 0; i < topk; ++i)
+            ask_prices[i] = to_double(reader.delta(prices[topk + i]));
+        for (auto& value : bid_volumes)
+            value = reader.varint();
+        for (auto& value : ask_volumes)
+            value = reader.varint();
+        for (auto& value : features)
+            value = reader.raw_double();
+        f(Tick(timestamp, to_double(ohlc[0]), to_double(ohlc[1]), to_double(ohlc[2]), to_double(ohlc[3]), volume, (double)amount,
+               bid_prices, ask_prices, bid_volumes, ask_volumes, features));
+    }
+    return count;
+}
+
+#endif  // __STREAM_WRITER_HPP__
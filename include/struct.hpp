@@ -2,9 +2,9 @@
 #define __STRUCT_HPP__
 
 #include <map>
-#include <memory>
 #include <string>
-#include "double_linked_list.hpp"
+#include <vector>
+#include "fenwick.hpp"
 #include "treap.hpp"
 
 enum Side : bool {
@@ -13,33 +13,115 @@ enum Side : bool {
 };
 
 struct Limit;
+template <>
+struct Node<Limit>;
 
+// A resting order is a single 48-byte record. What matching reads comes first and fits in 32
+// bytes: the remaining quantity, the next order of the level queue, the level and the uid. The
+// price is the one of the level.
 struct Order {
-    const uint64_t uid;
-    const uint64_t price;
     uint64_t quantity;
+    Order* next;
+    Limit* limit;
+    const uint64_t uid;
     const uint64_t timestamp;
-    std::weak_ptr<Limit> limit;
+    size_t slot;  // arrival slot in the queue index of the level, if the level has one
 
-    Order(uint64_t uid, uint64_t price, uint64_t quantity, uint64_t timestamp)
-        : uid(uid), price(price), quantity(quantity), timestamp(timestamp) {}
+    Order(uint64_t uid, uint64_t quantity, uint64_t timestamp)
+        : quantity(quantity), next(nullptr), limit(nullptr), uid(uid), timestamp(timestamp), slot(0) {}
+    inline uint64_t price() const;
 };
 
-struct Limit : public std::enable_shared_from_this<Limit> {
-    const Side side;
-    const uint64_t price;
+static_assert(sizeof(Order) == 48, "an order is 48 bytes");
+
+// Time priority queue of a level, linked through Order::next. Orders only leave from the front:
+// cancelled or amended ones stay in place with zero quantity until they reach it.
+struct OrderQueue {
+    Order *head, *tail;
+    uint32_t size;
+
+    OrderQueue()
+        : head(nullptr), tail(nullptr), size(0) {}
+    inline bool empty() const { return size == 0; }
+    inline Order* front() const { return head; }
+    inline void push_back(Order* order) {
+        order->next = nullptr;
+        if (tail)
+            tail->next = order;
+        else
+            head = order;
+        tail = order;
+        ++size;
+    }
+    inline Order* pop_front() {
+        Order* order = head;
+        head = order->next;
+        if (!head)
+            tail = nullptr;
+        --size;
+        return order;
+    }
+};
+
+// Order statistics of a level queue over arrival slots: the quantity and the number of live
+// orders in each slot. Orders leaving the queue keep their slot with zero weight, the slots are
+// renumbered when most of them are dead.
+struct QueueIndex {
+    FenwickTree<int64_t> quantity, count;
+
+    QueueIndex(std::pmr::memory_resource* resource)
+        : quantity(resource), count(resource) {}
+    void rebuild(const OrderQueue& orders) {
+        quantity.clear();
+        count.clear();
+        for (auto order = orders.head; order; order = order->next)
+            append(order);
+    }
+    void append(Order* order) {
+        order->slot = quantity.size();
+        quantity.push_back(order->quantity);
+        count.push_back(order->quantity > 0);
+    }
+    void push(Order* order, const OrderQueue& orders) {
+        if (quantity.size() >= 64 && quantity.size() >= 2 * orders.size)
+            rebuild(orders);  // already holds `order` at its back
+        else
+            append(order);
+    }
+};
+
+// A price level is one cache line, the quantity and the queue that matching reads come first.
+struct alignas(64) Limit {
+    static constexpr uint32_t not_stale = -1;
+
     uint64_t quantity;
-    DoubleLinkedList<std::shared_ptr<Order>> orders;
+    OrderQueue orders;
+    const uint64_t price;
+    Node<Limit>* node;   // tree node of the level
+    QueueIndex* queue;   // built on the first queue position query
+    uint32_t stale;      // index in the book's list of levels with stale subtree aggregates, or not_stale
+    const Side side;
 
     Limit(uint64_t price, Side side)
-        : side(side), price(price), quantity(0) {}
+        : quantity(0), price(price), node(nullptr), queue(nullptr), stale(not_stale), side(side) {}
     bool operator<(const Limit& other) const { return std::make_pair(side, price) < std::make_pair(other.side, other.price); }
     bool operator==(const Limit& other) const { return std::make_pair(side, price) == std::make_pair(other.side, other.price); }
     bool operator>(const Limit& other) const { return std::make_pair(side, price) > std::make_pair(other.side, other.price); }
-    void insert(std::shared_ptr<Order>& order) {
+    void insert(Order* order) {
         orders.push_back(order);
         quantity += order->quantity;
-        order->limit = weak_from_this();
+        order->limit = this;
+        if (queue)
+            queue->push(order, orders);
+    }
+    void reduce(Order* order, uint64_t delta) {
+        quantity -= delta;
+        order->quantity -= delta;
+        if (queue) {
+            queue->quantity.add(order->slot, -(int64_t)delta);
+            if (order->quantity == 0 && delta > 0)
+                queue->count.add(order->slot, -1);
+        }
     }
     friend std::ostream& operator<<(std::ostream& os, const Limit& limit) {
         os << "Limit(" << (limit.side == Bid ? "Bid" : "Ask") << ", " << limit.price << ", " << limit.quantity << ")";
@@ -47,19 +129,22 @@ struct Limit : public std::enable_shared_from_this<Limit> {
     }
 };
 
+static_assert(sizeof(Limit) == 64, "a level is one cache line");
+
+inline uint64_t Order::price() const { return limit->price; }
+
 template <>
-struct Node<Limit> : std::enable_shared_from_this<Node<Limit>> {
-    std::shared_ptr<Limit> value_ptr;
+struct Node<Limit> {
+    Limit* value_ptr;
     size_t size;
     size_t priority;
     uint64_t sum_quantity, count_orders;
-    std::shared_ptr<Node<Limit>> left, right;
-    std::weak_ptr<Node<Limit>> parent;
+    Node<Limit> *left, *right;
+    Node<Limit>* parent;
+    Node<Limit> *predecessor, *successor;
 
-    Node(std::shared_ptr<Limit> value_ptr)
-        : value_ptr(value_ptr), size(1), priority(rand()), sum_quantity(0), count_orders(0) {}
-    Node(Limit value)
-        : value_ptr(std::make_shared<Limit>(value)), size(1), priority(rand()), sum_quantity(0), count_orders(0) {}
+    Node(Limit* value_ptr)
+        : value_ptr(value_ptr), size(1), priority(rand()), sum_quantity(0), count_orders(0), left(nullptr), right(nullptr), parent(nullptr), predecessor(nullptr), successor(nullptr) {}
     void update() {
         size = 1;
         sum_quantity = value_ptr->quantity;
@@ -76,46 +161,17 @@ struct Node<Limit> : std::enable_shared_from_this<Node<Limit>> {
         }
     }
     Limit& value() { return *value_ptr; }
-    std::shared_ptr<Node<Limit>> prev();
-    std::shared_ptr<Node<Limit>> next();
+    inline Node<Limit>* prev() { return predecessor; }
+    inline Node<Limit>* next() { return successor; }
 };
 
-std::shared_ptr<Node<Limit>> Node<Limit>::prev() {
-    std::shared_ptr<Node<Limit>> node;
-    if (left) {
-        node = left;
-        while (node->right)
-            node = node->right;
-        return node;
-    } else {
-        node = this->shared_from_this();
-        while (node->parent.lock() && node->parent.lock()->left == node)
-            node = node->parent.lock();
-        return node->parent.lock();
-    }
-}
-
-std::shared_ptr<Node<Limit>> Node<Limit>::next() {
-    std::shared_ptr<Node<Limit>> node;
-    if (right) {
-        node = right;
-        while (node->left)
-            node = node->left;
-        return node;
-    } else {
-        node = this->shared_from_this();
-        while (node->parent.lock() && node->parent.lock()->right == node)
-            node = node->parent.lock();
-        return node->parent.lock();
-    }
-}
-
 enum QuoteType {
     LimitOrder,
     MarketOrder,
     BestPriceOrder,
     CancelOrder,
-    FillOrder
+    FillOrder,
+    ModifyOrder
 };
 
 struct Quote {
@@ -141,9 +197,34 @@ struct Transaction {
     const uint64_t bid_uid, ask_uid;
     const uint64_t price, quantity;
     const uint64_t timestamp;
-    const double real_price;
-    Transaction(uint64_t bid_uid, uint64_t ask_uid, uint64_t price, uint64_t quantity, uint64_t timestamp, double real_price)
-        : bid_uid(bid_uid), ask_uid(ask_uid), price(price), quantity(quantity), timestamp(timestamp), real_price(real_price) {}
+    Transaction(uint64_t bid_uid, uint64_t ask_uid, uint64_t price, uint64_t quantity, uint64_t timestamp)
+        : bid_uid(bid_uid), ask_uid(ask_uid), price(price), quantity(quantity), timestamp(timestamp) {}
+};
+
+// What the engine knows about each transaction when it matches, columnar and aligned with the
+// transactions of a book, see LimitOrderBook::get_trade_details.
+struct TradeDetails {
+    static constexpr uint8_t no_aggressor = 2;  // call auction or a trade at a given price
+
+    std::vector<uint8_t> aggressor;   // Side of the incoming order, or no_aggressor
+    std::vector<uint32_t> sweep;      // price levels the incoming order had traded through before this one
+    std::vector<uint8_t> depleted;    // the trade emptied the level of the resting order
+    std::vector<uint64_t> queue_age;  // nanoseconds the resting order had waited
+
+    size_t size() const { return aggressor.size(); }
+    void push_back(uint8_t aggressor, uint32_t sweep, bool depleted, uint64_t queue_age) {
+        this->aggressor.push_back(aggressor);
+        this->sweep.push_back(sweep);
+        this->depleted.push_back(depleted);
+        this->queue_age.push_back(queue_age);
+    }
+    void clear() {
+        aggressor.clear();
+        sweep.clear();
+        depleted.clear();
+        queue_age.clear();
+    }
+    size_t bytes() const { return size() * (2 * sizeof(uint8_t) + sizeof(uint32_t) + sizeof(uint64_t)); }
 };
 
 struct Tick {
@@ -153,8 +234,9 @@ struct Tick {
     const double amount;
     const std::vector<double> bid_prices, ask_prices;
     const std::vector<uint64_t> bid_volumes, ask_volumes;
-    Tick(uint64_t timestamp, double open, double high, double low, double close, uint64_t volume, double amount, const std::vector<double>& bid_prices, const std::vector<double>& ask_prices, const std::vector<uint64_t>& bid_volumes, const std::vector<uint64_t>& ask_volumes)
-        : timestamp(timestamp), open(open), high(high), low(low), close(close), volume(volume), amount(amount), bid_prices(bid_prices), ask_prices(ask_prices), bid_volumes(bid_volumes), ask_volumes(ask_volumes) {}
+    const std::vector<double> features;  // in the order configured by LimitOrderBook::set_features
+    Tick(uint64_t timestamp, double open, double high, double low, double close, uint64_t volume, double amount, const std::vector<double>& bid_prices, const std::vector<double>& ask_prices, const std::vector<uint64_t>& bid_volumes, const std::vector<uint64_t>& ask_volumes, const std::vector<double>& features = {})
+        : timestamp(timestamp), open(open), high(high), low(low), close(close), volume(volume), amount(amount), bid_prices(bid_prices), ask_prices(ask_prices), bid_volumes(bid_volumes), ask_volumes(ask_volumes), features(features) {}
 };
 
 #endif  // __STRUCT_HPP__
\ No newline at end of file
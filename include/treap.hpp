@@ -1,23 +1,25 @@
 #ifndef __TREAP_HPP__
 #define __TREAP_HPP__
 
-#include <memory>
+#include <algorithm>
+#include <cstdlib>
+#include <ostream>
 #include <stack>
 #include <tuple>
 #include <vector>
+#include "arena.hpp"
 
 template <typename T>
-struct Node : public std::enable_shared_from_this<Node<T>> {
-    std::shared_ptr<T> value_ptr;
+struct Node {
+    T* value_ptr;
     size_t size;
     size_t priority;
-    std::shared_ptr<Node<T>> left, right;
-    std::weak_ptr<Node<T>> parent;
+    Node<T> *left, *right;
+    Node<T>* parent;
+    Node<T> *predecessor, *successor;  // in-order neighbors, maintained by Treap::insert/remove
 
-    Node(std::shared_ptr<T> value_ptr)
-        : value_ptr(value_ptr), size(1), priority(rand()) {}
-    Node(T value)
-        : value_ptr(std::make_shared<T>(value)), size(1), priority(rand()) {}
+    Node(T* value_ptr)
+        : value_ptr(value_ptr), size(1), priority(rand()), left(nullptr), right(nullptr), parent(nullptr), predecessor(nullptr), successor(nullptr) {}
     void update() {
         size = 1;
         if (left)
@@ -26,286 +28,369 @@ struct Node : public std::enable_shared_from_this<Node<T>> {
             size += right->size;
     }
     T& value() { return *value_ptr; }
-    std::shared_ptr<Node<T>> prev();
-    std::shared_ptr<Node<T>> next();
+    inline Node<T>* prev() { return predecessor; }
+    inline Node<T>* next() { return successor; }
 };
 
-template <typename T>
-std::shared_ptr<Node<T>> Node<T>::prev() {
-    std::shared_ptr<Node<T>> node;
-    if (left) {
-        node = left;
-        while (node->right)
-            node = node->right;
-        return node;
-    } else {
-        node = this->shared_from_this();
-        while (node->parent.lock() && node->parent.lock()->left == node)
-            node = node->parent.lock();
-        return node->parent.lock();
-    }
-}
-
-template <typename T>
-std::shared_ptr<Node<T>> Node<T>::next() {
-    std::shared_ptr<Node<T>> node;
-    if (right) {
-        node = right;
-        while (node->left)
-            node = node->left;
-        return node;
-    } else {
-        node = this->shared_from_this();
-        while (node->parent.lock() && node->parent.lock()->right == node)
-            node = node->parent.lock();
-        return node->parent.lock();
-    }
-}
-
 template <typename T>
 class Treap {
+    ObjectPool<Node<T>>* pool;
+
    public:
-    std::shared_ptr<Node<T>> root;
+    Node<T>* root;
+    Node<T> *first, *last;
 
    private:
-    std::tuple<std::shared_ptr<Node<T>>, std::shared_ptr<Node<T>>, std::shared_ptr<Node<T>>>
-    split_by_value(std::shared_ptr<Node<T>> node, const T& value);
-    std::tuple<std::shared_ptr<Node<T>>, std::shared_ptr<Node<T>>, std::shared_ptr<Node<T>>>
-    split_by_index(std::shared_ptr<Node<T>> node, size_t index);
-    std::shared_ptr<Node<T>> merge(std::shared_ptr<Node<T>> left, std::shared_ptr<Node<T>> right);
+    std::vector<Node<T>*> path;  // scratch space of the iterative split/merge
+
+    template <typename Compare>
+    std::tuple<Node<T>*, Node<T>*, Node<T>*>
+    split(Node<T>* node, Compare compare);
+    std::tuple<Node<T>*, Node<T>*, Node<T>*>
+    split_by_value(Node<T>* node, const T& value);
+    std::tuple<Node<T>*, Node<T>*, Node<T>*>
+    split_by_index(Node<T>* node, size_t index);
+    Node<T>* merge(Node<T>* left, Node<T>* right);
 
    public:
-    Treap()
-        : root(nullptr) {}
+    Treap(ObjectPool<Node<T>>& pool)
+        : pool(&pool), root(nullptr), first(nullptr), last(nullptr) {}
     void clear();
-    bool empty();
-    size_t size();
-    void insert(const T& value);
-    void insert(std::shared_ptr<T> value_ptr);
+    bool empty() const;
+    size_t size() const;
+    size_t height();
+    Node<T>* insert(T* value_ptr);
+    void build_from_sorted(const std::vector<T*>& values);
     void remove(const T& value);
-    std::shared_ptr<Node<T>> select_by_value(const T& value);
-    std::shared_ptr<Node<T>> select_by_index(size_t index);
-    std::shared_ptr<Node<T>> min();
-    std::shared_ptr<Node<T>> max();
-    std::vector<std::shared_ptr<Node<T>>> nlargest(size_t n);
-    std::vector<std::shared_ptr<Node<T>>> nsmallest(size_t n);
-    std::shared_ptr<Node<T>> kth_largest(size_t k);
-    std::shared_ptr<Node<T>> kth_smallest(size_t k);
+    Node<T>* select_by_value(const T& value);
+    Node<T>* select_by_index(size_t index);
+    Node<T>* min();
+    Node<T>* max();
+    std::vector<Node<T>*> nlargest(size_t n);
+    std::vector<Node<T>*> nsmallest(size_t n);
+    Node<T>* kth_largest(size_t k);
+    Node<T>* kth_smallest(size_t k);
 };
 
+// Splits the subtree into the nodes ordered before the key, the node equal to the key and the
+// nodes ordered after it. `compare(node)` is negative when the node belongs to the left part and
+// positive when it belongs to the right part. The descent is iterative: pieces are attached to the
+// open right (resp. left) slot of the last node moved to the left (resp. right) part, and the
+// touched nodes are updated bottom-up afterwards.
 template <typename T>
-std::tuple<std::shared_ptr<Node<T>>, std::shared_ptr<Node<T>>, std::shared_ptr<Node<T>>>
-Treap<T>::split_by_value(std::shared_ptr<Node<T>> node, const T& value) {
-    if (!node)
-        return std::make_tuple(nullptr, nullptr, nullptr);
-    if (node->value() < value) {
-        auto [left, middle, right] = split_by_value(node->right, value);
-        node->right = left;
-        if (left)
-            left->parent = node;
-        node->update();
-        return std::make_tuple(node, middle, right);
-    } else if (value < node->value()) {
-        auto [left, middle, right] = split_by_value(node->left, value);
-        node->left = right;
-        if (right)
-            right->parent = node;
-        node->update();
-        return std::make_tuple(left, middle, node);
-    } else {
-        std::shared_ptr<Node<T>> left = node->left;
-        std::shared_ptr<Node<T>> right = node->right;
-        node->left = nullptr;
-        node->right = nullptr;
-        if (left)
-            left->parent = std::weak_ptr<Node<T>>();
-        if (right)
-            right->parent = std::weak_ptr<Node<T>>();
-        node->update();
-        return std::make_tuple(left, node, right);
+template <typename Compare>
+std::tuple<Node<T>*, Node<T>*, Node<T>*>
+Treap<T>::split(Node<T>* node, Compare compare) {
+    Node<T> *left = nullptr, *middle = nullptr, *right = nullptr;
+    Node<T> **left_slot = &left, **right_slot = &right;
+    Node<T> *left_parent = nullptr, *right_parent = nullptr;
+    path.clear();
+    while (node) {
+        int order = compare(node);
+        if (order < 0) {
+            *left_slot = node;
+            node->parent = left_parent;
+            left_parent = node;
+            left_slot = &node->right;
+            path.push_back(node);
+            node = node->right;
+        } else if (order > 0) {
+            *right_slot = node;
+            node->parent = right_parent;
+            right_parent = node;
+            right_slot = &node->left;
+            path.push_back(node);
+            node = node->left;
+        } else {
+            middle = node;
+            node = nullptr;
+            *left_slot = middle->left;
+            *right_slot = middle->right;
+            if (middle->left)
+                middle->left->parent = left_parent;
+            if (middle->right)
+                middle->right->parent = right_parent;
+            middle->left = middle->right = middle->parent = nullptr;
+            middle->update();
+            left_slot = right_slot = nullptr;
+        }
     }
+    if (left_slot)
+        *left_slot = nullptr;
+    if (right_slot)
+        *right_slot = nullptr;
+    for (auto it = path.rbegin(); it != path.rend(); ++it)
+        (*it)->update();
+    return std::make_tuple(left, middle, right);
 }
 
 template <typename T>
-std::tuple<std::shared_ptr<Node<T>>, std::shared_ptr<Node<T>>, std::shared_ptr<Node<T>>>
-Treap<T>::split_by_index(std::shared_ptr<Node<T>> node, size_t index) {
-    if (!node)
-        return std::make_tuple(nullptr, nullptr, nullptr);
-    size_t current_index = (node->left ? node->left->size : 0) + 1;
-    if (index < current_index) {
-        auto [left, middle, right] = split_by_index(node->left, index);
-        node->left = right;
-        if (right)
-            right->parent = node;
-        node->update();
-        return std::make_tuple(left, middle, node);
-    } else if (current_index < index) {
-        auto [left, middle, right] = split_by_index(node->right, index - current_index);
-        node->right = left;
-        if (left)
-            left->parent = node;
-        node->update();
-        return std::make_tuple(node, middle, right);
-    } else {
-        std::shared_ptr<Node<T>> left = node->left;
-        std::shared_ptr<Node<T>> right = node->right;
-        node->left = nullptr;
-        node->right = nullptr;
-        if (left)
-            left->parent = std::weak_ptr<Node<T>>();
-        if (right)
-            right->parent = std::weak_ptr<Node<T>>();
-        node->update();
-        return std::make_tuple(left, node, right);
-    }
+std::tuple<Node<T>*, Node<T>*, Node<T>*>
+Treap<T>::split_by_value(Node<T>* node, const T& value) {
+    return split(node, [&value](Node<T>* node) {
+        return node->value() < value ? -1 : value < node->value() ? 1 : 0;
+    });
+}
+
+template <typename T>
+std::tuple<Node<T>*, Node<T>*, Node<T>*>
+Treap<T>::split_by_index(Node<T>* node, size_t index) {
+    return split(node, [&index](Node<T>* node) {
+        size_t current_index = (node->left ? node->left->size : 0) + 1;
+        if (current_index < index) {
+            index -= current_index;
+            return -1;
+        }
+        return index < current_index ? 1 : 0;
+    });
 }
 
 template <typename T>
-std::shared_ptr<Node<T>>
-Treap<T>::merge(std::shared_ptr<Node<T>> left, std::shared_ptr<Node<T>> right) {
-    if (!left || !right)
-        return left ? left : right;
-    if (left->priority > right->priority) {
-        left->right = merge(left->right, right);
-        if (left->right)
-            left->right->parent = left;
-        left->update();
-        return left;
-    } else {
-        right->left = merge(left, right->left);
-        if (right->left)
-            right->left->parent = right;
-        right->update();
-        return right;
+Node<T>*
+Treap<T>::merge(Node<T>* left, Node<T>* right) {
+    Node<T>* root = nullptr;
+    Node<T>** slot = &root;
+    Node<T>* parent = nullptr;
+    path.clear();
+    while (left && right) {
+        if (left->priority > right->priority) {
+            *slot = left;
+            left->parent = parent;
+            parent = left;
+            slot = &left->right;
+            path.push_back(left);
+            left = left->right;
+        } else {
+            *slot = right;
+            right->parent = parent;
+            parent = right;
+            slot = &right->left;
+            path.push_back(right);
+            right = right->left;
+        }
     }
+    *slot = left ? left : right;
+    if (*slot)
+        (*slot)->parent = parent;
+    for (auto it = path.rbegin(); it != path.rend(); ++it)
+        (*it)->update();
+    return root;
 }
 
 template <typename T>
 void Treap<T>::clear() {
-    root = nullptr;
+    root = first = last = nullptr;
 }
 
 template <typename T>
-bool Treap<T>::empty() {
+bool Treap<T>::empty() const {
     return !root;
 }
 
 template <typename T>
-size_t Treap<T>::size() {
+size_t Treap<T>::size() const {
     return root ? root->size : 0;
 }
 
+// number of nodes on the longest root-to-leaf path, O(n log n)
 template <typename T>
-void Treap<T>::insert(const T& value) {
-    insert(std::make_shared<T>(value));
+size_t Treap<T>::height() {
+    size_t height = 0;
+    for (auto node = first; node; node = node->successor) {
+        if (node->left || node->right)
+            continue;
+        size_t depth = 1;
+        for (auto ancestor = node->parent; ancestor; ancestor = ancestor->parent)
+            ++depth;
+        height = std::max(height, depth);
+    }
+    return height;
 }
 
+// Standard treap insertion: descend while the ancestors outrank the new node, then split the
+// subtree hanging there around the new node. Ancestors where the descent turned right (left) are
+// the predecessor (successor) candidates when the corresponding part of the split is empty.
 template <typename T>
-void Treap<T>::insert(std::shared_ptr<T> value_ptr) {
-    auto [left, middle, right] = split_by_value(root, *value_ptr);
-    if (middle)
-        return;
-    std::shared_ptr<Node<T>> node = std::make_shared<Node<T>>(value_ptr);
+Node<T>* Treap<T>::insert(T* value_ptr) {
+    const T& value = *value_ptr;
+    Node<T>* existing = select_by_value(value);
+    if (existing)
+        return existing;
+
+    Node<T>* node = pool->create(value_ptr);
+    Node<T>** slot = &root;
+    Node<T> *parent = nullptr, *predecessor = nullptr, *successor = nullptr;
+    while (*slot && (*slot)->priority >= node->priority) {
+        parent = *slot;
+        if (value < parent->value()) {
+            successor = parent;
+            slot = &parent->left;
+        } else {
+            predecessor = parent;
+            slot = &parent->right;
+        }
+    }
+    auto [left, middle, right] = split_by_value(*slot, value);
+    node->left = left;
+    node->right = right;
     if (left)
         left->parent = node;
     if (right)
         right->parent = node;
-    node->left = left;
-    node->right = right;
-    node->update();
-    root = node;
+    node->parent = parent;
+    *slot = node;
+    for (Node<T>* ancestor = node; ancestor; ancestor = ancestor->parent)
+        ancestor->update();
+
+    if (left) {
+        predecessor = left;
+        while (predecessor->right)
+            predecessor = predecessor->right;
+    }
+    if (right) {
+        successor = right;
+        while (successor->left)
+            successor = successor->left;
+    }
+    node->predecessor = predecessor;
+    node->successor = successor;
+    (predecessor ? predecessor->successor : first) = node;
+    (successor ? successor->predecessor : last) = node;
+    return node;
 }
 
+// Builds the treap from values sorted in strictly increasing order in linear time: the right spine
+// of the tree is kept on a stack, each new node pops the spine nodes with a lower priority (which
+// are complete at that point and get updated) and adopts them as its left subtree.
 template <typename T>
-void Treap<T>::remove(const T& value) {
-    auto [left, middle, right] = split_by_value(root, value);
-    root = merge(left, right);
+void Treap<T>::build_from_sorted(const std::vector<T*>& values) {
+    for (Node<T>* node = first; node;) {
+        Node<T>* successor = node->successor;
+        pool->destroy(node);
+        node = successor;
+    }
+    root = first = last = nullptr;
+
+    path.clear();
+    for (T* value_ptr : values) {
+        Node<T>* node = pool->create(value_ptr);
+        Node<T>* child = nullptr;
+        while (!path.empty() && path.back()->priority < node->priority) {
+            child = path.back();
+            child->update();
+            path.pop_back();
+        }
+        node->left = child;
+        if (child)
+            child->parent = node;
+        if (!path.empty()) {
+            path.back()->right = node;
+            node->parent = path.back();
+        }
+        path.push_back(node);
+
+        node->predecessor = last;
+        (last ? last->successor : first) = node;
+        last = node;
+    }
+    root = path.empty() ? nullptr : path.front();
+    while (!path.empty()) {
+        path.back()->update();
+        path.pop_back();
+    }
 }
 
 template <typename T>
-std::shared_ptr<Node<T>> Treap<T>::select_by_value(const T& value) {
-    auto [left, middle, right] = split_by_value(root, value);
-    root = merge(merge(left, middle), right);
-    return middle;
+void Treap<T>::remove(const T& value) {
+    Node<T>* node = select_by_value(value);
+    if (!node)
+        return;
+    Node<T>* parent = node->parent;
+    Node<T>* child = merge(node->left, node->right);
+    if (child)
+        child->parent = parent;
+    (parent ? (parent->left == node ? parent->left : parent->right) : root) = child;
+    for (Node<T>* ancestor = parent; ancestor; ancestor = ancestor->parent)
+        ancestor->update();
+
+    (node->predecessor ? node->predecessor->successor : first) = node->successor;
+    (node->successor ? node->successor->predecessor : last) = node->predecessor;
+    pool->destroy(node);
 }
 
 template <typename T>
-std::shared_ptr<Node<T>> Treap<T>::select_by_index(size_t index) {
-    auto [left, middle, right] = split_by_index(root, index);
-    root = merge(merge(left, middle), right);
-    return middle;
+Node<T>* Treap<T>::select_by_value(const T& value) {
+    Node<T>* node = root;
+    while (node) {
+        if (value < node->value())
+            node = node->left;
+        else if (node->value() < value)
+            node = node->right;
+        else
+            break;
+    }
+    return node;
 }
 
 template <typename T>
-std::shared_ptr<Node<T>> Treap<T>::min() {
-    std::shared_ptr<Node<T>> node = root;
-    while (node->left)
-        node = node->left;
+Node<T>* Treap<T>::select_by_index(size_t index) {
+    Node<T>* node = root;
+    while (node) {
+        size_t current_index = (node->left ? node->left->size : 0) + 1;
+        if (index < current_index) {
+            node = node->left;
+        } else if (current_index < index) {
+            index -= current_index;
+            node = node->right;
+        } else {
+            break;
+        }
+    }
     return node;
 }
 
 template <typename T>
-std::shared_ptr<Node<T>> Treap<T>::max() {
-    std::shared_ptr<Node<T>> node = root;
-    while (node->right)
-        node = node->right;
-    return node;
+Node<T>* Treap<T>::min() {
+    return first;
+}
+
+template <typename T>
+Node<T>* Treap<T>::max() {
+    return last;
 }
 
 template <typename T>
-std::shared_ptr<Node<T>> Treap<T>::kth_largest(size_t k) {
+Node<T>* Treap<T>::kth_largest(size_t k) {
     return select_by_index(size() - k + 1);
 }
 
 template <typename T>
-std::shared_ptr<Node<T>> Treap<T>::kth_smallest(size_t k) {
+Node<T>* Treap<T>::kth_smallest(size_t k) {
     return select_by_index(k);
 }
 
 template <typename T>
-std::vector<std::shared_ptr<Node<T>>> Treap<T>::nlargest(size_t n) {
-    std::vector<std::shared_ptr<Node<T>>> nodes;
-    std::stack<std::shared_ptr<Node<T>>> stack;
-    std::shared_ptr<Node<T>> node = root;
-    while (node || !stack.empty()) {
-        while (node) {
-            stack.push(node);
-            node = node->right;
-        }
-        node = stack.top();
-        stack.pop();
+std::vector<Node<T>*> Treap<T>::nlargest(size_t n) {
+    std::vector<Node<T>*> nodes;
+    nodes.reserve(std::min(n, size()));
+    for (Node<T>* node = last; node && nodes.size() < n; node = node->predecessor)
         nodes.push_back(node);
-        if (nodes.size() == n)
-            break;
-        node = node->left;
-    }
     return nodes;
 }
 
 template <typename T>
-std::vector<std::shared_ptr<Node<T>>> Treap<T>::nsmallest(size_t n) {
-    std::vector<std::shared_ptr<Node<T>>> nodes;
-    std::stack<std::shared_ptr<Node<T>>> stack;
-    std::shared_ptr<Node<T>> node = root;
-    while (node || !stack.empty()) {
-        while (node) {
-            stack.push(node);
-            node = node->left;
-        }
-        node = stack.top();
-        stack.pop();
+std::vector<Node<T>*> Treap<T>::nsmallest(size_t n) {
+    std::vector<Node<T>*> nodes;
+    nodes.reserve(std::min(n, size()));
+    for (Node<T>* node = first; node && nodes.size() < n; node = node->successor)
         nodes.push_back(node);
-        if (nodes.size() == n)
-            break;
-        node = node->right;
-    }
     return nodes;
 }
 
 template <typename T>
 std::ostream& operator<<(std::ostream& os, const Treap<T>& treap) {
-    std::stack<std::shared_ptr<Node<T>>> stack;
-    std::shared_ptr<Node<T>> node = treap.root;
+    std::stack<Node<T>*> stack;
+    Node<T>* node = treap.root;
     while (node || !stack.empty()) {
         while (node) {
             stack.push(node);
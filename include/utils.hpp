@@ -1,6 +1,7 @@
 #ifndef __UTILS_HPP__
 #define __UTILS_HPP__
 
+#include <cassert>
 #include <chrono>
 #include <experimental/tuple>
 #include <iomanip>
@@ -1,16 +1,83 @@
+import glob
+import os
+
 from pybind11.setup_helpers import Pybind11Extension, build_ext
 from setuptools import setup
 
+# FLOB_STATS=1 compiles in the latency histograms and counters of `LimitOrderBook.stats()`
+define_macros = [("FLOB_STATS", None)] if os.environ.get("FLOB_STATS", "0") not in ("", "0") else []
+
+# FLOB_LTO=1 enables link-time optimization, FLOB_PGO=generate|use builds with instrumentation or
+# with the profiles collected in FLOB_PGO_DIR, for the extension and flob-replay alike:
+#   FLOB_PGO=generate python setup.py build_ext --inplace
+#   build/bin/flob-replay --generate 2000000 --seed 1       # trains the executable on a synthetic day
+#   python -c "import flob; flob.replay(['--generate', '2000000', '--seed', '1'])"  # the same day trains the extension
+#   FLOB_PGO=use python setup.py build_ext --inplace
+optimize_args = ["-flto=auto"] if os.environ.get("FLOB_LTO", "0") not in ("", "0") else []
+pgo = os.environ.get("FLOB_PGO", "")
+pgo_dir = os.path.abspath(os.environ.get("FLOB_PGO_DIR", "build/pgo"))
+if pgo == "generate":
+    optimize_args += ["-fprofile-generate=" + pgo_dir, "-fprofile-update=atomic"]  # results are streamed from a thread
+elif pgo == "use":
+    optimize_args += ["-fprofile-use=" + pgo_dir, "-fprofile-correction", "-Wno-missing-profile"]
+elif pgo:
+    raise ValueError("FLOB_PGO must be generate or use")
+
 ext_modules = [
     Pybind11Extension(
         "flob",
         ["src/flob.cpp"],
         include_dirs=["include"],
+        define_macros=define_macros,
         cxx_std=17,
-        extra_compile_args=["-O3"],  # -Ofast may cause precision error
+        extra_compile_args=["-O3", "-pthread"] + optimize_args,  # -Ofast may cause precision error
+        extra_link_args=["-pthread"] + optimize_args,  # result streams are written from a background thread
     )
 ]
 
+
+class build_ext_with_benchmarks(build_ext):
+    """builds the native benchmarks of `benchmark/` into `build/bench`, the native tests of `tests/`
+    into `build/tests` and the flob-replay executable into `build/bin` next to the extension"""
+
+    def run(self):
+        super().run()
+        objects = self.compiler.compile(
+            ["src/replay.cpp"],
+            output_dir=self.build_temp,
+            macros=[("NDEBUG", None)] + define_macros,
+            include_dirs=["include"],
+            extra_postargs=["-std=c++17", "-O3", "-pthread"] + optimize_args,
+        )
+        output_dir = os.path.join(os.path.dirname(self.build_temp), "bin")
+        self.compiler.link_executable(objects, "flob-replay", output_dir=output_dir, extra_postargs=["-pthread"] + optimize_args, target_lang="c++")
+
+        output_dir = os.path.join(os.path.dirname(self.build_temp), "bench")
+        for source in sorted(glob.glob("benchmark/*.cpp")):
+            objects = self.compiler.compile(
+                [source],
+                output_dir=self.build_temp,
+                macros=[("NDEBUG", None)] + define_macros,
+                include_dirs=["include", "benchmark"],
+                extra_postargs=["-std=c++17", "-O3", "-pthread"],
+            )
+            name = "flob_bench_" + os.path.splitext(os.path.basename(source))[0]
+            self.compiler.link_executable(objects, name, output_dir=output_dir, extra_postargs=["-pthread"], target_lang="c++")
+
+        # assertions stay on, run them with `pytest tests`
+        output_dir = os.path.join(os.path.dirname(self.build_temp), "tests")
+        for source in sorted(glob.glob("tests/test_*.cpp")):
+            name = os.path.splitext(os.path.basename(source))[0]
+            objects = self.compiler.compile(
+                [source],
+                output_dir=self.build_temp,
+                macros=define_macros,
+                include_dirs=["include", "tests"],
+                extra_postargs=["-std=c++17", "-O2", "-pthread"],
+            )
+            self.compiler.link_executable(objects, name, output_dir=output_dir, extra_postargs=["-pthread"], target_lang="c++")
+
+
 setup(
     name="flob",
     version="1.0.0",
@@ -19,5 +86,5 @@ setup(
     author_email="ganyunchong@gmail.com",
     url="https://github.com/Phimos/fast-limit-order-book",
     ext_modules=ext_modules,
-    cmdclass={"build_ext": build_ext},
+    cmdclass={"build_ext": build_ext_with_benchmarks},
 )
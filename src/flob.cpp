@@ -1,49 +1,462 @@
+#include <pybind11/functional.h>
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 #include <pybind11/stl.h>
 
+#include "demux.hpp"
+#include "generator.hpp"
 #include "limit_order_book.hpp"
+#include "market.hpp"
+#include "multi_book.hpp"
+#include "observer.hpp"
+#include "replay.hpp"
+#include "stats.hpp"
+#include "stream_writer.hpp"
 #include "struct.hpp"
 
 namespace py = pybind11;
 
-PYBIND11_MODULE(flob, m) {
-    m.doc() = "fast-limit-order-book";
+template <typename T>
+py::array_t<T> to_array(const std::vector<T>& values) {
+    return py::array_t<T>(values.size(), values.data());
+}
+
+py::dict to_dict(const Bars& bars) {
+    py::dict columns;
+    columns["timestamp"] = to_array(bars.timestamp);
+    columns["open"] = to_array(bars.open);
+    columns["high"] = to_array(bars.high);
+    columns["low"] = to_array(bars.low);
+    columns["close"] = to_array(bars.close);
+    columns["volume"] = to_array(bars.volume);
+    columns["amount"] = to_array(bars.amount);
+    if (bars.with_vwap)
+        columns["vwap"] = to_array(bars.vwap);
+    if (bars.with_count)
+        columns["count"] = to_array(bars.count);
+    return columns;
+}
+
+py::dict to_dict(const TradeDetails& details) {
+    py::dict columns;
+    columns["aggressor"] = to_array(details.aggressor);  // Side, 2 in call auctions
+    columns["sweep"] = to_array(details.sweep);
+    columns["depleted"] = to_array(details.depleted).attr("astype")("bool");
+    columns["queue_age"] = to_array(details.queue_age);
+    return columns;
+}
+
+py::dict to_dict(const LatencyHistogram& histogram) {
+    py::dict summary;
+    summary["count"] = histogram.count;
+    summary["mean"] = histogram.mean();
+    summary["min"] = histogram.min;
+    summary["p50"] = histogram.percentile(0.5);
+    summary["p90"] = histogram.percentile(0.9);
+    summary["p99"] = histogram.percentile(0.99);
+    summary["p999"] = histogram.percentile(0.999);
+    summary["max"] = histogram.max;
+    return summary;
+}
+
+py::dict to_dict(const BookStats& stats) {
+    const char* quote_names[] = {"limit_order", "market_order", "best_price_order", "cancel_order", "fill_order", "modify_order"};
+    const char* phase_names[] = {"call_auction", "continuous_trading", "closed", "snapshot"};
+    py::dict result, latency, counters, phases;
+    for (size_t i = 0; i < 6; ++i)
+        latency[quote_names[i]] = to_dict(stats.quotes[i]);
+    latency["match"] = to_dict(stats.match);
+    latency["match_call_auction"] = to_dict(stats.match_call_auction);
+    latency["snapshot"] = to_dict(stats.snapshot);
+    counters["levels_created"] = stats.levels_created;
+    counters["levels_destroyed"] = stats.levels_destroyed;
+    counters["max_queue_length"] = stats.max_queue_length;
+    counters["max_resting_orders"] = stats.max_resting_orders;
+    counters["resting_orders"] = stats.resting_orders;
+    counters["bid_levels"] = stats.bid_levels;
+    counters["ask_levels"] = stats.ask_levels;
+    counters["bid_tree_height"] = stats.bid_tree_height;
+    counters["ask_tree_height"] = stats.ask_tree_height;
+    for (size_t i = 0; i < 4; ++i) {
+        py::dict phase;
+        phase["count"] = stats.phases[i].count;
+        phase["nanoseconds"] = stats.phases[i].nanoseconds;
+        phase["cycles"] = stats.phases[i].cycles;
+        phase["instructions"] = stats.phases[i].instructions;
+        phase["cache_misses"] = stats.phases[i].cache_misses;
+        phases[phase_names[i]] = phase;
+    }
+    result["enabled"] = stats.enabled;
+    result["perf_available"] = stats.perf_available;
+    result["latency"] = latency;
+    result["counters"] = counters;
+    result["phases"] = phases;
+    return result;
+}
+
+template <typename Market>
+py::array_t<double> to_price_array(const std::vector<uint64_t>& prices) {
+    py::array_t<double> result(prices.size());
+    double* out = result.mutable_data();
+    for (size_t i = 0; i < prices.size(); ++i)
+        out[i] = prices[i] / (double)pow10(Market::decimal_places);
+    return result;
+}
+
+template <typename Market>
+py::dict to_dict(const EventBatch& batch) {
+    py::dict trade, fill, level, period, events;
+    trade["timestamp"] = to_array(batch.trade_timestamp);
+    trade["bid_uid"] = to_array(batch.trade_bid_uid);
+    trade["ask_uid"] = to_array(batch.trade_ask_uid);
+    trade["price"] = to_price_array<Market>(batch.trade_price);
+    trade["quantity"] = to_array(batch.trade_quantity);
+    fill["timestamp"] = to_array(batch.fill_timestamp);
+    fill["bid_uid"] = to_array(batch.fill_bid_uid);
+    fill["ask_uid"] = to_array(batch.fill_ask_uid);
+    fill["price"] = to_price_array<Market>(batch.fill_price);
+    fill["quantity"] = to_array(batch.fill_quantity);
+    level["timestamp"] = to_array(batch.level_timestamp);
+    level["side"] = to_array(batch.level_side);
+    level["price"] = to_price_array<Market>(batch.level_price);
+    level["quantity"] = to_array(batch.level_quantity);
+    period["timestamp"] = to_array(batch.period_timestamp);
+    period["status"] = batch.period_status;
+    events["trade"] = trade;
+    events["fill"] = fill;
+    events["level"] = level;
+    events["snapshot"] = batch.snapshots;
+    events["period_end"] = period;
+    return events;
+}
+
+template <typename Market>
+py::dict to_dict(const L3Snapshot& snapshot) {
+    py::dict columns;
+    columns["timestamp"] = snapshot.timestamp;
+    columns["level_price"] = to_price_array<Market>(snapshot.level_price);
+    columns["level_side"] = to_array(snapshot.level_side);
+    columns["level_quantity"] = to_array(snapshot.level_quantity);
+    columns["level_orders"] = to_array(snapshot.level_orders);
+    columns["order_uid"] = to_array(snapshot.order_uid);
+    columns["order_quantity"] = to_array(snapshot.order_quantity);
+    columns["order_timestamp"] = to_array(snapshot.order_timestamp);
+    return columns;
+}
+
+template <typename Market>
+py::list to_list(const std::vector<L3Snapshot>& snapshots) {
+    py::list result;
+    for (auto& snapshot : snapshots)
+        result.append(to_dict<Market>(snapshot));
+    return result;
+}
+
+// a transaction as seen from Python, with its price in currency units
+template <typename Market>
+struct MarketTransaction {
+    Transaction transaction;
+    double price() const { return transaction.price * (1.0 / (double)pow10(Market::decimal_places)); }
+};
+
+template <typename Market>
+std::vector<MarketTransaction<Market>> with_prices(const std::vector<Transaction>& transactions) {
+    std::vector<MarketTransaction<Market>> result;
+    result.reserve(transactions.size());
+    for (auto& transaction : transactions)
+        result.push_back({transaction});
+    return result;
+}
+
+py::dict to_dict(const MemoryUsage& usage) {
+    py::dict result;
+    result["orders"] = usage.orders;
+    result["levels"] = usage.levels;
+    result["tree_nodes"] = usage.tree_nodes;
+    result["queue_indexes"] = usage.queue_indexes;
+    result["hash_maps"] = usage.hash_maps;
+    result["arena_used"] = usage.arena_used;
+    result["arena_reserved"] = usage.arena_reserved;
+    result["quotes"] = usage.quotes;
+    result["transactions"] = usage.transactions;
+    result["fills"] = usage.fills;
+    result["ticks"] = usage.ticks;
+    result["pending"] = usage.pending;
+    result["streams"] = usage.streams;
+    result["checkpoints"] = usage.checkpoints;
+    result["l3"] = usage.l3;
+    result["total"] = usage.total;
+    result["peak"] = usage.peak;
+    return result;
+}
+
+typedef py::array_t<double, py::array::c_style | py::array::forcecast> double_array;
+typedef py::array_t<uint64_t, py::array::c_style | py::array::forcecast> uint64_array;
+
+// applies `f` elementwise over equally sized arrays
+template <typename R, typename F, typename... Arrays>
+py::array_t<R> vectorized(F f, const Arrays&... arrays) {
+    size_t sizes[] = {(size_t)arrays.size()...}, n = sizes[0];
+    for (size_t size : sizes)
+        if (size != n)
+            throw std::invalid_argument("arrays must have the same size");
+    py::array_t<R> result(n);
+    R* out = result.mutable_data();
+    for (size_t i = 0; i < n; ++i)
+        out[i] = f(arrays.data()[i]...);
+    return result;
+}
 
-    py::class_<LimitOrderBook>(m, "LimitOrderBook")
-        .def(py::init<size_t, uint64_t, size_t, const std::string&>(),
-             py::arg("decimal_places") = 2,
+template <typename Market>
+void bind_limit_order_book(py::module& m, const char* name) {
+    // the Python books deliver their events to a callback, see set_callback
+    typedef LimitOrderBook<Market, BatchObserver> Book;
+    typedef MarketTransaction<Market> PyTransaction;
+
+    py::class_<PyTransaction>(m, (std::string(Market::name) + "Transaction").c_str())
+        .def_property_readonly("bid_uid", [](const PyTransaction& t) { return t.transaction.bid_uid; })
+        .def_property_readonly("ask_uid", [](const PyTransaction& t) { return t.transaction.ask_uid; })
+        .def_property_readonly("price", &PyTransaction::price)
+        .def_property_readonly("quantity", [](const PyTransaction& t) { return t.transaction.quantity; })
+        .def_property_readonly("timestamp", [](const PyTransaction& t) { return t.transaction.timestamp; });
+
+    py::class_<Book>(m, name)
+        .def(py::init<uint64_t, size_t, const std::string&>(),
              py::arg("snapshot_gap") = 0,
              py::arg("topk") = 5,
-             py::arg("schedule") = "AShare")
-        .def("clear", &LimitOrderBook::clear)
-        .def("write", &LimitOrderBook::write, py::arg("quote"))
-        .def("set_status", py::overload_cast<TradingStatus>(&LimitOrderBook::set_status), py::arg("status"))
-        .def("set_status", py::overload_cast<const std::string&>(&LimitOrderBook::set_status), py::arg("status"))
+             py::arg("schedule") = Market::name)
+        .def_property_readonly("decimal_places", [](const Book&) { return Market::decimal_places; })
+        .def("clear", &Book::clear)
+        .def("write", &Book::write, py::arg("quote"))
+        .def("set_status", py::overload_cast<TradingStatus>(&Book::set_status), py::arg("status"))
+        .def("set_status", py::overload_cast<const std::string&>(&Book::set_status), py::arg("status"))
         .def("set_schedule",
-             py::overload_cast<const std::vector<std::tuple<TradingStatus, uint64_t, uint64_t>>&>(&LimitOrderBook::set_schedule),
+             py::overload_cast<const std::vector<TradingHour>&>(&Book::set_schedule),
              py::arg("schedule"))
-        .def("set_schedule", py::overload_cast<const std::string&>(&LimitOrderBook::set_schedule), py::arg("schedule"))
-        .def("set_snapshot_gap", &LimitOrderBook::set_snapshot_gap, py::arg("snapshot_gap"))
-        .def("load", &LimitOrderBook::load, py::arg("filename"), py::arg("header") = true)
-        .def("until", &LimitOrderBook::until, py::arg("timestamp"))
-        .def("run", &LimitOrderBook::run)
-        .def("match_call_auction", &LimitOrderBook::match_call_auction, py::arg("timestamp") = 0)
-        .def("get_topk_bid_price", &LimitOrderBook::get_topk_bid_price,
+        .def("set_schedule", py::overload_cast<const std::string&>(&Book::set_schedule), py::arg("schedule"))
+        .def("set_snapshot_gap", &Book::set_snapshot_gap, py::arg("snapshot_gap"))
+        .def("set_bar_frequencies", &Book::set_bar_frequencies,
+             py::arg("frequencies"), py::arg("vwap") = false, py::arg("count") = false)
+        .def("set_features", &Book::set_features, py::arg("names"))
+        .def("get_feature_names", &Book::get_feature_names)
+        .def("load", py::overload_cast<const std::string&, bool>(&Book::load), py::arg("filename"), py::arg("header") = true)
+        .def("load", py::overload_cast<const std::vector<std::string>&, bool>(&Book::load), py::arg("filenames"), py::arg("header") = true)
+        .def("until",
+             [](Book& book, uint64_t timestamp) {
+                 book.until(timestamp);
+                 book.get_observer().flush();
+             },
+             py::arg("timestamp"))
+        .def("set_callback",
+             [](Book& book, py::object callback, size_t batch_size) {
+                 if (callback.is_none())
+                     book.get_observer().set_sink(nullptr);
+                 else
+                     book.get_observer().set_sink([callback](const EventBatch& batch) { callback(to_dict<Market>(batch)); }, batch_size);
+             },
+             py::arg("callback"), py::arg("batch_size") = 4096)
+        .def("flush_events", [](Book& book) { book.get_observer().flush(); })
+        .def("set_latency", &Book::set_latency, py::arg("latency"), py::arg("jitter") = 0, py::arg("seed") = 0)
+        .def("submit", &Book::submit, py::arg("side"), py::arg("price"), py::arg("quantity"), py::arg("timestamp"))
+        .def("cancel", &Book::cancel, py::arg("uid"), py::arg("timestamp"))
+        .def_static("is_strategy", &Book::is_strategy, py::arg("uid"))
+        .def("get_fills", [](const Book& book) { return with_prices<Market>(book.get_fills()); })
+        .def("run",
+             [](Book& book) {
+                 book.run();
+                 book.get_observer().flush();
+             })
+        .def("match_call_auction", &Book::match_call_auction, py::arg("timestamp") = 0)
+        .def("snapshot", &Book::snapshot, py::arg("timestamp"))
+        .def("get_topk_bid_price", &Book::get_topk_bid_price,
              py::arg("k"), py::arg("fill") = false)
-        .def("get_topk_ask_price", &LimitOrderBook::get_topk_ask_price,
+        .def("get_topk_ask_price", &Book::get_topk_ask_price,
              py::arg("k"), py::arg("fill") = false)
-        .def("get_topk_bid_volume", &LimitOrderBook::get_topk_bid_volume,
+        .def("get_topk_bid_volume", &Book::get_topk_bid_volume,
              py::arg("k"), py::arg("fill") = false)
-        .def("get_topk_ask_volume", &LimitOrderBook::get_topk_ask_volume,
+        .def("get_topk_ask_volume", &Book::get_topk_ask_volume,
              py::arg("k"), py::arg("fill") = false)
-        .def("get_kth_bid_price", &LimitOrderBook::get_kth_bid_price, py::arg("k"))
-        .def("get_kth_ask_price", &LimitOrderBook::get_kth_ask_price, py::arg("k"))
-        .def("get_kth_bid_volume", &LimitOrderBook::get_kth_bid_volume, py::arg("k"))
-        .def("get_kth_ask_volume", &LimitOrderBook::get_kth_ask_volume, py::arg("k"))
-        .def("get_transactions", &LimitOrderBook::get_transactions)
-        .def("get_ticks", &LimitOrderBook::get_ticks)
-        .def("show", &LimitOrderBook::show, py::arg("n") = 10)
-        .def("show_transactions", &LimitOrderBook::show_transactions, py::arg("n") = 10);
+        .def("get_kth_bid_price", &Book::get_kth_bid_price, py::arg("k"))
+        .def("get_kth_ask_price", &Book::get_kth_ask_price, py::arg("k"))
+        .def("get_kth_bid_volume", &Book::get_kth_bid_volume, py::arg("k"))
+        .def("get_kth_ask_volume", &Book::get_kth_ask_volume, py::arg("k"))
+        .def("depth_between", &Book::depth_between, py::arg("side"), py::arg("lo"), py::arg("hi"))
+        .def("depth_between",
+             [](Book& book, Side side, double_array lo, double_array hi) {
+                 return vectorized<uint64_t>([&](double l, double h) { return book.depth_between(side, l, h); }, lo, hi);
+             },
+             py::arg("side"), py::arg("lo"), py::arg("hi"))
+        .def("volume_to_price", &Book::volume_to_price, py::arg("side"), py::arg("price"))
+        .def("volume_to_price",
+             [](Book& book, Side side, double_array prices) {
+                 return vectorized<uint64_t>([&](double p) { return book.volume_to_price(side, p); }, prices);
+             },
+             py::arg("side"), py::arg("price"))
+        .def("price_for_volume", &Book::price_for_volume, py::arg("side"), py::arg("quantity"))
+        .def("price_for_volume",
+             [](Book& book, Side side, uint64_array quantities) {
+                 return vectorized<double>([&](uint64_t q) { return book.price_for_volume(side, q); }, quantities);
+             },
+             py::arg("side"), py::arg("quantity"))
+        .def("depth_within_ticks", &Book::depth_within_ticks, py::arg("side"), py::arg("n"))
+        .def("depth_within_ticks",
+             [](Book& book, Side side, uint64_array ns) {
+                 return vectorized<uint64_t>([&](uint64_t n) { return book.depth_within_ticks(side, n); }, ns);
+             },
+             py::arg("side"), py::arg("n"))
+        .def("queue_ahead", &Book::queue_ahead, py::arg("uid"))
+        .def("queue_ahead",
+             [](Book& book, uint64_array uids) {
+                 return vectorized<uint64_t>([&](uint64_t uid) { return book.queue_ahead(uid); }, uids);
+             },
+             py::arg("uid"))
+        .def("queue_position", &Book::queue_position, py::arg("uid"))
+        .def("queue_position",
+             [](Book& book, uint64_array uids) {
+                 return vectorized<uint64_t>([&](uint64_t uid) { return book.queue_position(uid); }, uids);
+             },
+             py::arg("uid"))
+        .def("stats", [](Book& book) { return to_dict(book.stats()); })
+        .def("reset_stats", &Book::reset_stats)
+        .def("set_compact", &Book::set_compact, py::arg("compact"))
+        .def("is_compact", &Book::is_compact)
+        .def("memory_usage", [](Book& book) { return to_dict(book.memory_usage()); })
+        .def("stream_transactions", &Book::stream_transactions, py::arg("filename"), py::arg("keep") = false)
+        .def("stream_ticks", &Book::stream_ticks, py::arg("filename"), py::arg("keep") = false)
+        .def("close_streams", &Book::close_streams)
+        .def_static("read_transactions",
+                    [](const std::string& filename) {
+                        std::vector<Transaction> transactions;
+                        read_transaction_file(filename, Market::decimal_places, [&](const Transaction& t) { transactions.push_back(t); });
+                        return with_prices<Market>(transactions);
+                    },
+                    py::arg("filename"))
+        .def_static("read_ticks",
+                    [](const std::string& filename) {
+                        std::vector<Tick> ticks;
+                        read_tick_file(filename, Market::decimal_places, [&](const Tick& t) { ticks.push_back(t); });
+                        return ticks;
+                    },
+                    py::arg("filename"))
+        .def("set_checkpoint_interval", &Book::set_checkpoint_interval, py::arg("interval"))
+        .def("book_at", &Book::book_at, py::arg("timestamp"))
+        .def("checkpoint_count", &Book::checkpoint_count)
+        .def("dump_l3", [](const Book& book, uint64_t timestamp) { return to_dict<Market>(book.dump_l3(timestamp)); },
+             py::arg("timestamp") = 0)
+        .def("schedule_l3", &Book::schedule_l3, py::arg("times"), py::arg("filename") = "")
+        .def("get_l3_snapshots", [](const Book& book) { return to_list<Market>(book.get_l3_snapshots()); })
+        .def_static("read_l3", [](const std::string& filename) { return to_list<Market>(read_l3_file(filename, Market::decimal_places)); },
+                    py::arg("filename"))
+        .def("get_transactions", [](const Book& book) { return with_prices<Market>(book.get_transactions()); })
+        .def("get_trade_details", [](const Book& book) { return to_dict(book.get_trade_details()); })
+        .def("get_ticks", &Book::get_ticks)
+        .def("get_bars", [](const Book& book, uint64_t frequency) { return to_dict(book.get_bars(frequency)); },
+             py::arg("frequency"))
+        .def("show", &Book::show, py::arg("n") = 10)
+        .def("show_transactions", &Book::show_transactions, py::arg("n") = 10);
+}
+
+template <typename Market>
+void bind_order_flow_generator(py::module& m, const char* name) {
+    typedef OrderFlowGenerator<Market> Generator;
+    typedef LimitOrderBook<Market, BatchObserver> Book;
+
+    py::class_<Generator>(m, name)
+        .def(py::init<const GeneratorConfig&>(), py::arg("config") = GeneratorConfig())
+        .def("exhausted", &Generator::exhausted)
+        .def("resting", &Generator::resting)
+        .def("generate",
+             [](Generator& generator, size_t n) {
+                 std::vector<Quote> quotes;
+                 generator.generate(n, [&](const Quote& quote) { quotes.push_back(quote); });
+                 return quotes;
+             },
+             py::arg("n"))
+        .def("feed",
+             [](Generator& generator, Book& book, size_t n) {
+                 size_t count = generator.feed(book, n);
+                 book.get_observer().flush();
+                 return count;
+             },
+             py::arg("book"), py::arg("n"))
+        .def("write", &Generator::write, py::arg("filename"), py::arg("n"));
+}
+
+template <typename Market>
+void bind_multi_book_replay(py::module& m, const char* name) {
+    typedef LimitOrderBook<Market, BatchObserver> Book;
+    typedef MultiBookReplay<Book> Replay;
+
+    py::class_<Replay>(m, name)
+        .def(py::init<const std::vector<Book*>&>(), py::arg("books"), py::keep_alive<1, 2>())
+        .def("add", &Replay::add, py::arg("book"), py::keep_alive<1, 2>())
+        .def("__len__", &Replay::size)
+        .def("run",
+             [](Replay& replay, py::object callback) {
+                 // the events of every book are delivered before the callback sees the cross section
+                 auto flush = [&]() {
+                     for (auto book : replay.get_books())
+                         book->get_observer().flush();
+                 };
+                 if (callback.is_none())
+                     replay.run();
+                 else
+                     replay.run([&](TradingStatus status, uint64_t timestamp) {
+                         flush();
+                         callback(status, timestamp);
+                     });
+                 flush();
+             },
+             py::arg("callback") = py::none());
+}
+
+PYBIND11_MODULE(flob, m) {
+    m.doc() = "fast-limit-order-book";
+
+    bind_limit_order_book<AShare>(m, "AShareLimitOrderBook");
+    bind_limit_order_book<HKEX>(m, "HKEXLimitOrderBook");
+    m.attr("LimitOrderBook") = m.attr("AShareLimitOrderBook");
+    m.attr("Transaction") = m.attr("AShareTransaction");
+    bind_multi_book_replay<AShare>(m, "AShareMultiBookReplay");
+    bind_multi_book_replay<HKEX>(m, "HKEXMultiBookReplay");
+    m.attr("MultiBookReplay") = m.attr("AShareMultiBookReplay");
+
+    // the flob-replay executable, e.g. replay(["--data", "data/sample.csv", "--ticks", ""]) or replay(["--generate", "100000"])
+    m.def("replay", &replay_main, py::arg("args"), py::call_guard<py::gil_scoped_release>());
+
+    py::class_<SymbolDemux>(m, "SymbolDemux")
+        .def(py::init<size_t, size_t, size_t>(), py::arg("decimal_places") = AShare::decimal_places, py::arg("threads") = 0,
+             py::arg("chunk_size") = 1 << 24)
+        .def("route", &SymbolDemux::route<LimitOrderBook<AShare, BatchObserver>>, py::arg("symbol"), py::arg("book"), py::keep_alive<1, 3>())
+        .def("route", &SymbolDemux::route<LimitOrderBook<HKEX, BatchObserver>>, py::arg("symbol"), py::arg("book"), py::keep_alive<1, 3>())
+        .def("route_file", &SymbolDemux::route_file, py::arg("symbol"), py::arg("filename"))
+        .def("route_all", &SymbolDemux::route_all, py::arg("pattern"))
+        .def("scan", &SymbolDemux::scan, py::arg("filename"), py::arg("header") = true, py::call_guard<py::gil_scoped_release>())
+        .def("close", &SymbolDemux::close)
+        .def("get_symbols", &SymbolDemux::get_symbols)
+        .def("skipped_count", &SymbolDemux::skipped_count);
+
+    py::class_<GeneratorConfig>(m, "GeneratorConfig")
+        .def(py::init<>())
+        .def_readwrite("seed", &GeneratorConfig::seed)
+        .def_readwrite("date", &GeneratorConfig::date)
+        .def_readwrite("schedule", &GeneratorConfig::schedule)
+        .def_readwrite("base_rate", &GeneratorConfig::base_rate)
+        .def_readwrite("excitation", &GeneratorConfig::excitation)
+        .def_readwrite("decay", &GeneratorConfig::decay)
+        .def_readwrite("price", &GeneratorConfig::price)
+        .def_readwrite("levels", &GeneratorConfig::levels)
+        .def_readwrite("limit_weight", &GeneratorConfig::limit_weight)
+        .def_readwrite("market_weight", &GeneratorConfig::market_weight)
+        .def_readwrite("best_price_weight", &GeneratorConfig::best_price_weight)
+        .def_readwrite("cancel_weight", &GeneratorConfig::cancel_weight)
+        .def_readwrite("resting_orders", &GeneratorConfig::resting_orders)
+        .def_readwrite("lot", &GeneratorConfig::lot)
+        .def_readwrite("min_lots", &GeneratorConfig::min_lots)
+        .def_readwrite("max_lots", &GeneratorConfig::max_lots);
+    bind_order_flow_generator<AShare>(m, "AShareOrderFlowGenerator");
+    bind_order_flow_generator<HKEX>(m, "HKEXOrderFlowGenerator");
+    m.attr("OrderFlowGenerator") = m.attr("AShareOrderFlowGenerator");
 
     py::class_<Quote>(m, "Quote")
         .def(py::init<uint64_t, uint64_t, uint64_t, uint64_t, Side, QuoteType>(),
@@ -56,13 +469,6 @@ PYBIND11_MODULE(flob, m) {
         .def_readonly("side", &Quote::side)
         .def_readonly("type", &Quote::type);
 
-    py::class_<Transaction>(m, "Transaction")
-        .def_readonly("bid_uid", &Transaction::bid_uid)
-        .def_readonly("ask_uid", &Transaction::ask_uid)
-        .def_readonly("price", &Transaction::real_price)
-        .def_readonly("quantity", &Transaction::quantity)
-        .def_readonly("timestamp", &Transaction::timestamp);
-
     py::class_<Tick>(m, "Tick")
         .def_readonly("timestamp", &Tick::timestamp)
         .def_readonly("open", &Tick::open)
@@ -74,7 +480,8 @@ PYBIND11_MODULE(flob, m) {
         .def_readonly("bid_prices", &Tick::bid_prices)
         .def_readonly("ask_prices", &Tick::ask_prices)
         .def_readonly("bid_volumes", &Tick::bid_volumes)
-        .def_readonly("ask_volumes", &Tick::ask_volumes);
+        .def_readonly("ask_volumes", &Tick::ask_volumes)
+        .def_readonly("features", &Tick::features);
 
     py::enum_<QuoteType>(m, "QuoteType")
         .value("LimitOrder", QuoteType::LimitOrder)
@@ -82,12 +489,14 @@ PYBIND11_MODULE(flob, m) {
         .value("BestPriceOrder", QuoteType::BestPriceOrder)
         .value("CancelOrder", QuoteType::CancelOrder)
         .value("FillOrder", QuoteType::FillOrder)
+        .value("ModifyOrder", QuoteType::ModifyOrder)
         .export_values();
 
     py::enum_<TradingStatus>(m, "TradingStatus")
         .value("CallAuction", TradingStatus::CallAuction)
         .value("ContinuousTrading", TradingStatus::ContinuousTrading)
-        .value("Closed", TradingStatus::Closed);
+        .value("Closed", TradingStatus::Closed)
+        .value("Snapshot", TradingStatus::Snapshot);
 
     py::enum_<Side>(m, "Side")
         .value("Bid", Side::Bid)
@@ -0,0 +1,6 @@
+// flob-replay: replays a trading day without a Python interpreter, see replay.hpp for the options.
+#include "replay.hpp"
+
+int main(int argc, char** argv) {
+    return replay_main(std::vector<std::string>(argv + 1, argv + argc));
+}
@@ -0,0 +1,111 @@
+#ifndef __CHECK_HPP__
+#define __CHECK_HPP__
+
+#include <cmath>
+#include <cstdio>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "generator.hpp"
+#include "limit_order_book.hpp"
+
+// Minimal checks for the native tests: every TEST(name) registers a function, run_tests() runs
+// them all and returns the number of failed checks, the exit status of a test executable. Built
+// by setup.py into build/tests and run by tests/test_native.py.
+
+struct TestCase {
+    const char* name;
+    void (*f)();
+};
+
+inline std::vector<TestCase>& test_cases() {
+    static std::vector<TestCase> cases;
+    return cases;
+}
+inline size_t& check_failures() {
+    static size_t failures = 0;
+    return failures;
+}
+inline void check_failed(const char* file, int line, const std::string& message) {
+    std::cerr << file << ":" << line << ": check failed: " << message << std::endl;
+    ++check_failures();
+}
+
+#define TEST(name)                                                                           \
+    static void name();                                                                      \
+    static const bool name##_registered = (test_cases().push_back({#name, name}), true);   \
+    static void name()
+
+#define CHECK(condition)                                       \
+    do {                                                       \
+        if (!(condition))                                      \
+            check_failed(__FILE__, __LINE__, #condition);      \
+    } while (0)
+
+#define CHECK_EQ(a, b)                                                                        \
+    do {                                                                                      \
+        auto check_a = (a);                                                                   \
+        auto check_b = (b);                                                                   \
+        if (!(check_a == check_b)) {                                                          \
+            std::ostringstream check_os;                                                      \
+            check_os << #a " == " #b " (" << check_a << " vs " << check_b << ")";             \
+            check_failed(__FILE__, __LINE__, check_os.str());                                 \
+        }                                                                                     \
+    } while (0)
+
+#define CHECK_NEAR(a, b, eps) CHECK(std::fabs((double)(a) - (double)(b)) <= (eps))
+
+#define CHECK_THROWS(expression, exception)                                  \
+    do {                                                                     \
+        bool check_thrown = false;                                           \
+        try {                                                                \
+            expression;                                                      \
+        } catch (const exception&) {                                         \
+            check_thrown = true;                                             \
+        }                                                                    \
+        if (!check_thrown)                                                   \
+            check_failed(__FILE__, __LINE__, #expression " throws " #exception); \
+    } while (0)
+
+inline int run_tests() {
+    for (auto& test : test_cases()) {
+        size_t before = check_failures();
+        try {
+            test.f();
+        } catch (const std::exception& e) {
+            check_failed(test.name, 0, std::string("unexpected exception: ") + e.what());
+        }
+        std::cout << (check_failures() == before ? "ok     " : "FAILED ") << test.name << std::endl;
+    }
+    return check_failures() == 0 ? 0 : 1;
+}
+
+// helpers shared by the tests
+
+const uint64_t test_day = 1664496000000000000UL;  // midnight of 2022-09-30
+const uint64_t test_hour = 3600000000000UL, test_minute = 60000000000UL;
+
+inline Quote limit_quote(uint64_t uid, uint64_t price, uint64_t quantity, Side side, uint64_t timestamp = test_day + 10 * test_hour) {
+    return Quote(uid, price, quantity, timestamp, side, QuoteType::LimitOrder);
+}
+
+// appends a synthetic day of about `n` events to the book, ready for run()
+template <typename Book>
+void generate_day(Book& book, size_t n, uint64_t seed = 1) {
+    GeneratorConfig config;
+    config.seed = seed;
+    config.base_rate = daily_rate<typename Book::market_type>(n);
+    OrderFlowGenerator<typename Book::market_type> generator(config);
+    generator.generate(n, [&](const Quote& quote) { book.append(quote); });
+}
+
+// silences the progress messages of load()
+struct QuietLoad {
+    std::streambuf* buffer;
+    QuietLoad()
+        : buffer(std::cout.rdbuf(nullptr)) {}
+    ~QuietLoad() { std::cout.rdbuf(buffer); }
+};
+
+#endif  // __CHECK_HPP__
@@ -0,0 +1,69 @@
+#include "check.hpp"
+
+TEST(arena_alignment_and_reset) {
+    MonotonicArena arena(256);
+    char* a = (char*)arena.allocate(3, 1);
+    uint64_t* b = (uint64_t*)arena.allocate(sizeof(uint64_t), alignof(uint64_t));
+    CHECK_EQ((uintptr_t)b % alignof(uint64_t), 0u);
+    CHECK(a != (char*)b);
+    arena.allocate(1000);  // larger than a chunk
+    size_t capacity = arena.capacity();
+    CHECK(capacity >= 1256);
+
+    arena.reset();
+    CHECK_EQ(arena.size(), 0u);
+    CHECK_EQ((char*)arena.allocate(3, 1), a);  // rewinds to the first chunk
+    arena.allocate(sizeof(uint64_t), alignof(uint64_t));
+    arena.allocate(1000);
+    CHECK_EQ(arena.capacity(), capacity);  // the chunks are kept
+}
+
+TEST(object_pool_recycles_slots) {
+    MonotonicArena arena;
+    ObjectPool<uint64_t> pool(arena);
+    uint64_t* a = pool.create(1);
+    uint64_t* b = pool.create(2);
+    CHECK_EQ(pool.size(), 2u);
+    pool.destroy(a);
+    size_t used = arena.size();
+    CHECK_EQ(pool.create(3), a);
+    CHECK_EQ(arena.size(), used);
+    CHECK_EQ(*b, 2u);
+}
+
+// orders placed and cancelled all day long: freed map nodes and queue trees are reused
+TEST(book_memory_is_reused_within_a_day) {
+    LimitOrderBook<AShare> book;
+    uint64_t uid = 1;
+    auto churn = [&](size_t n) {
+        for (size_t i = 0; i < n; ++i, ++uid) {
+            book.write(limit_quote(uid, 1000 - uid % 50, 100, Side::Bid));
+            if (uid > 100)
+                book.write(Quote(uid - 100, 0, 100, test_day + 10 * test_hour, Side::Bid, QuoteType::CancelOrder));
+        }
+    };
+    churn(2000);
+    size_t used = book.memory_usage().arena_used;
+    churn(20000);
+    CHECK(book.memory_usage().arena_used < used * 2);
+}
+
+TEST(clear_keeps_the_arena_for_the_next_day) {
+    LimitOrderBook<AShare> book;
+    auto day = [&] {
+        for (uint64_t uid = 1; uid <= 5000; ++uid)
+            book.write(limit_quote(uid, uid % 2 ? 1000 + uid % 40 : 990 - uid % 40, 100, uid % 2 ? Side::Ask : Side::Bid));
+    };
+    day();
+    auto first = book.memory_usage();
+    book.clear();
+    CHECK_EQ(book.memory_usage().orders, 0u);
+    day();
+    auto second = book.memory_usage();
+    CHECK_EQ(second.arena_reserved, first.arena_reserved);
+    CHECK_EQ(second.arena_used, first.arena_used);
+    CHECK_NEAR(book.get_kth_bid_price(1), 9.90, 1e-9);
+    CHECK_EQ(book.get_kth_bid_volume(1), 125u * 100);
+}
+
+int main() { return run_tests(); }
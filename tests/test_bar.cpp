@@ -0,0 +1,66 @@
+#include "check.hpp"
+
+// opening auction 09:15 - 09:25, continuous trading 09:30 - 09:45
+const std::vector<TradingHour> bar_schedule = {
+    {TradingStatus::CallAuction, 9 * test_hour + 15 * test_minute, 9 * test_hour + 25 * test_minute},
+    {TradingStatus::ContinuousTrading, 9 * test_hour + 30 * test_minute, 9 * test_hour + 45 * test_minute},
+};
+
+TEST(bars_follow_the_schedule) {
+    BarAggregator bars(0.01);
+    bars.set_frequencies({10 * test_minute, 5 * test_minute}, true, true);
+    bars.reset(bar_schedule, test_day);
+    auto at = [](uint64_t minute) { return test_day + 9 * test_hour + minute * test_minute; };
+    bars.track(at(25), 1000, 500);  // the auction match, at the end of its bar
+    bars.track(at(31), 1002, 100);
+    bars.track(at(35), 998, 300);
+    bars.track(at(44), 1001, 200);
+    bars.flush(at(45));
+
+    const Bars& ten = bars.get(10 * test_minute);
+    CHECK_EQ(ten.size(), 3u);  // the auction, 09:30 - 09:40 and 09:40 - 09:45 clipped
+    CHECK(ten.timestamp == std::vector<uint64_t>({at(25), at(40), at(45)}));
+    CHECK_NEAR(ten.open[0], 10.00, 1e-9);
+    CHECK_EQ(ten.volume[0], 500u);
+    CHECK_NEAR(ten.open[1], 10.02, 1e-9);
+    CHECK_NEAR(ten.high[1], 10.02, 1e-9);
+    CHECK_NEAR(ten.low[1], 9.98, 1e-9);
+    CHECK_NEAR(ten.close[1], 9.98, 1e-9);
+    CHECK_EQ(ten.volume[1], 400u);
+    CHECK_NEAR(ten.amount[1], 10.02 * 100 + 9.98 * 300, 1e-6);
+    CHECK_NEAR(ten.vwap[1], (10.02 * 100 + 9.98 * 300) / 400, 1e-9);
+    CHECK_EQ(ten.count[1], 2u);
+    CHECK_EQ(ten.count[2], 1u);
+
+    const Bars& five = bars.get(5 * test_minute);
+    CHECK_EQ(five.size(), 4u);
+    CHECK_EQ(five.volume[1], 400u);  // 09:35 belongs to (09:30, 09:35]
+    CHECK(std::isnan(five.open[2]));  // nothing traded in (09:35, 09:40]
+    CHECK_EQ(five.volume[2], 0u);
+    CHECK_EQ(five.volume[3], 200u);
+    CHECK_THROWS(bars.get(test_minute), std::invalid_argument);
+    CHECK_THROWS(bars.set_frequencies({0}), std::invalid_argument);
+}
+
+TEST(bars_of_a_replayed_day) {
+    LimitOrderBook<AShare> book;
+    book.set_bar_frequencies({test_minute, 5 * test_minute});
+    generate_day(book, 20000);
+    book.run();
+    uint64_t volume = 0;
+    for (auto& transaction : book.get_transactions())
+        volume += transaction.quantity;
+    CHECK(volume > 0);
+    for (uint64_t frequency : {test_minute, 5 * test_minute}) {
+        const Bars& bars = book.get_bars(frequency);
+        uint64_t total = 0;
+        for (auto v : bars.volume)
+            total += v;
+        CHECK_EQ(total, volume);
+    }
+    // two auctions, 120 minutes in the morning and 117 in the afternoon
+    CHECK_EQ(book.get_bars(test_minute).size(), 239u);
+    CHECK_EQ(book.get_bars(5 * test_minute).size(), 50u);
+}
+
+int main() { return run_tests(); }
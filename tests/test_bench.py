@@ -0,0 +1,43 @@
+import os
+import subprocess
+
+from test_native import ROOT
+
+
+def bench(name, *args):
+    # built by `python setup.py build_ext --inplace` into build/bench
+    executable = os.path.join(ROOT, "build", "bench", "flob_bench_" + name)
+    assert os.path.exists(executable), executable + " is not built"
+    return subprocess.run([executable, *args], cwd=ROOT, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+
+
+def test_micro():
+    result = bench("micro", "10")
+    assert result.returncode == 0, result.stdout
+    rows = {}
+    for line in result.stdout.splitlines():
+        cells = [cell.strip() for cell in line.strip("│").split("│")]
+        if len(cells) == 7 and cells[1] == "10":
+            rows[cells[0]] = [float(cell) for cell in cells[2:]]
+    names = ["treap_insert_remove", "treap_kth", "list_push_pop", "limit_existing_level", "limit_new_level", "cancel",
+             "match_sweep_10", "match_call_auction", "snapshot_top10", "load"]
+    assert sorted(rows) == sorted(names)
+    # the hot paths run on the arena and the object pools
+    for name in ["treap_insert_remove", "list_push_pop", "limit_existing_level", "cancel", "match_call_auction"]:
+        assert rows[name][4] == 0, name
+
+
+def test_replay_golden(tmp_path):
+    result = bench("replay")
+    assert result.returncode == 0, result.stdout
+    assert "transactions: identical" in result.stdout
+    assert "ticks: identical" in result.stdout
+
+    # a changed golden file fails the run
+    with open(os.path.join(ROOT, "benchmark", "golden", "transactions.csv")) as file:
+        lines = file.readlines()
+    lines[len(lines) // 2] = lines[len(lines) // 2].replace(",", ",9", 1)
+    golden = tmp_path / "transactions.csv"
+    golden.write_text("".join(lines))
+    result = bench("replay", "--transactions", str(golden), "--ticks", "")
+    assert result.returncode == 1, result.stdout
@@ -0,0 +1,136 @@
+#include "check.hpp"
+
+static bool same_depth(const L3Snapshot& a, const L3Snapshot& b) {
+    return a.level_price == b.level_price && a.level_quantity == b.level_quantity && a.level_side == b.level_side &&
+           a.order_uid == b.order_uid && a.order_quantity == b.order_quantity;
+}
+
+// the book restored from a checkpoint equals a replay of the quotes up to the same time
+TEST(book_at_matches_a_replay) {
+    GeneratorConfig config;
+    config.seed = 7;
+    config.base_rate = daily_rate<AShare>(30000);
+    std::vector<Quote> quotes;
+    OrderFlowGenerator<AShare>(config).generate(1000000, [&](const Quote& quote) { quotes.push_back(quote); });
+
+    LimitOrderBook<AShare> book(test_minute);
+    book.set_checkpoint_interval(10 * test_minute);
+    for (auto& quote : quotes)
+        book.append(quote);
+    book.run();
+    CHECK(book.checkpoint_count() > 20);
+
+    for (uint64_t time : {9 * test_hour + 31 * test_minute, 10 * test_hour, 10 * test_hour + 17 * test_minute + 33123456789UL,
+                          11 * test_hour + 29 * test_minute, 13 * test_hour, 14 * test_hour + 56 * test_minute + 59999999999UL}) {
+        // the quotes up to `time`, the periods after it do not change an uncrossed book
+        LimitOrderBook<AShare> replay(test_minute);
+        for (auto& quote : quotes)
+            if (quote.timestamp <= test_day + time)
+                replay.append(quote);
+        replay.run();
+        auto restored = book.book_at(time);
+        CHECK(same_depth(restored->dump_l3(), replay.dump_l3()));
+        CHECK(same_depth(book.book_at(test_day + time)->dump_l3(), replay.dump_l3()));  // absolute time
+    }
+}
+
+// the end of the opening auction is part of the book at its time
+TEST(book_at_the_call_auction) {
+    LimitOrderBook<AShare> book;
+    book.set_checkpoint_interval(test_minute);
+    book.append(limit_quote(1, 1000, 300, Side::Bid, test_day + 9 * test_hour + 20 * test_minute));
+    book.append(limit_quote(2, 999, 200, Side::Ask, test_day + 9 * test_hour + 21 * test_minute));
+    book.append(limit_quote(3, 990, 100, Side::Bid, test_day + 10 * test_hour));
+    book.run();
+    auto before = book.book_at(9 * test_hour + 24 * test_minute);
+    CHECK_EQ(before->get_kth_ask_volume(1), 200u);  // crossed, not matched yet
+    CHECK(before->get_transactions().empty());
+    auto after = book.book_at(9 * test_hour + 25 * test_minute);
+    CHECK_EQ(after->get_kth_ask_volume(1), 0u);
+    CHECK_EQ(after->get_kth_bid_volume(1), 100u);
+    CHECK_EQ(after->get_transactions().size(), 1u);
+    CHECK_EQ(book.book_at(11 * test_hour)->get_kth_bid_volume(2), 100u);
+}
+
+// a market order taken by a strategy order and cancelled by the market later on
+TEST(book_at_after_a_strategy_fill) {
+    LimitOrderBook<AShare> book;
+    book.set_checkpoint_interval(test_minute);
+    book.append(limit_quote(1, 1000, 500, Side::Ask, test_day + 10 * test_hour));
+    book.append(Quote(1, 0, 500, test_day + 10 * test_hour + 5 * test_minute, Side::Ask, QuoteType::CancelOrder));
+    book.append(limit_quote(2, 990, 100, Side::Bid, test_day + 10 * test_hour + 10 * test_minute));
+    uint64_t uid = book.submit(Side::Bid, 1000, 500, test_day + 10 * test_hour + test_minute);
+    book.run();
+    CHECK_EQ(book.get_fills().size(), 1u);
+    auto restored = book.book_at(10 * test_hour + 6 * test_minute);
+    CHECK_EQ(restored->get_kth_ask_volume(1), 0u);
+    CHECK_EQ(restored->get_kth_bid_volume(1), 0u);
+    restored = book.book_at(10 * test_hour + 3 * test_minute);  // the fill is in the checkpoint
+    CHECK_EQ(restored->get_kth_ask_volume(1), 0u);
+    CHECK_EQ(restored->dump_l3().orders(), 0u);
+    CHECK(restored->submit(Side::Bid, 990, 100, test_day + 11 * test_hour) != uid);
+}
+
+// strategy orders submitted through a generated day, the books restored from checkpoints equal
+// replays of the market quotes and of the strategy orders that arrived up to the same time
+TEST(book_at_with_strategy_orders) {
+    GeneratorConfig config;
+    config.seed = 11;
+    config.base_rate = daily_rate<AShare>(30000);
+    std::vector<Quote> quotes;
+    OrderFlowGenerator<AShare>(config).generate(1000000, [&](const Quote& quote) { quotes.push_back(quote); });
+    const uint64_t latency = 1000000;  // 1ms
+
+    // marketable orders at the best prices of the market data, every 13 minutes
+    struct Submit {
+        Side side;
+        uint64_t price, timestamp;
+    };
+    std::vector<Submit> submits;
+    LimitOrderBook<AShare> market;
+    for (auto& quote : quotes)
+        market.append(quote);
+    for (uint64_t time = 9 * test_hour + 31 * test_minute; time < 14 * test_hour + 50 * test_minute; time += 13 * test_minute) {
+        if (time > 11 * test_hour + 30 * test_minute && time < 13 * test_hour)
+            continue;
+        market.until(time);
+        Side side = submits.size() % 2 ? Side::Ask : Side::Bid;
+        double price = side == Side::Bid ? market.get_kth_ask_price(1) : market.get_kth_bid_price(1);
+        submits.push_back({side, (uint64_t)std::llround(price * 100), test_day + time});
+    }
+    auto submit_all = [&](LimitOrderBook<AShare>& book, uint64_t until) {
+        book.set_latency(latency);
+        for (auto& submit : submits)
+            if (submit.timestamp + latency <= until)
+                book.submit(submit.side, submit.price, 500, submit.timestamp);
+    };
+
+    LimitOrderBook<AShare> book(test_minute);
+    book.set_checkpoint_interval(10 * test_minute);
+    for (auto& quote : quotes)
+        book.append(quote);
+    submit_all(book, std::numeric_limits<uint64_t>::max());
+    book.run();
+    CHECK(book.get_fills().size() > 5);
+
+    for (uint64_t time : {9 * test_hour + 50 * test_minute, 10 * test_hour + 47 * test_minute, 11 * test_hour + 29 * test_minute,
+                          13 * test_hour + 40 * test_minute + 123456789, 14 * test_hour + 56 * test_minute}) {
+        LimitOrderBook<AShare> replay(test_minute);
+        for (auto& quote : quotes)
+            if (quote.timestamp <= test_day + time)
+                replay.append(quote);
+        submit_all(replay, test_day + time);
+        replay.run();
+        CHECK(same_depth(book.book_at(time)->dump_l3(), replay.dump_l3()));
+    }
+}
+
+TEST(book_at_needs_checkpoints) {
+    LimitOrderBook<AShare> book;
+    generate_day(book, 1000);
+    book.run();
+    CHECK_EQ(book.checkpoint_count(), 0u);
+    CHECK_THROWS(book.book_at(10 * test_hour), std::runtime_error);
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,110 @@
+#include <sys/resource.h>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include "check.hpp"
+#include "demux.hpp"
+
+static std::vector<Quote> day_of(uint64_t seed, size_t n) {
+    GeneratorConfig config;
+    config.seed = seed;
+    config.base_rate = daily_rate<AShare>(n);
+    std::vector<Quote> quotes;
+    OrderFlowGenerator<AShare>(config).generate(1000000, [&](const Quote& quote) { quotes.push_back(quote); });
+    return quotes;
+}
+
+// the quotes of the symbols interleaved by time, as an exchange file
+static void write_exchange_file(const std::string& filename, const std::vector<std::pair<std::string, std::vector<Quote>>>& symbols) {
+    std::ofstream file(filename);
+    file << "symbol,timestamp,uid,price,quantity,side,type\n" << std::fixed << std::setprecision(2);
+    std::vector<size_t> next(symbols.size());
+    while (true) {
+        size_t best = symbols.size();
+        for (size_t i = 0; i < symbols.size(); ++i)
+            if (next[i] < symbols[i].second.size() && (best == symbols.size() || symbols[i].second[next[i]].timestamp < symbols[best].second[next[best]].timestamp))
+                best = i;
+        if (best == symbols.size())
+            return;
+        const Quote& q = symbols[best].second[next[best]++];
+        file << symbols[best].first << "," << q.timestamp << "," << q.uid << "," << q.price / 100.0 << "," << q.quantity << "," << (int)q.side << "," << (int)q.type << "\n";
+    }
+}
+
+static bool same_transactions(const std::vector<Transaction>& a, const std::vector<Transaction>& b) {
+    bool same = a.size() == b.size();
+    for (size_t i = 0; same && i < a.size(); ++i)
+        same = a[i].bid_uid == b[i].bid_uid && a[i].ask_uid == b[i].ask_uid && a[i].price == b[i].price && a[i].quantity == b[i].quantity;
+    return same;
+}
+
+TEST(demux_routes_every_symbol_in_order) {
+    auto a = day_of(1, 5000), b = day_of(2, 5000), c = day_of(3, 1000);
+    write_exchange_file("test_demux.csv", {{"600000", a}, {"000001", b}, {"300750", c}});
+
+    LimitOrderBook<AShare> book;
+    SymbolDemux demux(2, 3, 4096);  // small chunks, lines cut at every chunk boundary
+    demux.route("600000", book);
+    demux.route_file("000001", "test_demux_000001.csv");
+    CHECK_EQ(demux.scan("test_demux.csv"), a.size() + b.size());
+    demux.close();
+    CHECK_EQ(demux.skipped_count(), c.size());
+    CHECK(demux.get_symbols() == std::vector<std::string>({"000001", "600000"}));
+
+    LimitOrderBook<AShare> expected_a, from_file, expected_b;
+    for (auto& quote : a)
+        expected_a.append(quote);
+    for (auto& quote : b)
+        expected_b.append(quote);
+    {
+        QuietLoad quiet;
+        CHECK_EQ(from_file.load("test_demux_000001.csv"), b.size());
+    }
+    for (auto* day : {&book, &expected_a, &from_file, &expected_b})
+        day->run();
+    CHECK(same_transactions(book.get_transactions(), expected_a.get_transactions()));
+    CHECK(same_transactions(from_file.get_transactions(), expected_b.get_transactions()));
+    std::remove("test_demux.csv");
+    std::remove("test_demux_000001.csv");
+}
+
+// more symbols than file descriptors
+TEST(demux_splits_into_many_files) {
+    std::vector<std::pair<std::string, std::vector<Quote>>> symbols;
+    for (size_t i = 0; i < 200; ++i)
+        symbols.emplace_back("S" + std::to_string(i), std::vector<Quote>{limit_quote(i + 1, 1000 + i, 100, Side::Bid, test_day + 10 * test_hour + i)});
+    write_exchange_file("test_demux.csv", symbols);
+    rlimit limit, low;
+    getrlimit(RLIMIT_NOFILE, &limit);
+    low = limit;
+    low.rlim_cur = std::min<rlim_t>(limit.rlim_cur, 32);
+    setrlimit(RLIMIT_NOFILE, &low);
+    size_t routed = 0;
+    {
+        SymbolDemux demux(2, 2);
+        demux.route_all("test_demux_{symbol}.bin");
+        routed = demux.scan("test_demux.csv");
+    }
+    setrlimit(RLIMIT_NOFILE, &limit);
+    CHECK_EQ(routed, 200u);
+    for (size_t i = 0; i < 200; ++i) {
+        std::string filename = "test_demux_S" + std::to_string(i) + ".bin";
+        std::vector<Quote> quotes;
+        read_binary_quotes(filename, 2, [&](const Quote& quote) { quotes.push_back(quote); });
+        CHECK(quotes.size() == 1 && quotes[0].price == 1000 + i);
+        std::remove(filename.c_str());
+    }
+    std::remove("test_demux.csv");
+}
+
+TEST(demux_rejects_other_scales_and_bad_records) {
+    SymbolDemux demux(2, 1);
+    LimitOrderBook<HKEX> hkex;
+    CHECK_THROWS(demux.route("00700", hkex), std::invalid_argument);
+    CHECK_THROWS(demux.route_all("quotes.csv"), std::invalid_argument);
+    std::ofstream("test_demux.csv") << "symbol,timestamp,uid,price,quantity,side,type\nA,1,2,10.00,100,0\n";
+    CHECK_THROWS(demux.scan("test_demux.csv"), std::runtime_error);
+    std::remove("test_demux.csv");
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,71 @@
+#include <random>
+#include "check.hpp"
+
+// the levels of one side from the best price outwards, walked level by level
+template <typename Book>
+static std::vector<std::pair<double, uint64_t>> levels(Book& book, Side side) {
+    size_t n = 1 << 20;
+    auto prices = side == Side::Bid ? book.get_topk_bid_price(n) : book.get_topk_ask_price(n);
+    auto volumes = side == Side::Bid ? book.get_topk_bid_volume(n) : book.get_topk_ask_volume(n);
+    std::vector<std::pair<double, uint64_t>> result;
+    for (size_t i = 0; i < prices.size(); ++i)
+        result.emplace_back(prices[i], volumes[i]);
+    return result;
+}
+
+// the aggregates agree with a walk over the levels after a stream of inserts, trades and cancels
+TEST(depth_queries_match_the_levels) {
+    LimitOrderBook<AShare> book;
+    GeneratorConfig config;
+    config.seed = 3;
+    OrderFlowGenerator<AShare> generator(config);
+    std::mt19937_64 rng(5);
+    for (size_t round = 0; round < 20; ++round) {
+        generator.feed(book, 1000);
+        for (Side side : {Side::Bid, Side::Ask}) {
+            auto walk = levels(book, side);
+            CHECK(!walk.empty());
+            double best = walk.front().first, worst = walk.back().first;
+            for (size_t i = 0; i < 20; ++i) {
+                double lo = std::round((worst - 0.05 + (best - worst + 0.1) * (rng() % 1000) / 1000.0) * 100) / 100;
+                double hi = lo + (rng() % 20) / 100.0;
+                uint64_t between = 0, to_price = 0;
+                for (auto& [price, volume] : walk) {
+                    between += price >= lo - 1e-9 && price <= hi + 1e-9 ? volume : 0;
+                    to_price += (side == Side::Bid ? price >= lo - 1e-9 : price <= lo + 1e-9) ? volume : 0;
+                }
+                CHECK_EQ(book.depth_between(side, lo, hi), between);
+                CHECK_EQ(book.volume_to_price(side, lo), to_price);
+            }
+            uint64_t cumulative = 0;
+            for (auto& [price, volume] : walk) {
+                CHECK_NEAR(book.price_for_volume(side, cumulative + 1), price, 1e-9);
+                cumulative += volume;
+                CHECK_NEAR(book.price_for_volume(side, cumulative), price, 1e-9);
+            }
+            CHECK(std::isnan(book.price_for_volume(side, cumulative + 1)));
+            CHECK_EQ(book.depth_within_ticks(side, 1 << 20), cumulative);
+        }
+    }
+}
+
+// tick counts follow the spread table across a change of tick size
+TEST(depth_within_ticks_on_the_spread_table) {
+    LimitOrderBook<HKEX> book;
+    uint64_t uid = 0;
+    for (uint64_t price : {10040, 10020, 10000, 9990, 9980})
+        book.write(limit_quote(++uid, price, 100, Side::Bid));
+    for (uint64_t price : {10060, 10080, 10120})
+        book.write(limit_quote(++uid, price, 100, Side::Ask));
+    CHECK_EQ(book.depth_within_ticks(Side::Bid, 0), 100u);
+    CHECK_EQ(book.depth_within_ticks(Side::Bid, 2), 300u);  // 10.04, 10.02, 10.00
+    CHECK_EQ(book.depth_within_ticks(Side::Bid, 3), 400u);  // then 0.01 ticks below 10.00
+    CHECK_EQ(book.depth_within_ticks(Side::Ask, 1), 200u);
+    CHECK_EQ(book.depth_within_ticks(Side::Ask, 2), 200u);  // nothing rests at 10.10
+    CHECK_EQ(book.depth_within_ticks(Side::Ask, 3), 300u);
+    CHECK_EQ(book.depth_between(Side::Bid, 10.00, 9.99), 0u);
+    LimitOrderBook<HKEX> empty;
+    CHECK_EQ(empty.depth_within_ticks(Side::Ask, 5), 0u);
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,59 @@
+#include "check.hpp"
+
+TEST(features_of_a_snapshot) {
+    LimitOrderBook<AShare> book;
+    book.set_features({"spread", "mid_price", "imbalance", "depth_imbalance", "micro_price", "weighted_mid_price", "trade_flow_imbalance"});
+    CHECK_EQ(book.get_feature_names().size(), 7u);
+    book.write(limit_quote(1, 1000, 300, Side::Bid));
+    book.write(limit_quote(2, 999, 100, Side::Bid));
+    book.write(limit_quote(3, 1002, 100, Side::Ask));
+    book.write(limit_quote(4, 1003, 300, Side::Ask));
+    book.write(limit_quote(5, 1002, 40, Side::Bid));   // buys 40
+    book.write(limit_quote(6, 1000, 100, Side::Ask));  // sells 100
+    book.snapshot(test_day + 10 * test_hour + test_minute);
+
+    // bids 10.00 x 200, 9.99 x 100; asks 10.02 x 60, 10.03 x 300
+    auto ticks = book.get_ticks();
+    const Tick& tick = ticks.back();
+    CHECK_EQ(tick.features.size(), 7u);
+    CHECK_NEAR(tick.features[0], 0.02, 1e-9);
+    CHECK_NEAR(tick.features[1], 10.01, 1e-9);
+    CHECK_NEAR(tick.features[2], (200.0 - 60) / 260, 1e-9);
+    CHECK_NEAR(tick.features[3], (300.0 - 360) / 660, 1e-9);
+    CHECK_NEAR(tick.features[4], (10.00 * 60 + 10.02 * 200) / 260, 1e-9);
+    CHECK_NEAR(tick.features[5], ((10.00 * 200 + 9.99 * 100) / 300 + (10.02 * 60 + 10.03 * 300) / 360) / 2, 1e-9);
+    CHECK_NEAR(tick.features[6], (40.0 - 100) / 140, 1e-9);
+
+    // the trade flow starts over with every tick
+    book.snapshot(test_day + 10 * test_hour + 2 * test_minute);
+    CHECK(std::isnan(book.get_ticks().back().features[6]));
+}
+
+TEST(features_follow_the_configured_order) {
+    LimitOrderBook<AShare> book;
+    book.set_features({"mid_price", "spread"});
+    book.write(limit_quote(1, 1000, 100, Side::Bid));
+    book.snapshot(test_day + 10 * test_hour + test_minute);
+    auto features = book.get_ticks().back().features;
+    CHECK(std::isnan(features[0]) && std::isnan(features[1]));  // no ask yet
+    book.write(limit_quote(2, 1004, 100, Side::Ask));
+    book.snapshot(test_day + 10 * test_hour + 2 * test_minute);
+    features = book.get_ticks().back().features;
+    CHECK_NEAR(features[0], 10.02, 1e-9);
+    CHECK_NEAR(features[1], 0.04, 1e-9);
+    CHECK_THROWS(book.set_features({"spread", "vpin"}), std::invalid_argument);
+    CHECK_EQ(book.get_feature_names().size(), 2u);  // unchanged by the failed call
+}
+
+// auction trades have no aggressor and stay out of the trade flow
+TEST(trade_flow_skips_the_call_auction) {
+    FeatureSet features;
+    features.set({"trade_flow_imbalance"});
+    Transaction transaction(1, 2, 1000, 100, test_day);
+    features.track(transaction, TradeDetails::no_aggressor);
+    CHECK(std::isnan(features.snapshot({}, {}, {}, {})[0]));
+    features.track(transaction, Side::Ask);
+    CHECK_NEAR(features.snapshot({}, {}, {}, {})[0], -1, 1e-9);
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,161 @@
+import numpy as np
+
+import flob
+from flob import QuoteType, Side
+
+DAY = 1664496000000000000  # midnight of 2022-09-30
+HOUR = 3600_000_000_000
+
+
+def limit(uid, price, quantity, side, timestamp=DAY + 10 * HOUR):
+    return flob.Quote(uid, price, quantity, timestamp, side, QuoteType.LimitOrder)
+
+
+def test_markets():
+    assert flob.LimitOrderBook is flob.AShareLimitOrderBook
+    assert flob.AShareLimitOrderBook().decimal_places == 2
+    assert flob.HKEXLimitOrderBook().decimal_places == 3
+
+
+def test_continuous_match():
+    lob = flob.LimitOrderBook()
+    lob.write(limit(1, 1000, 300, Side.Ask))
+    lob.write(limit(2, 1001, 200, Side.Bid))
+    (transaction,) = lob.get_transactions()
+    assert (transaction.bid_uid, transaction.ask_uid, transaction.quantity) == (2, 1, 200)
+    assert abs(transaction.price - 10.0) < 1e-9
+    assert lob.get_kth_ask_volume(1) == 100
+
+
+def test_hkex_rejects_market_orders():
+    lob = flob.HKEXLimitOrderBook()
+    try:
+        lob.write(flob.Quote(1, 0, 100, DAY + 10 * HOUR, Side.Bid, QuoteType.MarketOrder))
+    except ValueError:
+        return
+    raise AssertionError("a market order was accepted")
+
+
+def test_modify_order():
+    lob = flob.LimitOrderBook()
+    lob.write(limit(1, 1000, 100, Side.Bid))
+    lob.write(limit(2, 1000, 100, Side.Bid))
+    lob.write(flob.Quote(1, 0, 50, DAY + 10 * HOUR, Side.Bid, QuoteType.ModifyOrder))
+    lob.write(limit(3, 1000, 60, Side.Ask))
+    assert [(t.bid_uid, t.quantity) for t in lob.get_transactions()] == [(1, 50), (2, 10)]
+
+
+def test_depth_queries():
+    lob = flob.LimitOrderBook()
+    for uid, price in enumerate([1000, 999, 997], 1):
+        lob.write(limit(uid, price, 100 * uid, Side.Bid))
+    assert lob.depth_between(Side.Bid, 9.97, 9.99) == 500
+    assert lob.volume_to_price(Side.Bid, 9.99) == 300
+    assert abs(lob.price_for_volume(Side.Bid, 301) - 9.97) < 1e-9
+    assert list(lob.depth_within_ticks(Side.Bid, np.arange(4))) == [100, 300, 300, 600]
+
+
+def test_queue_position():
+    lob = flob.LimitOrderBook()
+    for uid in range(1, 4):
+        lob.write(limit(uid, 1000, 100 * uid, Side.Bid))
+    assert lob.queue_position(3) == 2
+    assert lob.queue_ahead(3) == 300
+    assert list(lob.queue_ahead(np.array([1, 2, 3]))) == [0, 100, 300]
+
+
+def test_callback_batches():
+    lob = flob.LimitOrderBook()
+    batches = []
+    lob.set_callback(batches.append, batch_size=2)
+    lob.write(limit(1, 1000, 100, Side.Bid))
+    lob.write(limit(2, 1000, 100, Side.Ask))
+    lob.flush_events()
+    trades = [q for batch in batches for q in batch["trade"]["quantity"]]
+    assert trades == [100]
+    assert sum(len(batch["level"]["price"]) for batch in batches) == 4
+
+
+def test_strategy_fill(tmp_path):
+    path = tmp_path / "quotes.csv"
+    path.write_text(
+        "timestamp,uid,price,quantity,side,type\n"
+        f"{DAY + 10 * HOUR},1,10.00,500,1,0\n"
+        f"{DAY + 10 * HOUR + 1_000_000},2,10.00,300,0,0\n"
+    )
+    lob = flob.LimitOrderBook()
+    lob.load(str(path))
+    lob.set_latency(500_000)
+    uid = lob.submit(Side.Bid, 1000, 200, DAY + 10 * HOUR)
+    lob.until(11 * HOUR)
+    (fill,) = lob.get_fills()
+    assert (fill.bid_uid, fill.quantity) == (uid, 200)
+    assert [t.quantity for t in lob.get_transactions()] == [300]
+
+
+def test_generator_feed():
+    config = flob.GeneratorConfig()
+    config.seed = 1
+    config.base_rate = 2.0
+    generator = flob.AShareOrderFlowGenerator(config)
+    lob = flob.LimitOrderBook()
+    assert generator.feed(lob, 10000) == 10000
+    assert len(generator.generate(5)) == 5
+
+
+def test_stats():
+    lob = flob.LimitOrderBook()
+    lob.write(limit(1, 1000, 100, Side.Bid))
+    stats = lob.stats()
+    assert stats["counters"]["resting_orders"] == 1
+    assert stats["counters"]["bid_levels"] == 1
+    assert set(stats["phases"]) == {"call_auction", "continuous_trading", "closed", "snapshot"}
+
+
+def test_memory_usage():
+    lob = flob.LimitOrderBook()
+    lob.set_compact(True)
+    assert lob.is_compact()
+    lob.write(limit(1, 1000, 100, Side.Bid))
+    usage = lob.memory_usage()
+    assert usage["total"] >= usage["arena_reserved"] > 0
+    assert usage["l3"] == 0
+
+
+def test_replay(tmp_path):
+    transactions = tmp_path / "transactions.csv"
+    args = ["--generate", "2000", "--seed", "1", "--transactions", str(transactions), "--ticks", ""]
+    assert flob.replay(args) == 0
+    assert transactions.read_text().startswith("timestamp,")
+    assert flob.replay(["--data", str(tmp_path / "missing.csv")]) == 2
+
+
+def test_trade_details():
+    lob = flob.LimitOrderBook()
+    lob.write(limit(1, 1000, 100, Side.Ask))
+    lob.write(limit(2, 1001, 100, Side.Ask))
+    lob.write(limit(3, 1001, 200, Side.Bid))
+    details = lob.get_trade_details()
+    assert list(details["aggressor"]) == [int(Side.Bid)] * 2
+    assert list(details["sweep"]) == [0, 1]
+    assert list(details["depleted"]) == [True, True]
+
+
+def test_l3_dumps(tmp_path):
+    lob = flob.LimitOrderBook()
+    lob.write(limit(1, 1000, 100, Side.Bid))
+    lob.write(limit(2, 1000, 200, Side.Bid))
+    lob.write(limit(3, 1010, 300, Side.Ask))
+    snapshot = lob.dump_l3()
+    assert np.allclose(snapshot["level_price"], [10.0, 10.1])
+    assert list(snapshot["level_orders"]) == [2, 1]
+    assert list(snapshot["order_uid"]) == [1, 2, 3]
+
+    filename = str(tmp_path / "l3.bin")
+    lob = flob.LimitOrderBook()
+    lob.schedule_l3([10 * HOUR], filename)
+    lob.append(limit(1, 1000, 100, Side.Bid))
+    lob.run()
+    (snapshot,) = flob.LimitOrderBook.read_l3(filename)
+    assert snapshot["timestamp"] == DAY + 10 * HOUR
+    assert list(snapshot["order_quantity"]) == [100]
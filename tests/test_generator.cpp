@@ -0,0 +1,87 @@
+#include <cstdio>
+#include "check.hpp"
+
+static std::vector<Quote> generate(GeneratorConfig config, size_t n) {
+    OrderFlowGenerator<AShare> generator(config);
+    std::vector<Quote> quotes;
+    generator.generate(n, [&](const Quote& quote) { quotes.push_back(quote); });
+    return quotes;
+}
+
+static bool same(const std::vector<Quote>& a, const std::vector<Quote>& b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); ++i)
+        if (a[i].uid != b[i].uid || a[i].price != b[i].price || a[i].quantity != b[i].quantity || a[i].timestamp != b[i].timestamp || a[i].side != b[i].side || a[i].type != b[i].type)
+            return false;
+    return true;
+}
+
+TEST(generator_is_deterministic) {
+    GeneratorConfig config;
+    config.seed = 42;
+    auto a = generate(config, 5000), b = generate(config, 5000);
+    CHECK_EQ(a.size(), 5000u);
+    CHECK(same(a, b));
+    config.seed = 43;
+    CHECK(!same(a, generate(config, 5000)));
+}
+
+TEST(generator_fills_the_trading_day) {
+    GeneratorConfig config;
+    config.base_rate = daily_rate<AShare>(20000);
+    auto quotes = generate(config, 1000000);
+    CHECK(quotes.size() > 19000 && quotes.size() < 21000);  // Poisson around 20000
+    bool in_session = true, ordered = true;
+    for (size_t i = 0; i < quotes.size(); ++i) {
+        uint64_t time = quotes[i].timestamp - config.date;
+        in_session &= (time >= 9 * test_hour + 30 * test_minute && time < 11 * test_hour + 30 * test_minute) || (time >= 13 * test_hour && time < 14 * test_hour + 57 * test_minute);
+        ordered &= i == 0 || quotes[i - 1].timestamp <= quotes[i].timestamp;
+    }
+    CHECK(in_session);
+    CHECK(ordered);
+    CHECK_THROWS(OrderFlowGenerator<AShare>(GeneratorConfig{0, test_day, "", 0}), std::invalid_argument);
+}
+
+// every cancel refers to an order the book still holds, the book throws otherwise
+template <typename Market>
+static void feed_a_book(double excitation) {
+    GeneratorConfig config;
+    config.base_rate = daily_rate<Market>(50000);
+    config.excitation = excitation;
+    config.decay = 2;
+    OrderFlowGenerator<Market> generator(config);
+    LimitOrderBook<Market> book;
+    size_t events = 0;
+    while (!generator.exhausted())
+        events += generator.feed(book, 5000);
+    CHECK(events > 45000);
+    CHECK(generator.resting() > 0 && generator.resting() < 2 * config.resting_orders);
+    CHECK(!book.get_transactions().empty());
+}
+
+TEST(generated_flow_replays_on_both_markets) {
+    feed_a_book<AShare>(0);
+    feed_a_book<HKEX>(1);  // limit orders only where market orders are not allowed
+}
+
+TEST(generated_files_load_back) {
+    GeneratorConfig config;
+    config.base_rate = daily_rate<AShare>(3000);
+    for (std::string filename : {"test_generator.csv", "test_generator.bin"}) {
+        size_t written = OrderFlowGenerator<AShare>(config).write(filename, 1000000);
+        LimitOrderBook<AShare> book, expected;
+        {
+            QuietLoad quiet;
+            CHECK_EQ(book.load(filename), written);
+        }
+        generate_day(expected, 3000, config.seed);
+        book.run();
+        expected.run();
+        CHECK_EQ(book.get_transactions().size(), expected.get_transactions().size());
+        CHECK_EQ(book.get_kth_bid_price(1), expected.get_kth_bid_price(1));
+        std::remove(filename.c_str());
+    }
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,127 @@
+#include <cstdio>
+#include "check.hpp"
+
+static bool same_depth(const L3Snapshot& a, const L3Snapshot& b) {
+    return a.level_price == b.level_price && a.level_quantity == b.level_quantity && a.level_orders == b.level_orders &&
+           a.level_side == b.level_side && a.order_uid == b.order_uid && a.order_quantity == b.order_quantity &&
+           a.order_timestamp == b.order_timestamp;
+}
+
+TEST(dump_lists_levels_and_queues) {
+    LimitOrderBook<AShare> book;
+    book.write(limit_quote(1, 1002, 100, Side::Ask));
+    book.write(limit_quote(2, 998, 200, Side::Bid));
+    book.write(limit_quote(3, 999, 300, Side::Bid));
+    book.write(limit_quote(4, 998, 400, Side::Bid, test_day + 10 * test_hour + test_minute));
+    book.write(limit_quote(5, 1001, 500, Side::Ask));
+    book.write(Quote(2, 0, 200, test_day + 10 * test_hour + 2 * test_minute, Side::Bid, QuoteType::CancelOrder));
+    book.write(limit_quote(6, 998, 600, Side::Bid, test_day + 10 * test_hour + 3 * test_minute));
+
+    auto snapshot = book.dump_l3();
+    CHECK_EQ(snapshot.timestamp, test_day + 10 * test_hour + 3 * test_minute);  // the last quote
+    CHECK_EQ(snapshot.levels(), 4u);
+    CHECK_EQ(snapshot.orders(), 5u);  // the cancelled order is left out
+    CHECK(snapshot.level_price == std::vector<uint64_t>({998, 999, 1001, 1002}));
+    CHECK(snapshot.level_quantity == std::vector<uint64_t>({1000, 300, 500, 100}));
+    CHECK(snapshot.level_orders == std::vector<uint64_t>({2, 1, 1, 1}));
+    CHECK(snapshot.level_side == std::vector<uint8_t>({Side::Bid, Side::Bid, Side::Ask, Side::Ask}));
+    CHECK(snapshot.order_uid == std::vector<uint64_t>({4, 6, 3, 5, 1}));
+    CHECK(snapshot.order_quantity == std::vector<uint64_t>({400, 600, 300, 500, 100}));
+    CHECK_EQ(snapshot.order_timestamp[1], test_day + 10 * test_hour + 3 * test_minute);
+    CHECK_EQ(snapshot.bytes(), 4 * 25u + 5 * 24u);
+
+    // the columns are reused by the next dump into them
+    book.dump_l3(snapshot, 12345);
+    CHECK_EQ(snapshot.timestamp, 12345u);
+    CHECK_EQ(snapshot.orders(), 5u);
+    book.clear();
+    book.dump_l3(snapshot);
+    CHECK_EQ(snapshot.levels(), 0u);
+    CHECK_EQ(snapshot.orders(), 0u);
+}
+
+// the scheduled dumps equal the book of a replay truncated at their times
+TEST(scheduled_dumps_match_truncated_replays) {
+    GeneratorConfig config;
+    config.seed = 3;
+    config.base_rate = daily_rate<AShare>(20000);
+    std::vector<Quote> quotes;
+    OrderFlowGenerator<AShare>(config).generate(20000, [&](const Quote& quote) { quotes.push_back(quote); });
+
+    std::vector<uint64_t> times = {10 * test_hour, 9 * test_hour + 45 * test_minute + 1234567, test_day + 13 * test_hour + 30 * test_minute,
+                                   14 * test_hour + 59 * test_minute};
+    LimitOrderBook<AShare> book;
+    book.schedule_l3(times);
+    for (auto& quote : quotes)
+        book.append(quote);
+    book.run();
+    auto& snapshots = book.get_l3_snapshots();
+    CHECK_EQ(snapshots.size(), times.size());
+    CHECK(book.memory_usage().l3 > 0);
+
+    for (auto& snapshot : snapshots) {
+        LimitOrderBook<AShare> replay;
+        for (auto& quote : quotes)
+            if (quote.timestamp <= snapshot.timestamp)
+                replay.append(quote);
+        replay.run();
+        CHECK(same_depth(snapshot, replay.dump_l3()));
+        CHECK(snapshot.orders() > 0);
+    }
+    // sorted, in absolute time
+    CHECK_EQ(snapshots[0].timestamp, test_day + 9 * test_hour + 45 * test_minute + 1234567);
+    CHECK_EQ(snapshots[2].timestamp, test_day + 13 * test_hour + 30 * test_minute);
+
+    // an empty schedule turns the dumps off for the next run
+    book.clear();
+    book.schedule_l3({});
+    generate_day(book, 1000);
+    book.run();
+    CHECK(book.get_l3_snapshots().empty());
+}
+
+// a dump at the end of the opening auction sees the crossed book, before the auction match
+TEST(dump_at_the_end_of_a_call_auction) {
+    LimitOrderBook<AShare> book;
+    book.schedule_l3({9 * test_hour + 25 * test_minute, 10 * test_hour});
+    book.append(limit_quote(1, 1000, 300, Side::Bid, test_day + 9 * test_hour + 20 * test_minute));
+    book.append(limit_quote(2, 999, 200, Side::Ask, test_day + 9 * test_hour + 21 * test_minute));
+    book.append(limit_quote(3, 990, 100, Side::Bid, test_day + 11 * test_hour));
+    book.run();
+    auto& snapshots = book.get_l3_snapshots();
+    CHECK_EQ(snapshots.size(), 2u);
+    CHECK(snapshots[0].level_price == std::vector<uint64_t>({1000, 999}));
+    CHECK(snapshots[0].order_quantity == std::vector<uint64_t>({300, 200}));
+    CHECK(snapshots[1].order_uid == std::vector<uint64_t>({1}));  // matched in the auction
+    CHECK(snapshots[1].order_quantity == std::vector<uint64_t>({100}));
+    CHECK_EQ(book.get_transactions().size(), 1u);
+}
+
+// dumps written to a file read back equal the dumps kept in memory
+TEST(l3_file_round_trip) {
+    std::vector<uint64_t> times;
+    for (uint64_t minute = 0; minute < 240; minute += 7)
+        times.push_back(9 * test_hour + 30 * test_minute + minute * test_minute);
+    LimitOrderBook<AShare> memory, file;
+    memory.schedule_l3(times);
+    file.schedule_l3(times, "test_l3_dumps.bin");
+    generate_day(memory, 20000, 5);
+    generate_day(file, 20000, 5);
+    memory.run();
+    file.run();
+    CHECK(file.get_l3_snapshots().empty());
+    CHECK_EQ(file.memory_usage().l3, 0u);
+
+    auto snapshots = read_l3_file("test_l3_dumps.bin", AShare::decimal_places);
+    CHECK_EQ(snapshots.size(), memory.get_l3_snapshots().size());
+    for (size_t i = 0; i < snapshots.size() && i < memory.get_l3_snapshots().size(); ++i) {
+        CHECK_EQ(snapshots[i].timestamp, memory.get_l3_snapshots()[i].timestamp);
+        CHECK(same_depth(snapshots[i], memory.get_l3_snapshots()[i]));
+    }
+    CHECK_THROWS(read_l3_file("test_l3_dumps.bin", HKEX::decimal_places), std::runtime_error);
+    file.schedule_l3({});  // closes the file
+    std::remove("test_l3_dumps.bin");
+    CHECK_THROWS(read_l3_file("test_l3_missing.bin", AShare::decimal_places), std::runtime_error);
+}
+
+int main() { return run_tests(); }
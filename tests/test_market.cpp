@@ -0,0 +1,64 @@
+#include "check.hpp"
+
+TEST(ashare_policy) {
+    CHECK_EQ(AShare::decimal_places, 2u);
+    CHECK_EQ(AShare::tick_size(1000), 1u);
+    CHECK(AShare::allows(QuoteType::MarketOrder));
+    CHECK_EQ(AShare::auction_price(1000, 1001), 1000u);  // half ticks round to even
+    CHECK_EQ(AShare::auction_price(1001, 1002), 1002u);
+    CHECK_THROWS(AShare::schedule("HKEX"), std::invalid_argument);
+}
+
+TEST(hkex_policy) {
+    CHECK_EQ(HKEX::decimal_places, 3u);
+    CHECK_EQ(HKEX::tick_size(200), 1u);
+    CHECK_EQ(HKEX::tick_size(5000), 10u);
+    CHECK_EQ(HKEX::tick_size(150000), 100u);
+    CHECK(!HKEX::allows(QuoteType::MarketOrder));
+    CHECK(!HKEX::allows(QuoteType::BestPriceOrder));
+    CHECK_EQ(HKEX::auction_price(5000, 5030), 5010u);  // the midpoint 5015 rounded down onto the spread table
+    CHECK_EQ(HKEX::schedule("HKEXHalfDay").size(), 3u);
+}
+
+// the moves band by band equal a walk one tick at a time, on and off the spread table
+TEST(ticks_above_and_below_walk_the_spread_table) {
+    for (uint64_t price : {1u, 5u, 249u, 250u, 253u, 495u, 500u, 9990u, 10000u, 12345u, 199900u, 4999000u}) {
+        for (uint64_t n : {0u, 1u, 2u, 7u, 50u, 1000u, 4321u}) {
+            uint64_t up = price, down = price;
+            for (uint64_t i = 0; i < n; ++i) {
+                up += HKEX::tick_size(up);
+                if (down > 0)
+                    down -= std::min(down, HKEX::tick_size(down - 1));
+            }
+            CHECK_EQ(ticks_above<HKEX>(price, n), up);
+            CHECK_EQ(ticks_below<HKEX>(price, n), down);
+        }
+    }
+    CHECK_EQ(ticks_above<AShare>(1000, 1u << 30), 1000u + (1u << 30));
+    CHECK_EQ(ticks_below<AShare>(1000, 999), 1u);
+    CHECK_EQ(ticks_below<AShare>(1000, 1u << 30), 0u);
+    CHECK_EQ(ticks_above<HKEX>(1000, std::numeric_limits<uint64_t>::max()), std::numeric_limits<uint64_t>::max());
+}
+
+TEST(hkex_book_scale_and_quote_types) {
+    LimitOrderBook<HKEX> book;
+    book.write(limit_quote(1, 12340, 400, Side::Bid));
+    book.write(limit_quote(2, 12360, 400, Side::Ask));
+    CHECK_NEAR(book.get_kth_bid_price(1), 12.34, 1e-9);
+    CHECK_NEAR(book.get_kth_ask_price(1), 12.36, 1e-9);
+    CHECK_THROWS(book.write(Quote(3, 0, 100, test_day + 10 * test_hour, Side::Bid, QuoteType::MarketOrder)), std::invalid_argument);
+    CHECK_THROWS(LimitOrderBook<HKEX>(0, 5, "AShare"), std::invalid_argument);
+}
+
+TEST(ashare_continuous_match_at_resting_price) {
+    LimitOrderBook<AShare> book;
+    book.write(limit_quote(1, 1000, 300, Side::Ask));
+    book.write(limit_quote(2, 1001, 200, Side::Bid));
+    auto transactions = book.get_transactions();
+    CHECK_EQ(transactions.size(), 1u);
+    CHECK_EQ(transactions[0].price, 1000u);
+    CHECK_EQ(transactions[0].quantity, 200u);
+    CHECK_EQ(book.get_kth_ask_volume(1), 100u);
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,69 @@
+#include "check.hpp"
+
+static size_t parts(const MemoryUsage& usage) {
+    return usage.arena_reserved + usage.quotes + usage.transactions + usage.fills + usage.ticks + usage.pending + usage.streams + usage.checkpoints + usage.l3;
+}
+
+TEST(memory_usage_adds_up) {
+    LimitOrderBook<AShare> book(test_minute);
+    auto empty = book.memory_usage();
+    CHECK_EQ(empty.quotes, 0u);
+    CHECK_EQ(empty.total, parts(empty));
+
+    generate_day(book, 20000);
+    auto loaded = book.memory_usage();
+    CHECK(loaded.quotes >= 19000 * sizeof(Quote));
+    book.set_checkpoint_interval(30 * test_minute);
+    book.schedule_l3({10 * test_hour, 14 * test_hour});
+    book.run();
+    auto usage = book.memory_usage();
+    CHECK_EQ(usage.total, parts(usage));
+    CHECK_EQ(usage.quotes, 0u);  // consumed by the run
+    CHECK(usage.transactions > 0 && usage.ticks > 0);
+    CHECK(usage.checkpoints > 0);
+    size_t l3 = 0;
+    for (auto& snapshot : book.get_l3_snapshots())
+        l3 += snapshot.bytes();
+    CHECK_EQ(usage.l3, l3);
+    CHECK(usage.arena_used <= usage.arena_reserved);
+    CHECK(usage.orders + usage.levels + usage.tree_nodes + usage.queue_indexes <= usage.arena_used);
+    CHECK(usage.peak >= std::max(usage.total, loaded.total));
+
+    book.clear();
+    auto cleared = book.memory_usage();
+    CHECK_EQ(cleared.transactions + cleared.ticks + cleared.checkpoints + cleared.l3, 0u);
+    CHECK_EQ(cleared.peak, usage.peak);
+}
+
+TEST(compact_mode_replays_the_same_day) {
+    LimitOrderBook<AShare> full(test_minute), compact(test_minute);
+    compact.set_compact(true);
+    CHECK(compact.is_compact());
+    generate_day(full, 20000);
+    generate_day(compact, 20000);
+    CHECK_EQ(compact.memory_usage().quotes / sizeof(CompactQuote), full.memory_usage().quotes / sizeof(Quote));
+    CHECK(compact.memory_usage().quotes < full.memory_usage().quotes);
+    full.run();
+    compact.run();
+    auto a = full.get_transactions(), b = compact.get_transactions();
+    CHECK_EQ(a.size(), b.size());
+    bool same = a.size() == b.size();
+    for (size_t i = 0; same && i < a.size(); ++i)
+        same = a[i].bid_uid == b[i].bid_uid && a[i].ask_uid == b[i].ask_uid && a[i].price == b[i].price && a[i].quantity == b[i].quantity && a[i].timestamp == b[i].timestamp;
+    CHECK(same);
+    CHECK(compact.memory_usage().transactions < full.memory_usage().transactions);
+    CHECK_EQ(full.get_ticks().size(), compact.get_ticks().size());
+}
+
+TEST(compact_mode_rejects_what_does_not_fit) {
+    LimitOrderBook<AShare> book;
+    book.set_compact(true);
+    book.append(limit_quote(1, 1000, 100, Side::Bid));
+    CHECK_THROWS(book.append(limit_quote(2, 1000, 1UL << 32, Side::Bid)), std::runtime_error);
+    CHECK_THROWS(book.set_compact(false), std::runtime_error);  // the book holds records
+    book.clear();
+    book.set_compact(false);
+    CHECK(!book.is_compact());
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,68 @@
+#include "check.hpp"
+
+static Quote modify_quote(uint64_t uid, uint64_t price, uint64_t quantity, Side side) {
+    return Quote(uid, price, quantity, test_day + 10 * test_hour + test_minute, side, QuoteType::ModifyOrder);
+}
+
+// two bids of 100 at 10.00, uid 1 ahead of uid 2
+static void two_bids(LimitOrderBook<AShare>& book) {
+    book.write(limit_quote(1, 1000, 100, Side::Bid));
+    book.write(limit_quote(2, 1000, 100, Side::Bid));
+}
+
+TEST(reduce_keeps_the_queue_position) {
+    LimitOrderBook<AShare> book;
+    two_bids(book);
+    book.write(modify_quote(1, 0, 50, Side::Bid));
+    CHECK_EQ(book.get_kth_bid_volume(1), 150u);
+    book.write(limit_quote(3, 1000, 60, Side::Ask, test_day + 11 * test_hour));
+    auto transactions = book.get_transactions();
+    CHECK_EQ(transactions.size(), 2u);
+    CHECK_EQ(transactions[0].bid_uid, 1u);
+    CHECK_EQ(transactions[0].quantity, 50u);
+    CHECK_EQ(transactions[1].bid_uid, 2u);
+    CHECK_EQ(transactions[1].quantity, 10u);
+}
+
+TEST(increase_moves_to_the_back) {
+    LimitOrderBook<AShare> book;
+    two_bids(book);
+    book.write(modify_quote(1, 0, 150, Side::Bid));
+    CHECK_EQ(book.get_kth_bid_volume(1), 250u);
+    book.write(limit_quote(3, 1000, 120, Side::Ask, test_day + 11 * test_hour));
+    auto transactions = book.get_transactions();
+    CHECK_EQ(transactions.size(), 2u);
+    CHECK_EQ(transactions[0].bid_uid, 2u);
+    CHECK_EQ(transactions[0].quantity, 100u);
+    CHECK_EQ(transactions[1].bid_uid, 1u);
+    CHECK_EQ(transactions[1].quantity, 20u);
+}
+
+TEST(price_change_moves_the_order) {
+    LimitOrderBook<AShare> book;
+    two_bids(book);
+    book.write(limit_quote(3, 1010, 100, Side::Ask));
+    book.write(modify_quote(1, 1005, 100, Side::Bid));
+    CHECK_NEAR(book.get_kth_bid_price(1), 10.05, 1e-9);
+    CHECK_EQ(book.get_kth_bid_volume(1), 100u);
+    CHECK_EQ(book.get_kth_bid_volume(2), 100u);
+
+    // a price through the spread matches on the amend
+    book.write(modify_quote(2, 1010, 100, Side::Bid));
+    auto transactions = book.get_transactions();
+    CHECK_EQ(transactions.size(), 1u);
+    CHECK_EQ(transactions[0].bid_uid, 2u);
+    CHECK_EQ(transactions[0].price, 1010u);
+    CHECK_NEAR(book.get_kth_bid_price(1), 10.05, 1e-9);
+}
+
+TEST(zero_quantity_cancels_and_unknown_orders_throw) {
+    LimitOrderBook<AShare> book;
+    two_bids(book);
+    book.write(modify_quote(1, 0, 0, Side::Bid));
+    CHECK_EQ(book.get_kth_bid_volume(1), 100u);
+    CHECK_THROWS(book.write(modify_quote(1, 0, 50, Side::Bid)), std::runtime_error);
+    CHECK_THROWS(book.write(modify_quote(9, 0, 50, Side::Bid)), std::runtime_error);
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,62 @@
+#include "check.hpp"
+#include "multi_book.hpp"
+
+// the trades of every book, in the order they happen across books
+struct SharedLog : NullObserver {
+    std::vector<uint64_t>* timestamps = nullptr;
+    inline void on_trade(const Transaction& transaction) { timestamps->push_back(transaction.timestamp); }
+};
+
+typedef LimitOrderBook<AShare, SharedLog> Book;
+
+TEST(multi_book_replay_equals_single_runs) {
+    std::vector<uint64_t> merged, single;
+    std::vector<std::unique_ptr<Book>> books, alone;
+    for (uint64_t seed = 1; seed <= 3; ++seed) {
+        for (auto* group : {&books, &alone}) {
+            group->emplace_back(new Book(test_minute));
+            group->back()->get_observer().timestamps = group == &books ? &merged : &single;
+            group->back()->set_bar_frequencies({5 * test_minute});
+            generate_day(*group->back(), 10000, seed);
+        }
+    }
+    MultiBookReplay<Book> replay;
+    for (auto& book : books)
+        replay.add(*book);
+    size_t period_ends = 0;
+    bool consistent = true;
+    replay.run([&](TradingStatus status, uint64_t timestamp) {
+        ++period_ends;
+        for (auto& book : books)  // every book is at the same period end
+            consistent &= book->get_ticks().size() == books[0]->get_ticks().size();
+    });
+    for (auto& book : alone)
+        book->run();
+
+    CHECK(period_ends > 200);
+    CHECK(consistent);
+    CHECK(std::is_sorted(merged.begin(), merged.end()));
+    CHECK_EQ(merged.size(), single.size());
+    for (size_t i = 0; i < books.size(); ++i) {
+        auto a = books[i]->get_transactions(), b = alone[i]->get_transactions();
+        bool same = a.size() == b.size();
+        for (size_t j = 0; same && j < a.size(); ++j)
+            same = a[j].bid_uid == b[j].bid_uid && a[j].ask_uid == b[j].ask_uid && a[j].quantity == b[j].quantity && a[j].timestamp == b[j].timestamp;
+        CHECK(same);
+        CHECK_EQ(books[i]->get_ticks().size(), alone[i]->get_ticks().size());
+        CHECK(books[i]->get_bars(5 * test_minute).volume == alone[i]->get_bars(5 * test_minute).volume);
+    }
+}
+
+TEST(multi_book_replay_needs_one_schedule) {
+    std::vector<uint64_t> log;
+    Book a(test_minute), b(5 * test_minute);
+    a.get_observer().timestamps = b.get_observer().timestamps = &log;
+    generate_day(a, 1000);
+    generate_day(b, 1000);
+    MultiBookReplay<Book> replay({&a, &b});
+    CHECK_EQ(replay.size(), 2u);
+    CHECK_THROWS(replay.run(), std::invalid_argument);
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,29 @@
+import glob
+import os
+import subprocess
+
+import pytest
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+NAMES = [os.path.splitext(os.path.basename(source))[0] for source in sorted(glob.glob(os.path.join(ROOT, "tests", "test_*.cpp")))]
+
+
+@pytest.mark.parametrize("name", NAMES)
+def test_native(name):
+    # built by `python setup.py build_ext --inplace` into build/tests
+    executable = os.path.join(ROOT, "build", "tests", name)
+    assert os.path.exists(executable), executable + " is not built"
+    result = subprocess.run([executable], cwd=ROOT, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    assert result.returncode == 0, result.stdout
+
+
+def test_flob_replay(tmp_path):
+    # the standalone replay, built into build/bin
+    executable = os.path.join(ROOT, "build", "bin", "flob-replay")
+    assert os.path.exists(executable), executable + " is not built"
+    ticks = tmp_path / "ticks.csv"
+    args = [executable, "--generate", "20000", "--seed", "1", "--snapshot_gap", "60s", "--transactions", "", "--ticks", str(ticks)]
+    result = subprocess.run(args, cwd=ROOT, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, universal_newlines=True)
+    assert result.returncode == 0, result.stdout
+    with open(os.path.join(ROOT, "benchmark", "golden", "ticks.csv")) as golden:
+        assert ticks.read_text() == golden.read()
@@ -0,0 +1,75 @@
+#include <map>
+#include "check.hpp"
+
+// keeps every event it sees
+struct RecordingObserver {
+    std::vector<Transaction> trades;
+    std::map<std::pair<uint8_t, uint64_t>, uint64_t> levels;  // (side, price) -> quantity
+    size_t snapshots = 0, period_ends = 0;
+
+    void on_trade(const Transaction& transaction) { trades.push_back(transaction); }
+    void on_fill(const Transaction& transaction) {}
+    void on_level_change(Side side, uint64_t price, uint64_t quantity, uint64_t timestamp) {
+        if (quantity == 0)
+            levels.erase({side, price});
+        else
+            levels[{side, price}] = quantity;
+    }
+    void on_snapshot(const Tick& tick) { ++snapshots; }
+    void on_period_end(TradingStatus status, uint64_t timestamp) { ++period_ends; }
+};
+
+// the events of a replayed day rebuild its transactions and its book
+TEST(observer_sees_every_event) {
+    LimitOrderBook<AShare, RecordingObserver> book(test_minute);
+    generate_day(book, 20000);
+    book.run();
+    RecordingObserver& observer = book.get_observer();
+
+    auto transactions = book.get_transactions();
+    CHECK_EQ(observer.trades.size(), transactions.size());
+    bool same = observer.trades.size() == transactions.size();
+    for (size_t i = 0; same && i < transactions.size(); ++i)
+        same = observer.trades[i].bid_uid == transactions[i].bid_uid && observer.trades[i].quantity == transactions[i].quantity;
+    CHECK(same);
+    CHECK_EQ(observer.snapshots, book.get_ticks().size());
+    CHECK(observer.period_ends >= 4);
+
+    size_t n = 1 << 20;
+    auto bid_prices = book.get_topk_bid_price(n), ask_prices = book.get_topk_ask_price(n);
+    auto bid_volumes = book.get_topk_bid_volume(n), ask_volumes = book.get_topk_ask_volume(n);
+    CHECK_EQ(observer.levels.size(), bid_prices.size() + ask_prices.size());
+    auto level = [&](Side side, double price) { return observer.levels[std::make_pair((uint8_t)side, (uint64_t)std::llround(price * 100))]; };
+    for (size_t i = 0; i < bid_prices.size(); ++i)
+        CHECK_EQ(level(Side::Bid, bid_prices[i]), bid_volumes[i]);
+    for (size_t i = 0; i < ask_prices.size(); ++i)
+        CHECK_EQ(level(Side::Ask, ask_prices[i]), ask_volumes[i]);
+}
+
+TEST(batch_observer_delivers_in_batches) {
+    LimitOrderBook<AShare, BatchObserver> book;
+    book.write(limit_quote(1, 1000, 100, Side::Bid));  // no sink yet, not recorded
+    std::vector<size_t> sizes;
+    size_t trades = 0, levels = 0;
+    book.get_observer().set_sink(
+        [&](const EventBatch& batch) {
+            sizes.push_back(batch.size());
+            trades += batch.trade_timestamp.size();
+            levels += batch.level_timestamp.size();
+        },
+        3);
+    for (uint64_t uid = 2; uid <= 11; ++uid)
+        book.write(limit_quote(uid, 1000, 100, Side::Ask));  // one trade, then 9 asks rest
+    book.get_observer().flush();
+    size_t total = 0;
+    for (size_t size : sizes) {
+        CHECK(size <= 3);
+        total += size;
+    }
+    CHECK_EQ(trades, 1u);
+    CHECK_EQ(total, trades + levels);
+    CHECK_EQ(levels, 12u);  // the first ask joins, both levels empty by the trade, then 9 asks rest
+    CHECK(sizes.back() < 3);
+}
+
+int main() { return run_tests(); }
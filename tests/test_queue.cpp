@@ -0,0 +1,57 @@
+#include <random>
+#include "check.hpp"
+
+// one bid level churned by joins, cancels, amends and fills, compared with a plain queue
+TEST(queue_position_follows_the_level) {
+    LimitOrderBook<AShare> book;
+    std::vector<std::pair<uint64_t, uint64_t>> queue;  // uid, quantity in time priority
+    std::mt19937_64 rng(9);
+    uint64_t uid = 0, timestamp = test_day + 10 * test_hour;
+    for (size_t i = 0; i < 3000; ++i) {
+        ++timestamp;
+        size_t action = rng() % 10;
+        if (action < 5 || queue.empty()) {
+            uint64_t quantity = 100 * (1 + rng() % 5);
+            book.write(limit_quote(++uid, 1000, quantity, Side::Bid, timestamp));
+            queue.emplace_back(uid, quantity);
+        } else if (action < 7) {
+            size_t j = rng() % queue.size();
+            book.write(Quote(queue[j].first, 1000, queue[j].second, timestamp, Side::Bid, QuoteType::CancelOrder));
+            queue.erase(queue.begin() + j);
+        } else if (action < 8) {
+            size_t j = rng() % queue.size();
+            queue[j].second = 1 + rng() % queue[j].second;
+            book.write(Quote(queue[j].first, 0, queue[j].second, timestamp, Side::Bid, QuoteType::ModifyOrder));
+        } else {
+            uint64_t quantity = 1 + rng() % 300;  // fills from the front
+            book.write(limit_quote(++uid, 1000, quantity, Side::Ask, timestamp));
+            while (quantity > 0 && !queue.empty()) {
+                uint64_t traded = std::min(quantity, queue.front().second);
+                quantity -= traded;
+                queue.front().second -= traded;
+                if (queue.front().second == 0)
+                    queue.erase(queue.begin());
+            }
+            if (quantity > 0)  // the rest of the ask now rests, take it out again
+                book.write(Quote(uid, 1000, quantity, timestamp, Side::Ask, QuoteType::CancelOrder));
+        }
+        if (i % 100 == 0 || i > 2900) {
+            uint64_t ahead = 0;
+            for (size_t j = 0; j < queue.size(); ++j) {
+                CHECK_EQ(book.queue_position(queue[j].first), j);
+                CHECK_EQ(book.queue_ahead(queue[j].first), ahead);
+                ahead += queue[j].second;
+            }
+        }
+    }
+}
+
+TEST(queue_position_of_an_unknown_order_throws) {
+    LimitOrderBook<AShare> book;
+    book.write(limit_quote(1, 1000, 100, Side::Bid));
+    CHECK_EQ(book.queue_position(1), 0u);
+    CHECK_THROWS(book.queue_position(2), std::runtime_error);
+    CHECK_THROWS(book.queue_ahead(2), std::runtime_error);
+}
+
+int main() { return run_tests(); }
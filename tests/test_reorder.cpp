@@ -0,0 +1,153 @@
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include "check.hpp"
+
+static Quote at(uint64_t timestamp, uint64_t uid) { return limit_quote(uid, 1000, 100, Side::Bid, timestamp); }
+
+static std::vector<uint64_t> poll_uids(ReorderBuffer& buffer) {
+    std::vector<uint64_t> uids;
+    buffer.poll([&](const Quote& quote) { uids.push_back(quote.uid); });
+    return uids;
+}
+
+TEST(merge_waits_for_silent_channels) {
+    ReorderBuffer buffer(2, 16);
+    buffer.push(0, at(1, 1));
+    buffer.push(0, at(3, 3));
+    buffer.push(0, at(5, 5));
+    buffer.push(1, at(2, 2));
+    buffer.push(1, at(4, 4));
+    CHECK(poll_uids(buffer) == std::vector<uint64_t>({1, 2, 3, 4}));  // channel 1 may still send before 5
+    buffer.heartbeat(1, 4);
+    CHECK(poll_uids(buffer).empty());  // a quote at 5 could still follow
+    buffer.heartbeat(1, 5);
+    CHECK(poll_uids(buffer) == std::vector<uint64_t>({5}));  // nothing at or before 5 follows
+    buffer.push(1, at(7, 7));
+    buffer.close(0);
+    CHECK(poll_uids(buffer) == std::vector<uint64_t>({7}));
+    CHECK(buffer.empty());
+    CHECK_EQ(buffer.late_count(), 0u);
+}
+
+// a heartbeat at the timestamp of the head releases it, a sequenced one is the next sequence the
+// channel may still send
+TEST(heartbeat_boundaries) {
+    ReorderBuffer buffer(2, 16);
+    buffer.push(0, at(5, 1));
+    buffer.heartbeat(1, 5);
+    CHECK(poll_uids(buffer) == std::vector<uint64_t>({1}));
+
+    ReorderBuffer sequenced(2, 16, true);
+    sequenced.push(0, at(1, 1), 3);
+    sequenced.heartbeat(1, 2);
+    CHECK(poll_uids(sequenced).empty());  // 2 may still follow on channel 1
+    sequenced.heartbeat(1, 3);
+    CHECK(poll_uids(sequenced) == std::vector<uint64_t>({1}));
+    CHECK_EQ(sequenced.late_count(), 0u);
+}
+
+TEST(late_quotes_are_dropped) {
+    ReorderBuffer buffer(2, 16);
+    buffer.push(0, at(5, 10));
+    buffer.close(1);
+    CHECK(poll_uids(buffer) == std::vector<uint64_t>({10}));
+    buffer.push(1, at(3, 8));  // behind the release
+    buffer.push(1, at(5, 9));  // same timestamp, an earlier uid on another channel
+    buffer.push(0, at(6, 12));
+    CHECK(poll_uids(buffer) == std::vector<uint64_t>({12}));
+    CHECK_EQ(buffer.late_count(), 2u);
+    buffer.push(0, at(6, 4));  // same timestamp and channel, e.g. a cancel of an older order
+    buffer.close(0);
+    CHECK(poll_uids(buffer) == std::vector<uint64_t>({4}));
+    CHECK_EQ(buffer.late_count(), 2u);
+}
+
+TEST(sequence_gaps_are_recorded) {
+    ReorderBuffer buffer(2, 16, true);
+    buffer.push(0, at(1, 1), 0);
+    buffer.push(1, at(1, 2), 1);
+    buffer.push(0, at(2, 3), 4);
+    buffer.push(1, at(3, 4), 5);
+    CHECK(poll_uids(buffer) == std::vector<uint64_t>({1, 2, 3, 4}));  // 2 and 3 never arrive
+    CHECK_EQ(buffer.get_gaps().size(), 1u);
+    CHECK_EQ(buffer.get_gaps()[0].expected, 2u);
+    CHECK_EQ(buffer.get_gaps()[0].received, 4u);
+    buffer.push(0, at(4, 5), 3);  // too late
+    buffer.close(0);
+    buffer.close(1);
+    CHECK(poll_uids(buffer).empty());
+    CHECK_EQ(buffer.late_count(), 1u);
+    CHECK_THROWS(ReorderBuffer(0), std::invalid_argument);
+}
+
+// decoder threads through small rings, the merge is in global order
+TEST(threaded_merge_is_ordered) {
+    const size_t channels = 4, per_channel = 20000;
+    ReorderBuffer buffer(channels, 64);
+    std::vector<std::thread> producers;
+    for (size_t c = 0; c < channels; ++c) {
+        producers.emplace_back([&buffer, c] {
+            for (uint64_t i = 0; i < per_channel; ++i)
+                buffer.push(c, at(test_day + (i * channels + c) / 3, i * channels + c + 1));
+            buffer.close(c);
+        });
+    }
+    std::vector<uint64_t> uids;
+    size_t count = buffer.run([&](const Quote& quote) { uids.push_back(quote.uid); });
+    for (auto& producer : producers)
+        producer.join();
+    CHECK_EQ(count, channels * per_channel);
+    bool ordered = true;
+    for (size_t i = 0; i < uids.size(); ++i)
+        ordered &= uids[i] == i + 1;
+    CHECK(ordered);
+    CHECK_EQ(buffer.late_count(), 0u);
+}
+
+// producers racing the merge: a quote pushed between the head scan and the release may come
+// first, it must not be dropped as late
+TEST(racing_producers_are_not_late) {
+    const size_t channels = 2, per_channel = 5000;
+    for (size_t round = 0; round < 20; ++round) {
+        ReorderBuffer buffer(channels, 4);
+        std::vector<std::thread> producers;
+        for (size_t c = 0; c < channels; ++c) {
+            producers.emplace_back([&buffer, c] {
+                for (uint64_t i = 0; i < per_channel; ++i) {
+                    buffer.push(c, at(test_day + i * channels + c, i * channels + c + 1));
+                    if (i % 7 == c)
+                        std::this_thread::yield();
+                }
+                buffer.close(c);
+            });
+        }
+        size_t count = buffer.run([](const Quote&) {});
+        for (auto& producer : producers)
+            producer.join();
+        CHECK_EQ(count, channels * per_channel);
+        CHECK_EQ(buffer.late_count(), 0u);
+    }
+}
+
+// a load of several files reports what the merge had to drop
+TEST(multi_file_load_reports_late_quotes) {
+    auto write = [](const std::string& filename, std::vector<std::pair<uint64_t, uint64_t>> rows) {
+        std::ofstream file(filename);
+        file << "timestamp,uid,price,quantity,side,type\n";
+        for (auto& [timestamp, uid] : rows)
+            file << test_day + 10 * test_hour + timestamp << "," << uid << ",10.00,100,0,0\n";
+    };
+    write("test_reorder_a.csv", {{1, 1}, {3, 3}, {5, 5}});
+    write("test_reorder_b.csv", {{2, 2}, {4, 4}});
+    write("test_reorder_c.csv", {{6, 6}, {2, 7}});
+    LimitOrderBook<AShare> book;
+    QuietLoad quiet;
+    CHECK_EQ(book.load(std::vector<std::string>{"test_reorder_a.csv", "test_reorder_b.csv"}), 5u);
+    LimitOrderBook<AShare> late;
+    CHECK_THROWS(late.load(std::vector<std::string>{"test_reorder_a.csv", "test_reorder_c.csv"}), std::runtime_error);
+    for (auto filename : {"test_reorder_a.csv", "test_reorder_b.csv", "test_reorder_c.csv"})
+        std::remove(filename);
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,67 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "check.hpp"
+#include "replay.hpp"
+
+static std::string read_file(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary);
+    std::stringstream ss;
+    ss << file.rdbuf();
+    return ss.str();
+}
+
+TEST(replay_options) {
+    CHECK_EQ(parse_duration("3s"), 3000000000u);
+    CHECK_EQ(parse_duration("500ms"), 500000000u);
+    CHECK_EQ(parse_duration("1min"), 60000000000u);
+    CHECK_EQ(parse_duration("250"), 250u);
+    CHECK_THROWS(parse_duration("3 days"), std::invalid_argument);
+
+    auto options = parse_replay_options({"--generate", "1000", "--seed", "7", "--market", "HKEX", "--features", "spread,,imbalance", "--ticks", ""});
+    CHECK_EQ(options.generate, 1000u);
+    CHECK_EQ(options.seed, 7u);
+    CHECK_EQ(options.market, std::string("HKEX"));
+    CHECK(options.features == std::vector<std::string>({"spread", "imbalance"}));
+    CHECK(options.ticks.empty());
+    CHECK_EQ(options.transactions, std::string("data/transactions.csv"));
+    CHECK_THROWS(parse_replay_options({}), std::invalid_argument);
+    CHECK_THROWS(parse_replay_options({"--data", "a.csv", "--generate", "10"}), std::invalid_argument);
+    CHECK_THROWS(parse_replay_options({"--data"}), std::invalid_argument);
+    CHECK_THROWS(parse_replay_options({"--data", "a.csv", "--speed", "2"}), std::invalid_argument);
+}
+
+// the fixture of the replay benchmark was written by flob-replay with these options
+TEST(generated_replay_matches_the_golden_files) {
+    int status = replay_main({"--generate", "20000", "--seed", "1", "--snapshot_gap", "60s",
+                              "--transactions", "test_replay_transactions.csv", "--ticks", "test_replay_ticks.csv"});
+    CHECK_EQ(status, 0);
+    CHECK(read_file("test_replay_transactions.csv") == read_file("benchmark/golden/transactions.csv"));
+    CHECK(read_file("test_replay_ticks.csv") == read_file("benchmark/golden/ticks.csv"));
+    std::remove("test_replay_transactions.csv");
+    std::remove("test_replay_ticks.csv");
+}
+
+TEST(replay_streams_binary_outputs) {
+    int status = replay_main({"--generate", "5000", "--market", "HKEX", "--transactions", "test_replay_transactions.bin", "--ticks", ""});
+    CHECK_EQ(status, 0);
+    LimitOrderBook<HKEX> book(3000000000UL);
+    GeneratorConfig config;
+    config.base_rate = daily_rate<HKEX>(5000);
+    OrderFlowGenerator<HKEX>(config).generate(5000, [&](const Quote& quote) { book.append(quote); });
+    book.run();
+    CHECK_EQ(read_transaction_file("test_replay_transactions.bin", 3, [](const Transaction&) {}), book.get_transactions().size());
+    std::remove("test_replay_transactions.bin");
+}
+
+TEST(replay_reports_errors) {
+    QuietLoad quiet;
+    auto buffer = std::cerr.rdbuf(nullptr);
+    int missing = replay_main({"--data", "test_replay_missing.csv"});
+    int market = replay_main({"--generate", "10", "--market", "NYSE"});
+    std::cerr.rdbuf(buffer);
+    CHECK_EQ(missing, 2);
+    CHECK_EQ(market, 2);
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,66 @@
+#ifndef FLOB_STATS
+#define FLOB_STATS  // the instrumentation is tested whether or not the build enables it
+#endif
+#include <thread>
+#include "check.hpp"
+
+TEST(histogram_percentiles) {
+    LatencyHistogram histogram;
+    CHECK_EQ(histogram.percentile(0.5), 0u);
+    for (uint64_t value = 1; value <= 31; ++value)
+        histogram.record(value);
+    CHECK_EQ(histogram.percentile(0.5), 16u);  // exact below 32 ns
+    CHECK_EQ(histogram.min, 1u);
+    CHECK_EQ(histogram.max, 31u);
+    CHECK_NEAR(histogram.mean(), 16, 1e-9);
+
+    histogram.clear();
+    for (uint64_t value = 1; value <= 100000; ++value)
+        histogram.record(value * 10);
+    for (double q : {0.1, 0.5, 0.9, 0.99, 0.999}) {
+        double expected = q * 1000000;
+        CHECK(std::fabs(histogram.percentile(q) - expected) <= expected / 32);
+    }
+    CHECK_EQ(histogram.percentile(1), 1000000u);
+    histogram.record(1UL << 50);  // clamped
+    CHECK_EQ(histogram.max, (1UL << 40) - 1);
+}
+
+TEST(book_counts_its_work) {
+    LimitOrderBook<AShare> book(test_minute);
+    generate_day(book, 20000);
+    book.run();
+    BookStats stats = book.stats();
+    CHECK(stats.enabled);
+    uint64_t quotes = 0;
+    for (auto& histogram : stats.quotes)
+        quotes += histogram.count;
+    CHECK(quotes > 19000);
+    CHECK(stats.quotes[QuoteType::LimitOrder].count > stats.quotes[QuoteType::CancelOrder].count);
+    CHECK_EQ(stats.snapshot.count, book.get_ticks().size());
+    CHECK_EQ(stats.levels_created - stats.levels_destroyed, stats.bid_levels + stats.ask_levels);
+    CHECK(stats.max_resting_orders >= stats.resting_orders);
+    CHECK_EQ(stats.phases[TradingStatus::CallAuction].count, 2u);
+    CHECK(stats.phases[TradingStatus::ContinuousTrading].nanoseconds > 0);
+
+    book.reset_stats();
+    CHECK_EQ(book.stats().snapshot.count, 0u);
+    CHECK_EQ(book.stats().resting_orders, stats.resting_orders);  // the book itself is unchanged
+}
+
+// the counters follow the thread that runs the book, not the one that built it
+TEST(perf_counters_on_the_replay_thread) {
+    LimitOrderBook<AShare> book;
+    generate_day(book, 5000);
+    std::thread runner([&] { book.run(); });
+    runner.join();
+    BookStats stats = book.stats();
+    if (stats.perf_available) {
+        CHECK(stats.phases[TradingStatus::ContinuousTrading].cycles > 0);
+        CHECK(stats.phases[TradingStatus::ContinuousTrading].instructions > 0);
+    } else {
+        CHECK_EQ(stats.phases[TradingStatus::ContinuousTrading].cycles, 0u);
+    }
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,78 @@
+#include "check.hpp"
+
+const uint64_t ten = test_day + 10 * test_hour, microsecond = 1000;
+
+// an ask of 500 at 10.00 and a market bid taking 300 of it one millisecond later
+static void market(LimitOrderBook<AShare>& book) {
+    book.append(limit_quote(1, 1000, 500, Side::Ask, ten));
+    book.append(limit_quote(2, 1000, 300, Side::Bid, ten + 1000 * microsecond));
+    book.append(limit_quote(3, 990, 100, Side::Bid, ten + 10 * test_minute));
+}
+
+TEST(strategy_order_ahead_of_the_market) {
+    LimitOrderBook<AShare> book;
+    market(book);
+    book.set_latency(500 * microsecond);
+    uint64_t uid = book.submit(Side::Bid, 1000, 200, ten);
+    CHECK(LimitOrderBook<AShare>::is_strategy(uid));
+    book.until(11 * test_hour);
+    auto fills = book.get_fills();
+    CHECK_EQ(fills.size(), 1u);
+    CHECK_EQ(fills[0].bid_uid, uid);
+    CHECK_EQ(fills[0].quantity, 200u);
+    CHECK_EQ(fills[0].timestamp, ten + 500 * microsecond);
+    auto transactions = book.get_transactions();  // fills stay out of the market data
+    CHECK_EQ(transactions.size(), 1u);
+    CHECK_EQ(transactions[0].quantity, 300u);
+    CHECK_EQ(book.get_kth_ask_volume(1), 0u);
+}
+
+TEST(strategy_order_behind_the_market) {
+    LimitOrderBook<AShare> book;
+    market(book);
+    book.set_latency(2000 * microsecond);
+    uint64_t uid = book.submit(Side::Bid, 1000, 300, ten);
+    book.until(11 * test_hour);
+    auto fills = book.get_fills();
+    CHECK_EQ(fills.size(), 1u);
+    CHECK_EQ(fills[0].quantity, 200u);  // what the market bid left
+    CHECK_NEAR(book.get_kth_bid_price(1), 10.00, 1e-9);
+    CHECK_EQ(book.get_kth_bid_volume(1), 100u);
+    CHECK_EQ(book.queue_position(uid), 0u);
+}
+
+TEST(strategy_cancel_after_latency) {
+    LimitOrderBook<AShare> book;
+    market(book);
+    book.set_latency(2000 * microsecond);
+    uint64_t uid = book.submit(Side::Bid, 995, 100, ten);
+    book.cancel(uid, ten + 5 * test_minute);
+    book.until(10 * test_hour + 5 * test_minute);
+    CHECK_NEAR(book.get_kth_bid_price(1), 9.95, 1e-9);  // the cancel is still on its way
+    book.until(11 * test_hour);
+    CHECK_NEAR(book.get_kth_bid_price(1), 9.90, 1e-9);
+    CHECK_THROWS(book.cancel(3, ten), std::invalid_argument);
+}
+
+TEST(latency_jitter_is_seeded) {
+    auto arrivals = [](uint64_t seed) {
+        LimitOrderBook<AShare> book;
+        book.append(limit_quote(1, 1000, 100000, Side::Ask, ten));
+        book.append(limit_quote(2, 990, 100, Side::Bid, ten + test_minute));
+        book.set_latency(100 * microsecond, 50 * microsecond, seed);
+        for (int i = 0; i < 10; ++i)
+            book.submit(Side::Bid, 1000, 100, ten + i * microsecond);
+        book.until(11 * test_hour);
+        std::vector<uint64_t> timestamps;
+        for (auto& fill : book.get_fills()) {
+            CHECK(fill.timestamp >= ten + 100 * microsecond && fill.timestamp <= ten + 160 * microsecond);
+            timestamps.push_back(fill.timestamp);
+        }
+        return timestamps;
+    };
+    CHECK_EQ(arrivals(1).size(), 10u);
+    CHECK(arrivals(1) == arrivals(1));
+    CHECK(arrivals(1) != arrivals(2));
+}
+
+int main() { return run_tests(); }
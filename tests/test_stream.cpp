@@ -0,0 +1,81 @@
+#include <cstdio>
+#include <fstream>
+#include "check.hpp"
+
+static bool same_tick(const Tick& a, const Tick& b) {
+    auto same = [](double x, double y) { return (std::isnan(x) && std::isnan(y)) || std::fabs(x - y) < 1e-9; };
+    bool result = a.timestamp == b.timestamp && a.volume == b.volume && same(a.open, b.open) && same(a.high, b.high) &&
+                  same(a.low, b.low) && same(a.close, b.close) && same(a.amount, b.amount) &&
+                  a.bid_volumes == b.bid_volumes && a.ask_volumes == b.ask_volumes && a.features.size() == b.features.size();
+    for (size_t i = 0; result && i < a.bid_prices.size(); ++i)
+        result = same(a.bid_prices[i], b.bid_prices[i]) && same(a.ask_prices[i], b.ask_prices[i]);
+    for (size_t i = 0; result && i < a.features.size(); ++i)
+        result = same(a.features[i], b.features[i]);
+    return result;
+}
+
+static size_t lines(const std::string& filename) {
+    std::ifstream file(filename);
+    std::string line;
+    size_t count = 0;
+    while (std::getline(file, line))
+        ++count;
+    return count;
+}
+
+// the binary files read back to what the book keeps in memory
+TEST(binary_streams_round_trip) {
+    LimitOrderBook<AShare> book(test_minute);
+    book.set_features({"spread", "imbalance"});
+    book.stream_transactions("test_stream_transactions.bin", true);
+    book.stream_ticks("test_stream_ticks.bin", true);
+    generate_day(book, 20000);
+    book.run();
+    book.close_streams();
+
+    auto transactions = book.get_transactions();
+    size_t i = 0;
+    bool same = true;
+    size_t count = read_transaction_file("test_stream_transactions.bin", 2, [&](const Transaction& t) {
+        same &= i < transactions.size() && t.bid_uid == transactions[i].bid_uid && t.ask_uid == transactions[i].ask_uid &&
+                t.price == transactions[i].price && t.quantity == transactions[i].quantity && t.timestamp == transactions[i].timestamp;
+        ++i;
+    });
+    CHECK_EQ(count, transactions.size());
+    CHECK(same);
+
+    auto ticks = book.get_ticks();
+    i = 0;
+    count = read_tick_file("test_stream_ticks.bin", 2, [&](const Tick& tick) {
+        same &= i < ticks.size() && same_tick(tick, ticks[i]);
+        ++i;
+    });
+    CHECK_EQ(count, ticks.size());
+    CHECK(same);
+    CHECK_THROWS(read_tick_file("test_stream_transactions.bin", 2, [](const Tick&) {}), std::runtime_error);
+    CHECK_THROWS(read_transaction_file("test_stream_transactions.bin", 3, [](const Transaction&) {}), std::runtime_error);
+    std::remove("test_stream_transactions.bin");
+    std::remove("test_stream_ticks.bin");
+}
+
+// without `keep` only a bounded buffer stays in memory
+TEST(csv_streams_without_keep) {
+    LimitOrderBook<AShare> book(test_minute), reference(test_minute);
+    book.stream_transactions("test_stream_transactions.csv");
+    book.stream_ticks("test_stream_ticks.csv");
+    generate_day(book, 20000);
+    generate_day(reference, 20000);
+    book.run();
+    reference.run();
+    CHECK(book.get_transactions().empty());
+    CHECK(book.get_ticks().empty());
+    CHECK(book.memory_usage().streams > 0);
+    book.close_streams();
+    CHECK_EQ(book.memory_usage().streams, 0u);
+    CHECK_EQ(lines("test_stream_transactions.csv"), reference.get_transactions().size() + 1);
+    CHECK_EQ(lines("test_stream_ticks.csv"), reference.get_ticks().size() + 1);
+    std::remove("test_stream_transactions.csv");
+    std::remove("test_stream_ticks.csv");
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,37 @@
+#include <cstddef>
+#include "check.hpp"
+
+TEST(record_layout) {
+    CHECK(offsetof(Order, uid) + sizeof(uint64_t) <= 32);  // what matching reads
+    CHECK(offsetof(Limit, orders) + sizeof(OrderQueue) <= 32);
+    CHECK_EQ(alignof(Limit), 64u);
+}
+
+// the object pool of the levels hands out one cache line each
+TEST(levels_are_cache_line_aligned) {
+    MonotonicArena arena;
+    ObjectPool<Limit> pool(arena);
+    arena.allocate(8, 8);
+    for (uint64_t price = 1; price <= 100; ++price)
+        CHECK_EQ((uintptr_t)pool.create(price, Side::Ask) % 64, 0u);
+}
+
+TEST(order_queue_and_order_price) {
+    MonotonicArena arena;
+    Limit* limit = arena.create<Limit>(1234, Side::Bid);
+    Order* a = arena.create<Order>(1, 100, test_day);
+    Order* b = arena.create<Order>(2, 50, test_day);
+    limit->insert(a);
+    limit->insert(b);
+    CHECK_EQ(a->price(), 1234u);
+    CHECK_EQ(limit->quantity, 150u);
+    CHECK_EQ(limit->orders.size, 2u);
+    limit->reduce(a, 100);
+    CHECK_EQ(limit->quantity, 50u);
+    CHECK_EQ(limit->orders.pop_front(), a);  // leaves from the front only
+    CHECK_EQ(limit->orders.front(), b);
+    CHECK_EQ(limit->orders.pop_front(), b);
+    CHECK(limit->orders.empty() && !limit->orders.tail);
+}
+
+int main() { return run_tests(); }
@@ -0,0 +1,70 @@
+#include "check.hpp"
+
+const uint64_t ten = test_day + 10 * test_hour, second = 1000000000UL;
+
+TEST(sweep_of_an_aggressive_bid) {
+    LimitOrderBook<AShare> book;
+    book.write(limit_quote(1, 1000, 100, Side::Ask, ten));
+    book.write(limit_quote(2, 1001, 100, Side::Ask, ten + second));
+    book.write(limit_quote(3, 1002, 200, Side::Ask, ten + 2 * second));
+    book.write(limit_quote(4, 1002, 300, Side::Bid, ten + 10 * second));
+    const TradeDetails& details = book.get_trade_details();
+    CHECK_EQ(details.size(), 3u);
+    CHECK_EQ(details.size(), book.get_transactions().size());
+    CHECK(details.aggressor == std::vector<uint8_t>({Side::Bid, Side::Bid, Side::Bid}));
+    CHECK(details.sweep == std::vector<uint32_t>({0, 1, 2}));
+    CHECK(details.depleted == std::vector<uint8_t>({1, 1, 0}));
+    CHECK(details.queue_age == std::vector<uint64_t>({10 * second, 9 * second, 8 * second}));
+}
+
+TEST(aggressive_ask_and_queue_depletion) {
+    LimitOrderBook<AShare> book;
+    book.write(limit_quote(1, 1000, 100, Side::Bid, ten));
+    book.write(limit_quote(2, 1000, 100, Side::Bid, ten + second));
+    book.write(limit_quote(3, 999, 100, Side::Ask, ten + 3 * second));
+    book.write(limit_quote(4, 999, 100, Side::Ask, ten + 4 * second));
+    const TradeDetails& details = book.get_trade_details();
+    CHECK(details.aggressor == std::vector<uint8_t>({Side::Ask, Side::Ask}));
+    CHECK(details.sweep == std::vector<uint32_t>({0, 0}));  // each incoming order trades one level
+    CHECK(details.depleted == std::vector<uint8_t>({0, 1}));
+    CHECK(details.queue_age == std::vector<uint64_t>({3 * second, 3 * second}));
+}
+
+TEST(call_auction_has_no_aggressor) {
+    LimitOrderBook<AShare> book;
+    book.set_status(TradingStatus::CallAuction);
+    book.write(limit_quote(1, 1001, 100, Side::Bid, ten));
+    book.write(limit_quote(2, 999, 100, Side::Ask, ten + second));
+    book.match_call_auction(ten + 2 * second);
+    const TradeDetails& details = book.get_trade_details();
+    CHECK_EQ(details.size(), 1u);
+    CHECK_EQ(details.aggressor[0], TradeDetails::no_aggressor);
+    CHECK_EQ(details.depleted[0], 1u);
+    book.clear();
+    CHECK_EQ(book.get_trade_details().size(), 0u);
+}
+
+// the trade flow feature sees the same aggressors
+TEST(trade_flow_agrees_with_the_details) {
+    LimitOrderBook<AShare> book(test_minute);
+    book.set_features({"trade_flow_imbalance"});
+    generate_day(book, 20000);
+    book.run();
+    auto transactions = book.get_transactions();
+    auto ticks = book.get_ticks();
+    const TradeDetails& details = book.get_trade_details();
+    size_t t = 0, bad = 0;
+    for (auto& tick : ticks) {
+        double buy = 0, sell = 0;
+        for (; t < transactions.size() && transactions[t].timestamp <= tick.timestamp; ++t) {
+            buy += details.aggressor[t] == Side::Bid ? transactions[t].quantity : 0;
+            sell += details.aggressor[t] == Side::Ask ? transactions[t].quantity : 0;
+        }
+        double expected = buy + sell > 0 ? (buy - sell) / (buy + sell) : std::nan("");
+        bad += !(std::isnan(expected) ? std::isnan(tick.features[0]) : std::fabs(expected - tick.features[0]) < 1e-9);
+    }
+    CHECK(ticks.size() > 200);
+    CHECK_EQ(bad, 0u);
+}
+
+int main() { return run_tests(); }
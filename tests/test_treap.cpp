@@ -0,0 +1,149 @@
+#include <random>
+#include <set>
+#include "check.hpp"
+
+struct TreapFixture {
+    MonotonicArena arena;
+    ObjectPool<Node<Limit>> pool;
+    Treap<Limit> treap;
+    std::vector<Limit*> limits;  // by price
+
+    TreapFixture(size_t n)
+        : pool(arena), treap(pool) {
+        for (size_t price = 0; price < n; ++price)
+            limits.push_back(arena.create<Limit>(price, Side::Bid));
+    }
+    std::vector<uint64_t> forward() {
+        std::vector<uint64_t> prices;
+        for (auto node = treap.first; node; node = node->next())
+            prices.push_back(node->value().price);
+        return prices;
+    }
+    std::vector<uint64_t> backward() {
+        std::vector<uint64_t> prices;
+        for (auto node = treap.last; node; node = node->prev())
+            prices.push_back(node->value().price);
+        return prices;
+    }
+};
+
+TEST(neighbor_links_follow_inserts_and_removes) {
+    TreapFixture f(500);
+    std::set<uint64_t> expected;
+    std::mt19937_64 rng(7);
+    for (size_t i = 0; i < 5000; ++i) {
+        uint64_t price = rng() % 500;
+        if (expected.count(price)) {
+            f.treap.remove(*f.limits[price]);
+            expected.erase(price);
+        } else {
+            f.treap.insert(f.limits[price]);
+            expected.insert(price);
+        }
+    }
+    CHECK(f.forward() == std::vector<uint64_t>(expected.begin(), expected.end()));
+    CHECK(f.backward() == std::vector<uint64_t>(expected.rbegin(), expected.rend()));
+    CHECK_EQ(f.treap.min()->value().price, *expected.begin());
+    CHECK_EQ(f.treap.max()->value().price, *expected.rbegin());
+    for (auto node = f.treap.first; node && node->next(); node = node->next())
+        CHECK(node->next()->prev() == node);
+}
+
+TEST(links_of_a_single_node_and_an_emptied_treap) {
+    TreapFixture f(3);
+    auto node = f.treap.insert(f.limits[1]);
+    CHECK(f.treap.first == node && f.treap.last == node);
+    CHECK(!node->prev() && !node->next());
+    f.treap.remove(*f.limits[1]);
+    CHECK(f.treap.empty());
+    CHECK(!f.treap.first && !f.treap.last);
+}
+
+// sizes, search order, heap order of the priorities and parent links of the subtree, returns its size
+static size_t check_subtree(Node<Limit>* node, Node<Limit>* parent, bool& valid) {
+    if (!node)
+        return 0;
+    valid &= node->parent == parent;
+    valid &= !parent || node->priority <= parent->priority;
+    valid &= !node->left || node->left->value() < node->value();
+    valid &= !node->right || node->value() < node->right->value();
+    size_t size = 1 + check_subtree(node->left, node, valid) + check_subtree(node->right, node, valid);
+    valid &= node->size == size;
+    return size;
+}
+
+static bool valid_treap(Treap<Limit>& treap) {
+    bool valid = true;
+    check_subtree(treap.root, nullptr, valid);
+    return valid;
+}
+
+TEST(split_and_merge_keep_the_treap_valid) {
+    TreapFixture f(2000);
+    std::set<uint64_t> expected;
+    std::mt19937_64 rng(11);
+    for (size_t i = 0; i < 20000; ++i) {
+        uint64_t price = rng() % 2000;
+        if (expected.count(price)) {
+            f.treap.remove(*f.limits[price]);
+            expected.erase(price);
+        } else {
+            f.treap.insert(f.limits[price]);
+            expected.insert(price);
+        }
+        if (i % 1000 == 0)
+            CHECK(valid_treap(f.treap));
+    }
+    CHECK(valid_treap(f.treap));
+    CHECK_EQ(f.treap.size(), expected.size());
+    size_t k = 1;
+    for (uint64_t price : expected) {
+        CHECK_EQ(f.treap.kth_smallest(k)->value().price, price);
+        CHECK_EQ(f.treap.kth_largest(expected.size() - k + 1)->value().price, price);
+        ++k;
+    }
+    CHECK(!f.treap.select_by_value(Limit(2000, Side::Bid)));
+}
+
+// a level per tick inserted in price order, the worst case of a recursive descent
+TEST(sorted_inserts_stay_shallow) {
+    TreapFixture f(200000);
+    for (Limit* limit : f.limits)
+        f.treap.insert(limit);
+    CHECK(valid_treap(f.treap));
+    CHECK(f.treap.height() < 100);
+    for (Limit* limit : f.limits)
+        f.treap.remove(*limit);
+    CHECK(f.treap.empty());
+}
+
+TEST(build_from_sorted_matches_inserts) {
+    TreapFixture f(100000);
+    f.treap.insert(f.limits[5]);  // replaced by the build
+    std::vector<Limit*> values;
+    for (size_t price = 0; price < f.limits.size(); price += 3)
+        values.push_back(f.limits[price]);
+    f.treap.build_from_sorted(values);
+    CHECK(valid_treap(f.treap));
+    CHECK_EQ(f.treap.size(), values.size());
+    CHECK(f.treap.height() < 100);
+    std::vector<uint64_t> prices;
+    for (Limit* limit : values)
+        prices.push_back(limit->price);
+    CHECK(f.forward() == prices);
+    CHECK_EQ(f.treap.kth_smallest(10)->value().price, 27u);
+    CHECK(!f.treap.select_by_value(*f.limits[5]));
+
+    // the built treap keeps working with inserts and removes
+    f.treap.insert(f.limits[5]);
+    f.treap.remove(*f.limits[6]);
+    CHECK(valid_treap(f.treap));
+    CHECK_EQ(f.treap.kth_smallest(3)->value().price, 5u);
+    CHECK_EQ(f.treap.kth_smallest(4)->value().price, 9u);
+
+    f.treap.build_from_sorted({});
+    CHECK(f.treap.empty());
+    CHECK(!f.treap.first && !f.treap.last);
+}
+
+int main() { return run_tests(); }